@@ -0,0 +1,38 @@
+include(ExternalProject)
+###############################################
+# Download and compile google benchmark
+###############################################
+
+if(CMAKE_CROSSCOMPILING AND CMAKE_TOOLCHAIN_FILE)
+  get_filename_component(FULLPATH_CMAKE_TOOLCHAIN_FILE ${CMAKE_TOOLCHAIN_FILE} REALPATH)
+  set(BENCHMARK_ADDITIONAL_CMAKE_ARGS -DCMAKE_TOOLCHAIN_FILE=${FULLPATH_CMAKE_TOOLCHAIN_FILE})
+endif()
+
+ExternalProject_Add(
+  project_benchmark
+  URL https://github.com/google/benchmark/archive/refs/tags/v1.8.3.zip
+  PREFIX "${CMAKE_CURRENT_BINARY_DIR}/benchmark"
+  CMAKE_ARGS -DCMAKE_BUILD_TYPE=Release -DBENCHMARK_ENABLE_TESTING=OFF -DBENCHMARK_ENABLE_GTEST_TESTS=OFF -DBENCHMARK_ENABLE_INSTALL=OFF ${BENCHMARK_ADDITIONAL_CMAKE_ARGS}
+  INSTALL_COMMAND ""
+)
+
+ExternalProject_Get_Property(project_benchmark SOURCE_DIR)
+ExternalProject_Get_Property(project_benchmark BINARY_DIR)
+
+add_library(benchmark STATIC IMPORTED)
+
+set_property(TARGET benchmark PROPERTY IMPORTED_LOCATION "${BINARY_DIR}/src/${CMAKE_STATIC_LIBRARY_PREFIX}benchmark${CMAKE_STATIC_LIBRARY_SUFFIX}")
+# Handling multi configurations for MSVC
+foreach( CONFIG_TYPE ${CMAKE_CONFIGURATION_TYPES} )
+  string(TOUPPER ${CONFIG_TYPE} UPPER_CONFIG_TYPE)
+  set_property(TARGET benchmark PROPERTY IMPORTED_LOCATION_${UPPER_CONFIG_TYPE} "${BINARY_DIR}/src/${CONFIG_TYPE}/${CMAKE_STATIC_LIBRARY_PREFIX}benchmark${CMAKE_STATIC_LIBRARY_SUFFIX}")
+endforeach()
+
+add_dependencies(benchmark project_benchmark)
+add_definitions(-DBENCHMARK_STATIC_DEFINE)
+
+set(BENCHMARK_INCLUDE_DIR "${SOURCE_DIR}/include")
+set(BENCHMARK_LIBRARY benchmark ${CMAKE_THREAD_LIBS_INIT})
+if(WIN32)
+  set(BENCHMARK_LIBRARY ${BENCHMARK_LIBRARY} shlwapi)
+endif()
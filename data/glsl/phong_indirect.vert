@@ -0,0 +1,42 @@
+#version 430
+#extension GL_ARB_shader_draw_parameters : require
+
+/***************************************************/
+/* vertex attributes                               */
+/***************************************************/
+
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+
+/***************************************************/
+/* out variables                                   */
+/***************************************************/
+
+smooth out vec3 fragPosition;
+smooth out vec3 fragNormal;
+flat out uint fragMaterialIndex;
+
+/***************************************************/
+/* matrices                                        */
+/***************************************************/
+
+uniform mat3 normalMat;
+uniform mat4 mvMat;
+uniform mat4 mvpMat;
+
+/***************************************************/
+/* Material index of each draw of the multi draw   */
+/***************************************************/
+
+layout(std430, binding = 0) readonly buffer DrawMaterialIndices
+{
+    uint materialIndices[];
+};
+
+void main()
+{
+    fragNormal = normalize(normalMat * vertexNormal);
+    fragPosition = (mvMat * vec4(vertexPosition,1.0)).xyz;
+    fragMaterialIndex = materialIndices[gl_DrawIDARB];
+    gl_Position = mvpMat * vec4(vertexPosition,1.0);
+}
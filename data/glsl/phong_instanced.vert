@@ -0,0 +1,42 @@
+#version 330
+
+/***************************************************/
+/* vertex attributes                               */
+/***************************************************/
+
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+
+/***************************************************/
+/* instance attributes                             */
+/***************************************************/
+
+in mat4 instanceModelMat;
+in vec4 instanceColor;
+
+/***************************************************/
+/* out variables                                   */
+/***************************************************/
+
+smooth out vec3 fragPosition;
+smooth out vec3 fragNormal;
+flat out vec4 fragInstanceColor;
+
+/***************************************************/
+/* matrices                                        */
+/* The instances are only rotated and translated.  */
+/***************************************************/
+
+uniform mat3 normalMat;
+uniform mat4 modelMat;
+uniform mat4 viewMat;
+uniform mat4 projectionMat;
+
+void main()
+{
+    vec4 position = viewMat * instanceModelMat * modelMat * vec4(vertexPosition,1.0);
+    fragNormal = normalize(normalMat * mat3(instanceModelMat) * vertexNormal);
+    fragPosition = position.xyz;
+    fragInstanceColor = instanceColor;
+    gl_Position = projectionMat * position;
+}
@@ -0,0 +1,61 @@
+#ifndef GENERATED_MODEL_HPP
+#define GENERATED_MODEL_HPP
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "ObjGenerator.hpp"
+#include "ObjModel.hpp"
+
+namespace bench
+{
+
+// Model with as many vertices as faces, mixing triangles and quads.
+inline vfm::GeneratorOptions generatorOptions(std::size_t nbFaces)
+{
+    vfm::GeneratorOptions options;
+    options.nbVertices = nbFaces;
+    options.nbFaces = nbFaces;
+    options.textureCoordinates = true;
+    options.normals = true;
+    return options;
+}
+
+inline const std::string &generatedModel(std::size_t nbFaces)
+{
+    static std::size_t currentNbFaces = 0;
+    static std::string model;
+    if (currentNbFaces != nbFaces)
+    {
+        std::ostringstream obj;
+        std::ostringstream mtl;
+        vfm::generate(generatorOptions(nbFaces), obj, mtl);
+        model = obj.str();
+        currentNbFaces = nbFaces;
+    }
+    return model;
+}
+
+inline const vfm::ObjModel &parsedModel(std::size_t nbFaces)
+{
+    static std::size_t currentNbFaces = 0;
+    static vfm::ObjModel model;
+    if (currentNbFaces != nbFaces)
+    {
+        std::istringstream is(generatedModel(nbFaces));
+        model = vfm::ObjModel();
+        is >> model;
+        currentNbFaces = nbFaces;
+    }
+    return model;
+}
+
+inline void setItemsProcessed(benchmark::State &state, const char *name, std::size_t nbItems)
+{
+    state.counters[name] = benchmark::Counter(static_cast<double>(nbItems), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+}
+
+#endif // GENERATED_MODEL_HPP
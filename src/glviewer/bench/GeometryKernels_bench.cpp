@@ -0,0 +1,180 @@
+#include <benchmark/benchmark.h>
+#include <array>
+#include <vector>
+#include "glm/geometric.hpp"
+#include "GeometryKernels.hpp"
+#include "FrustumCulling.hpp"
+#include "GeneratedModel.hpp"
+
+namespace
+{
+
+const std::size_t NB_TRIANGLES = 64 * 1024;
+const std::size_t NB_BATCHES = NB_TRIANGLES / vfm::TRIANGLE_BATCH_SIZE;
+
+// The same triangles as arrays of glm vectors and as kernel batches.
+struct Triangles
+{
+    Triangles() : positions(NB_TRIANGLES), textures(NB_TRIANGLES), positionBatches(NB_BATCHES), textureBatches(NB_BATCHES)
+    {
+        float value = .0f;
+        auto next = [&value]()
+        {
+            value += 0.618034f;
+            return value - static_cast<float>(static_cast<int>(value));
+        };
+        for (std::size_t triangle = 0; triangle < NB_TRIANGLES; ++triangle)
+        {
+            std::size_t batch = triangle / vfm::TRIANGLE_BATCH_SIZE;
+            std::size_t lane = triangle % vfm::TRIANGLE_BATCH_SIZE;
+            for (int i = 0; i < 3; ++i)
+            {
+                positions[triangle][i] = glm::vec3(next(), next(), next());
+                textures[triangle][i] = glm::vec2(next(), next());
+                positionBatches[batch][i].x[lane] = positions[triangle][i].x;
+                positionBatches[batch][i].y[lane] = positions[triangle][i].y;
+                positionBatches[batch][i].z[lane] = positions[triangle][i].z;
+                textureBatches[batch][i].x[lane] = textures[triangle][i].s;
+                textureBatches[batch][i].y[lane] = textures[triangle][i].t;
+            }
+        }
+    }
+
+    std::vector<std::array<glm::vec3, 3>> positions;
+    std::vector<std::array<glm::vec2, 3>> textures;
+    std::vector<std::array<vfm::Vec3Batch, 3>> positionBatches;
+    std::vector<std::array<vfm::Vec2Batch, 3>> textureBatches;
+};
+
+const Triangles &triangles()
+{
+    static Triangles triangles;
+    return triangles;
+}
+
+bool skipUnsupported(benchmark::State &state, vfm::InstructionSet instructionSet)
+{
+    if (instructionSet > vfm::widestInstructionSet())
+    {
+        state.SkipWithError("Instruction set not supported!");
+        return true;
+    }
+    return false;
+}
+
+void FaceNormalsGlm(benchmark::State &state)
+{
+    const Triangles &t = triangles();
+    std::vector<glm::vec3> normals(NB_TRIANGLES);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < NB_TRIANGLES; ++i)
+        {
+            const std::array<glm::vec3, 3> &p = t.positions[i];
+            normals[i] = glm::normalize(glm::cross(p[1] - p[0], p[2] - p[0]));
+        }
+        benchmark::DoNotOptimize(normals.data());
+    }
+    bench::setItemsProcessed(state, "triangles", NB_TRIANGLES);
+}
+
+void FaceNormalsKernel(benchmark::State &state)
+{
+    vfm::InstructionSet instructionSet = static_cast<vfm::InstructionSet>(state.range(0));
+    if (skipUnsupported(state, instructionSet))
+    {
+        return;
+    }
+    const Triangles &t = triangles();
+    std::vector<vfm::Vec3Batch> normals(NB_BATCHES);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < NB_BATCHES; ++i)
+        {
+            vfm::computeFaceNormals(t.positionBatches[i].data(), normals[i], instructionSet);
+        }
+        benchmark::DoNotOptimize(normals.data());
+    }
+    bench::setItemsProcessed(state, "triangles", NB_TRIANGLES);
+}
+
+void TangentDirectionsGlm(benchmark::State &state)
+{
+    const Triangles &t = triangles();
+    std::vector<glm::vec3> sdirs(NB_TRIANGLES);
+    std::vector<glm::vec3> tdirs(NB_TRIANGLES);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < NB_TRIANGLES; ++i)
+        {
+            const std::array<glm::vec3, 3> &p = t.positions[i];
+            const std::array<glm::vec2, 3> &uv = t.textures[i];
+            glm::vec3 a = p[1] - p[0];
+            glm::vec3 b = p[2] - p[0];
+            glm::vec2 u = uv[1] - uv[0];
+            glm::vec2 v = uv[2] - uv[0];
+            float r = 1.0f / (u.s * v.t - v.s * u.t);
+            sdirs[i] = (v.t * a - u.t * b) * r;
+            tdirs[i] = (u.s * b - v.s * a) * r;
+        }
+        benchmark::DoNotOptimize(sdirs.data());
+        benchmark::DoNotOptimize(tdirs.data());
+    }
+    bench::setItemsProcessed(state, "triangles", NB_TRIANGLES);
+}
+
+void TangentDirectionsKernel(benchmark::State &state)
+{
+    vfm::InstructionSet instructionSet = static_cast<vfm::InstructionSet>(state.range(0));
+    if (skipUnsupported(state, instructionSet))
+    {
+        return;
+    }
+    const Triangles &t = triangles();
+    std::vector<vfm::Vec3Batch> sdirs(NB_BATCHES);
+    std::vector<vfm::Vec3Batch> tdirs(NB_BATCHES);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < NB_BATCHES; ++i)
+        {
+            vfm::computeTangentDirections(t.positionBatches[i].data(), t.textureBatches[i].data(), sdirs[i], tdirs[i], instructionSet);
+        }
+        benchmark::DoNotOptimize(sdirs.data());
+        benchmark::DoNotOptimize(tdirs.data());
+    }
+    bench::setItemsProcessed(state, "triangles", NB_TRIANGLES);
+}
+
+void CullBoundingBoxes(benchmark::State &state)
+{
+    vfm::InstructionSet instructionSet = static_cast<vfm::InstructionSet>(state.range(0));
+    if (skipUnsupported(state, instructionSet))
+    {
+        return;
+    }
+    // Unit boxes scattered around the clip space cube, a few of them inside.
+    const Triangles &t = triangles();
+    ogl::BoundingBoxArrays boxes;
+    for (std::size_t i = 0; i < NB_TRIANGLES; ++i)
+    {
+        glm::vec3 min = (t.positions[i][0] - 0.5f) * 100.0f;
+        boxes.push_back(min, min + 1.0f);
+    }
+    ogl::Frustum frustum(glm::mat4(1.0f));
+    std::vector<unsigned char> visible;
+    for (auto _ : state)
+    {
+        ogl::cullBoundingBoxes(frustum, boxes, visible, instructionSet);
+        benchmark::DoNotOptimize(visible.data());
+    }
+    bench::setItemsProcessed(state, "boxes", NB_TRIANGLES);
+}
+
+}
+
+// The kernel argument is the instruction set: 0 scalar, 1 SSE2, 2 AVX.
+BENCHMARK(FaceNormalsGlm);
+BENCHMARK(FaceNormalsKernel)->DenseRange(0, 2);
+BENCHMARK(TangentDirectionsGlm);
+BENCHMARK(TangentDirectionsKernel)->DenseRange(0, 2);
+BENCHMARK(CullBoundingBoxes)->DenseRange(0, 2);
@@ -0,0 +1,158 @@
+#include <benchmark/benchmark.h>
+#include "GlMesh.hpp"
+#include "GeneratedModel.hpp"
+
+namespace
+{
+
+ogl::VertexAttributeDeclarationVector createVertexAttributeDeclarations()
+{
+    ogl::VertexAttributeDeclarationVector vads;
+    vads.push_back(ogl::VertexAttributeDeclaration(0, 1, GL_FLOAT_VEC4, "vertexPosition"));
+    vads.push_back(ogl::VertexAttributeDeclaration(1, 1, GL_FLOAT_VEC3, "vertexNormal"));
+    vads.push_back(ogl::VertexAttributeDeclaration(2, 1, GL_FLOAT_VEC2, "vertexTextureCoord"));
+    vads.push_back(ogl::VertexAttributeDeclaration(3, 1, GL_FLOAT_VEC4, "vertexTangent"));
+    return vads;
+}
+
+vfm::ObjModel modelWithTangents(std::size_t nbFaces)
+{
+    vfm::ObjModel model = bench::parsedModel(nbFaces);
+    model.computeTangents();
+    return model;
+}
+
+// The second argument quantizes the vertex attributes.
+void FillVertexAttributes(benchmark::State &state)
+{
+    vfm::ObjModel model = modelWithTangents(static_cast<std::size_t>(state.range(0)));
+    ogl::VertexAttributeDeclarationVector vads = createVertexAttributeDeclarations();
+    ogl::GlMeshData data;
+    data.quantizedVertexAttributes = state.range(1) != 0;
+    for (auto _ : state)
+    {
+        ogl::GlMesh::fillVertexAttributes(model, vads, data);
+        benchmark::DoNotOptimize(data.vertexAttributes.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.vertexAttributes.size()));
+    bench::setItemsProcessed(state, "vertices", model.nbVertexIndices());
+}
+
+// The vertices are read in first use order of the triangles, scrambled or not by the vertex cache optimization.
+void FillVertexAttributesInFirstUseOrder(benchmark::State &state)
+{
+    vfm::ObjModel model = modelWithTangents(static_cast<std::size_t>(state.range(0)));
+    ogl::VertexAttributeDeclarationVector vads = createVertexAttributeDeclarations();
+    ogl::GlMeshData data;
+    ogl::GlMesh::fillIndices(model, data);
+    data.materialGroups.push_back(ogl::MaterialGroup(ogl::MaterialHandler::NO_MATERIAL_INDEX, model.nbTriangleVertices()));
+    if (state.range(1) != 0)
+    {
+        ogl::GlMesh::optimizeVertexCache(data);
+    }
+    std::vector<GLuint> vertexOrder = ogl::GlMesh::optimizeVertexFetch(data, model.nbVertexIndices());
+    for (auto _ : state)
+    {
+        ogl::GlMesh::fillVertexAttributes(model, vads, data, &vertexOrder);
+        benchmark::DoNotOptimize(data.vertexAttributes.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.vertexAttributes.size()));
+    bench::setItemsProcessed(state, "vertices", vertexOrder.size());
+}
+
+void FillIndices(benchmark::State &state)
+{
+    const vfm::ObjModel &model = bench::parsedModel(static_cast<std::size_t>(state.range(0)));
+    ogl::GlMeshData data;
+    for (auto _ : state)
+    {
+        ogl::GlMesh::fillIndices(model, data);
+        benchmark::DoNotOptimize(data.indices.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.indices.size()));
+    bench::setItemsProcessed(state, "faces", model.nbTriangleVertices() / 3);
+}
+
+// The second argument is a mask of the optimizations: 1 vertex cache, 2 vertex fetch.
+void Prepare(benchmark::State &state)
+{
+    vfm::ObjModel model = modelWithTangents(static_cast<std::size_t>(state.range(0)));
+    ogl::VertexAttributeDeclarationVector vads = createVertexAttributeDeclarations();
+    ogl::GlMeshOptions options;
+    options.optimizeVertexCache = (state.range(1) & 1) != 0;
+    options.optimizeVertexFetch = (state.range(1) & 2) != 0;
+    ogl::GlMeshData data;
+    for (auto _ : state)
+    {
+        if (!ogl::GlMesh::prepare(model, vads, data, options))
+        {
+            state.SkipWithError("Cannot prepare generated model!");
+            break;
+        }
+        benchmark::DoNotOptimize(data.vertexAttributes.data());
+    }
+    bench::setItemsProcessed(state, "vertices", model.nbVertexIndices());
+    bench::setItemsProcessed(state, "faces", model.nbTriangleVertices() / 3);
+}
+
+void OptimizeVertexCache(benchmark::State &state)
+{
+    const vfm::ObjModel &model = bench::parsedModel(static_cast<std::size_t>(state.range(0)));
+    ogl::GlMeshData data;
+    ogl::GlMesh::fillIndices(model, data);
+    data.materialGroups.push_back(ogl::MaterialGroup(ogl::MaterialHandler::NO_MATERIAL_INDEX, model.nbTriangleVertices()));
+    std::vector<GLubyte> indices = data.indices;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        data.indices = indices;
+        state.ResumeTiming();
+        ogl::GlMeshGeneration optimization = ogl::GlMesh::optimizeVertexCache(data);
+        state.SetLabel(optimization.message());
+        benchmark::DoNotOptimize(data.indices.data());
+    }
+    bench::setItemsProcessed(state, "faces", model.nbTriangleVertices() / 3);
+}
+
+void BuildMeshlets(benchmark::State &state)
+{
+    const vfm::ObjModel &model = bench::parsedModel(static_cast<std::size_t>(state.range(0)));
+    ogl::GlMeshData data;
+    ogl::GlMesh::fillIndices(model, data);
+    data.materialGroups.push_back(ogl::MaterialGroup(ogl::MaterialHandler::NO_MATERIAL_INDEX, model.nbTriangleVertices()));
+    for (auto _ : state)
+    {
+        ogl::GlMeshGeneration building = ogl::GlMesh::buildMeshlets(model, data);
+        state.SetLabel(building.message());
+        benchmark::DoNotOptimize(data.indices.data());
+    }
+    bench::setItemsProcessed(state, "faces", model.nbTriangleVertices() / 3);
+}
+
+void CullMeshlets(benchmark::State &state)
+{
+    const vfm::ObjModel &model = bench::parsedModel(static_cast<std::size_t>(state.range(0)));
+    ogl::GlMeshData data;
+    ogl::GlMesh::fillIndices(model, data);
+    data.materialGroups.push_back(ogl::MaterialGroup(ogl::MaterialHandler::NO_MATERIAL_INDEX, model.nbTriangleVertices()));
+    ogl::GlMesh::buildMeshlets(model, data);
+    ogl::PerspectiveCamera camera;
+    glm::mat4 modelView(1.0f);
+    modelView[3] = glm::vec4(.0f, .0f, -2.0f, 1.0f);
+    for (auto _ : state)
+    {
+        ogl::DrawCallVector drawCalls = ogl::GlMesh::cullMeshlets(data.meshlets, data.materialGroups, camera, modelView);
+        benchmark::DoNotOptimize(drawCalls.data());
+    }
+    bench::setItemsProcessed(state, "meshlets", data.meshlets.size());
+}
+
+}
+
+BENCHMARK(FillVertexAttributes)->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {0, 1}});
+BENCHMARK(FillVertexAttributesInFirstUseOrder)->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {0, 1}});
+BENCHMARK(FillIndices)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+BENCHMARK(OptimizeVertexCache)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK(BuildMeshlets)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK(CullMeshlets)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+BENCHMARK(Prepare)->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {0, 1, 2, 3}})->Unit(benchmark::kMillisecond);
@@ -0,0 +1,172 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "ObjModel.hpp"
+#include "VertexIndexIndexer.hpp"
+#include "GeneratedModel.hpp"
+
+namespace
+{
+
+const char *MODEL_FILENAME = "bench_glviewer.obj";
+
+// The generated model written in a file, removed at exit.
+class ModelFile
+{
+public:
+    ~ModelFile()
+    {
+        if (_nbFaces != 0)
+        {
+            std::remove(MODEL_FILENAME);
+        }
+    }
+
+    const char *write(std::size_t nbFaces)
+    {
+        if (_nbFaces != nbFaces)
+        {
+            std::ofstream ofs(MODEL_FILENAME, std::ios::binary);
+            ofs << bench::generatedModel(nbFaces);
+            _nbFaces = nbFaces;
+        }
+        return MODEL_FILENAME;
+    }
+
+private:
+    std::size_t _nbFaces = 0;
+};
+
+ModelFile modelFile;
+
+void ObjParsingStream(benchmark::State &state)
+{
+    std::size_t nbFaces = static_cast<std::size_t>(state.range(0));
+    const std::string &content = bench::generatedModel(nbFaces);
+    for (auto _ : state)
+    {
+        std::istringstream is(content);
+        vfm::ObjModel model;
+        is >> model;
+        benchmark::DoNotOptimize(model.objects.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * content.size()));
+    bench::setItemsProcessed(state, "vertices", nbFaces);
+    bench::setItemsProcessed(state, "faces", nbFaces);
+}
+
+void ObjParsingFile(benchmark::State &state)
+{
+    std::size_t nbFaces = static_cast<std::size_t>(state.range(0));
+    const char *filename = modelFile.write(nbFaces);
+    vfm::LoadOptions options;
+    options.nbThreads = static_cast<unsigned int>(state.range(1));
+    for (auto _ : state)
+    {
+        vfm::ObjModel model;
+        if (!vfm::load(filename, model, options))
+        {
+            state.SkipWithError("Cannot load generated model!");
+            break;
+        }
+        benchmark::DoNotOptimize(model.objects.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bench::generatedModel(nbFaces).size()));
+    bench::setItemsProcessed(state, "vertices", nbFaces);
+    bench::setItemsProcessed(state, "faces", nbFaces);
+}
+
+void VertexIndexIndexing(benchmark::State &state)
+{
+    const vfm::Object &source = bench::parsedModel(static_cast<std::size_t>(state.range(0))).objects.front();
+    for (auto _ : state)
+    {
+        vfm::Object object;
+        vfm::VertexIndexIndexer indexer(&object, std::pmr::get_default_resource());
+        vfm::Index sum = 0;
+        for (vfm::Index index : source.triangles)
+        {
+            sum += indexer[source.vertexIndices[index]];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    bench::setItemsProcessed(state, "vertices", source.triangles.size());
+}
+
+void CreateTriangles(benchmark::State &state)
+{
+    std::size_t nbFaces = static_cast<std::size_t>(state.range(0));
+    vfm::IndexVector quads(4 * nbFaces);
+    for (std::size_t i = 0; i < quads.size(); ++i)
+    {
+        quads[i] = static_cast<vfm::Index>(i);
+    }
+    vfm::IndexVector triangles;
+    for (auto _ : state)
+    {
+        triangles.clear();
+        for (std::size_t i = 0; i < quads.size(); i += 4)
+        {
+            vfm::createTriangles(&quads[i], 4, triangles);
+        }
+        benchmark::DoNotOptimize(triangles.data());
+    }
+    bench::setItemsProcessed(state, "faces", nbFaces);
+}
+
+void ComputeNormals(benchmark::State &state)
+{
+    vfm::ObjModel model = bench::parsedModel(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        model.computeNormals(true, static_cast<unsigned int>(state.range(1)));
+        benchmark::DoNotOptimize(model.normals.data());
+    }
+    bench::setItemsProcessed(state, "vertices", model.positions.size());
+    bench::setItemsProcessed(state, "faces", model.nbTriangleVertices() / 3);
+}
+
+void ComputeTangents(benchmark::State &state)
+{
+    vfm::ObjModel model = bench::parsedModel(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        model.computeTangents(static_cast<unsigned int>(state.range(1)));
+        benchmark::DoNotOptimize(model.tangents.data());
+    }
+    bench::setItemsProcessed(state, "vertices", model.normals.size());
+    bench::setItemsProcessed(state, "faces", model.nbTriangleVertices() / 3);
+}
+
+void MtlParsing(benchmark::State &state)
+{
+    std::ostringstream os;
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        os << "newmtl material" << i << "\n"
+              "Ns 96.078431\nKa 1.000000 1.000000 1.000000\nKd 0.640000 0.640000 0.640000\n"
+              "Ks 0.500000 0.500000 0.500000\nKe 0.000000 0.000000 0.000000\nNi 1.000000\nd 1.000000\nillum 2\n"
+              "map_Kd textures/diffuse" << i << ".png\nmap_Bump textures/normal" << i << ".png\n\n";
+    }
+    std::string content = os.str();
+    for (auto _ : state)
+    {
+        std::istringstream is(content);
+        vfm::MaterialMap materialMap;
+        is >> materialMap;
+        benchmark::DoNotOptimize(materialMap.size());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * content.size()));
+}
+
+}
+
+BENCHMARK(ObjParsingStream)->RangeMultiplier(16)->Range(1 << 10, 1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK(ObjParsingFile)->Args({1 << 18, 1})->Args({1 << 18, 0})->Unit(benchmark::kMillisecond);
+BENCHMARK(VertexIndexIndexing)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+BENCHMARK(CreateTriangles)->RangeMultiplier(16)->Range(1 << 10, 1 << 18);
+BENCHMARK(ComputeNormals)->ArgsProduct({{1 << 10, 1 << 14, 1 << 18, 1 << 20}, {1, 0}});
+BENCHMARK(ComputeTangents)->ArgsProduct({{1 << 10, 1 << 14, 1 << 18, 1 << 20}, {1, 0}});
+BENCHMARK(MtlParsing)->Arg(1000);
@@ -0,0 +1,62 @@
+#ifndef FRUSTUM_CULLING_HPP
+#define FRUSTUM_CULLING_HPP
+
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "GeometryKernels.hpp"
+
+namespace ogl
+{
+
+// Planes of the view frustum extracted from a projection matrix, or a model
+// view projection matrix for planes in model space. The planes are
+// normalized and points inside the frustum are at positive distances.
+class Frustum
+{
+public:
+    static const std::size_t NB_PLANES = 6;
+    static const std::size_t NEAR_PLANE = 4;
+
+    explicit Frustum(const glm::mat4 &matrix);
+
+    inline const glm::vec4 &plane(std::size_t i) const
+    {
+        return _planes[i];
+    }
+
+    bool intersectsSphere(const glm::vec3 &center, float radius) const;
+    bool intersectsBox(const glm::vec3 &min, const glm::vec3 &max) const;
+    // True when a corner of the box is behind the near plane: the box faces
+    // may then be clipped and its rasterization tells nothing.
+    bool crossesNearPlane(const glm::vec3 &min, const glm::vec3 &max) const;
+
+private:
+    glm::vec4 _planes[NB_PLANES];
+};
+
+// Axis aligned boxes in structure of arrays for the SIMD frustum test.
+struct BoundingBoxArrays
+{
+    void clear();
+    void push_back(const glm::vec3 &min, const glm::vec3 &max);
+
+    inline std::size_t size() const
+    {
+        return minX.size();
+    }
+
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+};
+
+// Sets visible[i] to 1 when box i intersects the frustum, to 0 otherwise.
+// The boxes are tested 4 or 8 at a time with SSE2 or AVX. Boxes outside
+// may be kept when they are near the frustum corners.
+void cullBoundingBoxes(const Frustum &frustum, const BoundingBoxArrays &boxes, std::vector<unsigned char> &visible,
+                       vfm::InstructionSet instructionSet = vfm::widestInstructionSet());
+
+}
+
+#endif // FRUSTUM_CULLING_HPP
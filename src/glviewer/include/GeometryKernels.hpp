@@ -0,0 +1,60 @@
+#ifndef GEOMETRY_KERNELS_HPP
+#define GEOMETRY_KERNELS_HPP
+
+#include <cstddef>
+
+namespace vfm
+{
+
+const std::size_t TRIANGLE_BATCH_SIZE = 8;
+
+// Structures of arrays of TRIANGLE_BATCH_SIZE vectors processed together by the kernels.
+struct Vec2Batch
+{
+    float x[TRIANGLE_BATCH_SIZE];
+    float y[TRIANGLE_BATCH_SIZE];
+};
+
+struct Vec3Batch
+{
+    float x[TRIANGLE_BATCH_SIZE];
+    float y[TRIANGLE_BATCH_SIZE];
+    float z[TRIANGLE_BATCH_SIZE];
+};
+
+struct Vec4Batch
+{
+    float x[TRIANGLE_BATCH_SIZE];
+    float y[TRIANGLE_BATCH_SIZE];
+    float z[TRIANGLE_BATCH_SIZE];
+    float w[TRIANGLE_BATCH_SIZE];
+};
+
+// From the narrowest to the widest.
+enum class InstructionSet
+{
+    SCALAR,
+    SSE2,
+    AVX
+};
+
+// The widest instruction set supported by both the build and the CPU.
+InstructionSet widestInstructionSet();
+
+// Unit normals of the triangles (p0, p1, p2).
+void computeFaceNormals(const Vec3Batch positions[3], Vec3Batch &normals,
+                        InstructionSet instructionSet = widestInstructionSet());
+
+// Directions of the texture s and t axes in the triangles (p0, p1, p2),
+// scaled by the inverse of the texture area.
+void computeTangentDirections(const Vec3Batch positions[3], const Vec2Batch textures[3], Vec3Batch &sdir, Vec3Batch &tdir,
+                              InstructionSet instructionSet = widestInstructionSet());
+
+// Gram-Schmidt orthogonalisation of sdir against the normals, with the
+// handedness of the (normal, sdir, tdir) basis in w.
+void orthogonalizeTangents(const Vec3Batch &normals, const Vec3Batch &sdir, const Vec3Batch &tdir, Vec4Batch &tangents,
+                           InstructionSet instructionSet = widestInstructionSet());
+
+}
+
+#endif // GEOMETRY_KERNELS_HPP
@@ -4,7 +4,12 @@
 #include <vector>
 #include "gl.hpp"
 #include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
 #include "OperationResult.hpp"
+#include "Camera.hpp"
+#include "MeshletBuilder.hpp"
+#include "FrustumCulling.hpp"
+#include "OcclusionCulling.hpp"
 #include "ObjModel.hpp"
 #include "UniformDeclaration.hpp"
 
@@ -23,6 +28,11 @@ public:
 
     void accept(float x, float y, float z);
 
+    inline bool empty() const
+    {
+        return min.x > max.x;
+    }
+
     inline glm::vec3 center() const
     {
         return (min + max) * 0.5f;
@@ -60,6 +70,143 @@ public:
     virtual void use(MaterialIndex index) = 0;
 };
 
+struct MaterialGroup
+{
+    MaterialGroup(MaterialIndex index, std::size_t size);
+
+    MaterialIndex index;
+    std::size_t size;
+    // Bounding box of the positions of the triangles, used for the frustum culling.
+    BoundingBox boundingBox;
+};
+
+using MaterialGroupVector = std::vector<MaterialGroup>;
+
+struct DrawCall
+{
+    MaterialIndex materialIndex;
+    std::size_t firstIndex;
+    std::size_t nbIndices;
+};
+
+using DrawCallVector = std::vector<DrawCall>;
+
+// Layout read by glMultiDrawElementsIndirect in the GL_DRAW_INDIRECT_BUFFER.
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+using DrawElementsIndirectCommandVector = std::vector<DrawElementsIndirectCommand>;
+
+// Shader storage buffer binding of the material index of each multi draw,
+// read as materialIndices[gl_DrawIDARB].
+const GLuint DRAW_MATERIAL_INDICES_BINDING = 0;
+
+// Simplified triangles stored after the full detail ones in the index buffer.
+struct LevelOfDetail
+{
+    LevelOfDetail() : error(.0f), firstIndex(0) {}
+
+    // Bound of the distance to the full detail, relative to the bounding
+    // box diagonal.
+    float error;
+    std::size_t firstIndex;
+    MaterialGroupVector materialGroups;
+};
+
+using LevelOfDetailVector = std::vector<LevelOfDetail>;
+
+// Interleaved vertex attributes and packed indices, ready to be sent to OpenGL.
+struct GlMeshData
+{
+    GlMeshData() : indexFormat{GL_UNSIGNED_SHORT}, quantizedVertexAttributes{false} {}
+
+    GLenum indexFormat;
+    // Floats, or the quantized formats when quantizedVertexAttributes is set.
+    bool quantizedVertexAttributes;
+    std::vector<GLubyte> vertexAttributes;
+    std::vector<GLubyte> indices;
+    MaterialGroupVector materialGroups;
+    LevelOfDetailVector levelsOfDetail;
+    // Meshlets of the full detail material groups, in index order.
+    MeshletVector meshlets;
+    BoundingBox boundingBox;
+};
+
+// Material groups drawn and skipped by the frustum culling in a render.
+// The occluded groups are drawn conditionally on their occlusion query. A
+// multi draw counts as one draw call.
+struct RenderStatistics
+{
+    RenderStatistics() : nbDrawnMaterialGroups(0), nbCulledMaterialGroups(0), nbOccludedMaterialGroups(0), nbOcclusionQueries(0), nbDrawCalls(0) {}
+
+    std::size_t nbDrawnMaterialGroups;
+    std::size_t nbCulledMaterialGroups;
+    std::size_t nbOccludedMaterialGroups;
+    std::size_t nbOcclusionQueries;
+    std::size_t nbDrawCalls;
+};
+
+struct GlMeshOptions
+{
+    GlMeshOptions() : nbThreads(1), optimizeVertexCache(false), optimizeVertexFetch(false), buildMeshlets(false), quantizeVertexAttributes(false) {}
+
+    // Threads computing missing normals and tangents, 0 for all available cores.
+    unsigned int nbThreads;
+    // Reorders the triangles of each material group for the post-transform vertex cache.
+    bool optimizeVertexCache;
+    // Orders the vertex attributes by first use in the indices.
+    bool optimizeVertexFetch;
+    // Ratios of the triangles kept by the simplified levels of detail, from the finest.
+    std::vector<float> levelsOfDetail;
+    // Splits the full detail triangles into meshlets culled on the CPU.
+    bool buildMeshlets;
+    // Stores the positions as 16 bits in the bounding box, the normals and
+    // tangents as 10 bits and the texture coordinates as half floats.
+    bool quantizeVertexAttributes;
+};
+
+// Model matrices and optional colors of the instances drawn by
+// GlMesh::renderInstanced, read by the vertex shader as the instanceModelMat
+// and instanceColor attributes. The matrices apply to the model space, after
+// the dequantization.
+class InstanceBuffer
+{
+public:
+    InstanceBuffer();
+    ~InstanceBuffer();
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator = (const InstanceBuffer&) = delete;
+
+    // Without colors, or with one color by model matrix.
+    GlMeshGeneration upload(const std::vector<glm::mat4> &modelMatrices, const std::vector<glm::vec4> &colors = std::vector<glm::vec4>());
+
+    inline std::size_t size() const
+    {
+        return _nbInstances;
+    }
+
+    inline bool hasColors() const
+    {
+        return _hasColors;
+    }
+
+    inline GLuint buffer() const
+    {
+        return _buffer;
+    }
+
+private:
+    GLuint _buffer;
+    std::size_t _nbInstances;
+    bool _hasColors;
+};
+
 class GlMesh
 {
 public:
@@ -68,35 +215,128 @@ public:
     GlMesh(const GlMesh&) = delete;
     GlMesh& operator = (const GlMesh&) = delete;
 
-    GlMeshGeneration generate(vfm::ObjModel &objModel, const VertexAttributeDeclarationVector &vads);
+    // Same as prepare followed by upload.
+    GlMeshGeneration generate(vfm::ObjModel &objModel, const VertexAttributeDeclarationVector &vads, const GlMeshOptions &options = GlMeshOptions());
 
-    void render(MaterialHandler *handler = 0);
+    // CPU side of the generation: does not use OpenGL. Missing normals and
+    // tangents are computed.
+    static GlMeshGeneration prepare(vfm::ObjModel &objModel, const VertexAttributeDeclarationVector &vads, GlMeshData &data, const GlMeshOptions &options = GlMeshOptions());
 
-    inline const BoundingBox &getBoundingBox() const
+    // Stages of prepare: the model must provide all the declared vertex
+    // attributes, which are quantized when data.quantizedVertexAttributes is
+    // set. The vertex order gives the model vertex index of each vertex, all
+    // of them in model order when it is null.
+    static void fillVertexAttributes(const vfm::ObjModel &objModel, const VertexAttributeDeclarationVector &vads, GlMeshData &data,
+                                     const std::vector<GLuint> *vertexOrder = nullptr);
+    static void fillIndices(const vfm::ObjModel &objModel, GlMeshData &data);
+
+    // Reorders the triangles inside each material group, or each meshlet of
+    // the full detail, the message gives the ACMR before and after.
+    static GlMeshGeneration optimizeVertexCache(GlMeshData &data);
+
+    // Renumbers the vertices in order of first use by the indices, before
+    // the vertex attributes are filled. Returns the vertex order.
+    static std::vector<GLuint> optimizeVertexFetch(GlMeshData &data, std::size_t nbVertices);
+
+    // Appends the levels of detail simplified from the material groups, which
+    // keep their boundaries as the UV seams and normal creases. The indices
+    // must be in model vertex order, before the vertex fetch optimization.
+    static GlMeshGeneration generateLevelsOfDetail(const vfm::ObjModel &objModel, const std::vector<float> &ratios, GlMeshData &data);
+
+    // Reorders the full detail triangles of each material group into meshlets.
+    // The indices must be in model vertex order.
+    static GlMeshGeneration buildMeshlets(const vfm::ObjModel &objModel, GlMeshData &data);
+
+    // Draw calls of the visible meshlets, consecutive ones being merged.
+    static DrawCallVector cullMeshlets(const MeshletVector &meshlets, const MaterialGroupVector &materialGroups,
+                                       const PerspectiveCamera &camera, const glm::mat4 &modelViewMatrix);
+
+    // Selects the meshlets drawn by render at full detail.
+    void cullMeshlets(const PerspectiveCamera &camera, const glm::mat4 &modelViewMatrix);
+
+    // Selects the material groups drawn by render, the ones whose bounding
+    // box intersects the view frustum. The levels of detail use the bounding
+    // boxes of the full detail groups.
+    void cullMaterialGroups(const glm::mat4 &modelViewProjectionMatrix);
+
+    // Occlusion culling of the material groups, null to disable it. The
+    // groups hidden in the last query results are drawn after the others,
+    // conditionally on a query of their bounding box against the depth of
+    // the others. Not used for the meshlets.
+    void setOcclusionCulling(OcclusionCulling *occlusionCulling);
+
+    // Commands of the draw calls and material index of each one.
+    static void fillDrawCommands(const DrawCallVector &drawCalls, DrawElementsIndirectCommandVector &commands, std::vector<GLuint> &materialIndices);
+
+    // Submits the draw calls of render with a single glMultiDrawElementsIndirect,
+    // the material handler being unused: the shader reads the material index
+    // at DRAW_MATERIAL_INDICES_BINDING. The occluded groups are still drawn
+    // one by one, conditionally on their query. Returns false when the
+    // context lacks the multi draw indirect, draw parameters or shader
+    // storage extensions.
+    bool setMultiDrawIndirect(bool multiDrawIndirect);
+
+    // The coarsest level of detail whose error projected with the size of
+    // the bounding box is below one pixel, 0 being the full detail.
+    static std::size_t selectLevelOfDetail(const LevelOfDetailVector &levelsOfDetail, const BoundingBox &boundingBox,
+                                           const PerspectiveCamera &camera, const glm::mat4 &modelViewMatrix);
+
+    // Selects the level of detail drawn by render.
+    void selectLevelOfDetail(const PerspectiveCamera &camera, const glm::mat4 &modelViewMatrix);
+
+    inline std::size_t levelOfDetail() const
     {
-        return _boundingBox;
+        return _levelOfDetail;
     }
 
-private:
-    struct MaterialGroup
-    {
-        MaterialGroup(MaterialIndex index, std::size_t size);
+    GlMeshGeneration upload(const GlMeshData &data, const VertexAttributeDeclarationVector &vads);
 
-        MaterialIndex index;
-        std::size_t size;
-    };
+    RenderStatistics render(MaterialHandler *handler = 0);
 
-    using MaterialGroupVector = std::vector<MaterialGroup>;
+    // Draws the material groups of the selected level of detail once per
+    // instance, without culling. The instance attributes missing in the
+    // shader are ignored, render setting them to the identity and white.
+    RenderStatistics renderInstanced(const InstanceBuffer &instances, MaterialHandler *handler = 0);
 
+    inline const BoundingBox &getBoundingBox() const
+    {
+        return _boundingBox;
+    }
+
+    // Maps the quantized positions to the bounding box, to be applied after
+    // the model matrix. The identity when the positions are floats.
+    glm::mat4 dequantizationMatrix() const;
+
+private:
     void clear();
-    void createMaterialGroups(const vfm::ObjModel &objModel);
-    void createIndexBufferData(const vfm::ObjModel &objModel);
+    void readOcclusionQueries();
+    void releaseOcclusionQueries();
+    void submitDrawCalls(const DrawCallVector &drawCalls, MaterialHandler *handler, RenderStatistics &statistics);
+    void beginRender();
 
     GLuint _vertexArray;
     GLenum _indexFormat;
     std::vector<GLuint> _buffers;
-    std::vector<GLuint> _definedVertexAttributes;
+    // Locations of the instance attributes, -1 when not in the shader.
+    GLint _instanceModelMatrixIndex;
+    GLint _instanceColorIndex;
     MaterialGroupVector _materialGroups;
+    LevelOfDetailVector _levelsOfDetail;
+    std::size_t _levelOfDetail;
+    MeshletVector _meshlets;
+    DrawCallVector _drawCalls;
+    BoundingBoxArrays _materialGroupBoundingBoxes;
+    std::vector<unsigned char> _visibleMaterialGroups;
+    glm::mat4 _modelViewProjectionMatrix;
+    OcclusionCulling *_occlusionCulling;
+    // Pending query of each material group, 0 when none.
+    std::vector<GLuint> _occlusionQueries;
+    std::vector<unsigned char> _occludedMaterialGroups;
+    bool _multiDrawIndirect;
+    DrawCallVector _submittedDrawCalls;
+    DrawElementsIndirectCommandVector _drawCommands;
+    std::vector<GLuint> _drawMaterialIndices;
+    bool _quantizedVertexAttributes;
     BoundingBox _boundingBox;
 };
 
@@ -0,0 +1,26 @@
+#ifndef GLMESH_CACHE_HPP
+#define GLMESH_CACHE_HPP
+
+#include <string>
+#include "GlMesh.hpp"
+
+namespace ogl
+{
+
+using GlMeshCaching = sys::OperationResult;
+
+// Prepared GlMeshData of an OBJ file, with its material ids, for a given
+// vertex attribute layout and the mesh options used to prepare it. The
+// size and the modification time of the source OBJ file are stored to
+// detect outdated caches.
+std::string meshCacheFilename(const char *objFilename, const VertexAttributeDeclarationVector &vads, const GlMeshOptions &options);
+
+GlMeshCaching saveMeshCache(const char *cacheFilename, const char *sourceFilename, const VertexAttributeDeclarationVector &vads,
+                            const GlMeshOptions &options, const GlMeshData &data, const vfm::MaterialIdVector &materialIds);
+
+GlMeshGeneration loadMeshCache(const char *cacheFilename, const char *sourceFilename, const VertexAttributeDeclarationVector &vads,
+                               const GlMeshOptions &options, GlMeshData &data, vfm::MaterialIdVector &materialIds);
+
+}
+
+#endif // GLMESH_CACHE_HPP
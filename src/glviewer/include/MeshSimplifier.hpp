@@ -0,0 +1,23 @@
+#ifndef MESH_SIMPLIFIER_HPP
+#define MESH_SIMPLIFIER_HPP
+
+#include <vector>
+#include "glm/vec3.hpp"
+#include "gl.hpp"
+
+namespace ogl
+{
+
+// Quadric error metric simplification of the triangles by half-edge
+// collapses: a vertex is merged into one of its neighbours, so that the
+// remaining vertices keep their attributes. Locked vertices and the
+// vertices of open or non-manifold edges are never removed.
+// Returns the simplified triangles, which have at most targetNbIndices
+// indices when enough vertices can be removed, and sets error to the
+// largest distance between a removed vertex and the planes of its triangles.
+std::vector<GLuint> simplify(const GLuint *indices, std::size_t nbIndices, std::size_t targetNbIndices,
+                             const std::vector<glm::vec3> &positions, const std::vector<bool> &locked, float &error);
+
+}
+
+#endif // MESH_SIMPLIFIER_HPP
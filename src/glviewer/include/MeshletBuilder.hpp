@@ -0,0 +1,83 @@
+#ifndef MESHLET_BUILDER_HPP
+#define MESHLET_BUILDER_HPP
+
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "gl.hpp"
+#include "FrustumCulling.hpp"
+
+namespace ogl
+{
+
+const std::size_t MAX_MESHLET_VERTICES = 64;
+const std::size_t MAX_MESHLET_TRIANGLES = 124;
+
+// Contiguous range of triangles in the index buffer, with the bounds used
+// to skip it on the CPU: a bounding sphere and a cone containing the
+// normals of its triangles.
+struct Meshlet
+{
+    Meshlet() : firstIndex(0), nbIndices(0), center(.0f), radius(.0f), coneAxis(.0f, .0f, 1.0f), coneCutoff(1.0f) {}
+
+    std::size_t firstIndex;
+    std::size_t nbIndices;
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneAxis;
+    // Sine of the cone half angle, 1 when the triangles may face any direction.
+    float coneCutoff;
+};
+
+using MeshletVector = std::vector<Meshlet>;
+
+// Splits index ranges into meshlets of at most MAX_MESHLET_VERTICES vertices
+// and MAX_MESHLET_TRIANGLES triangles. A meshlet grows from adjacent
+// triangles, preferring the ones adding the fewest vertices and facing the
+// same way. The working buffers are kept to split many ranges in a row.
+class MeshletBuilder
+{
+public:
+    // Reorders the triangles of the range by meshlet and appends the
+    // meshlets, firstIndex being the position of the range in the index buffer.
+    void build(GLuint *indices, std::size_t nbIndices, std::size_t firstIndex, const std::vector<glm::vec3> &positions, MeshletVector &meshlets);
+
+private:
+    void addTriangle(std::size_t triangle);
+    Meshlet finishMeshlet(const std::vector<glm::vec3> &positions);
+
+    std::vector<GLuint> _localVertices;
+    std::vector<GLuint> _globalVertices;
+    std::vector<GLuint> _triangles;
+    std::vector<glm::vec3> _triangleNormals;
+    std::vector<std::size_t> _firstAdjacentTriangles;
+    std::vector<GLuint> _adjacentTriangles;
+    std::vector<bool> _emitted;
+    std::vector<bool> _inMeshlet;
+    std::vector<GLuint> _meshletVertices;
+    std::vector<GLuint> _meshletTriangles;
+    std::vector<GLuint> _candidates;
+    glm::vec3 _meshletNormal;
+    std::vector<GLuint> _output;
+};
+
+// Meshlet visibility with a perspective projection: a meshlet is culled
+// when its sphere is outside the view frustum or when all its triangles
+// face away from the camera. The model view matrix must not have a
+// non-uniform scale.
+class MeshletCulling
+{
+public:
+    MeshletCulling(const glm::mat4 &projectionMatrix, const glm::mat4 &modelViewMatrix);
+
+    bool isVisible(const Meshlet &meshlet) const;
+
+private:
+    glm::mat4 _modelViewMatrix;
+    float _scale;
+    Frustum _frustum;
+};
+
+}
+
+#endif // MESHLET_BUILDER_HPP
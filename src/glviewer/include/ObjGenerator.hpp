@@ -0,0 +1,43 @@
+#ifndef OBJ_GENERATOR_HPP
+#define OBJ_GENERATOR_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "OperationResult.hpp"
+
+namespace vfm
+{
+
+using ObjGeneration = sys::OperationResult;
+
+struct GeneratorOptions
+{
+    GeneratorOptions() : seed(1), nbVertices(1024), nbFaces(1024), maxPolygonSize(4), nbObjects(1), nbMaterials(0), nbMaterialSwitches(0),
+        negativeIndices(false), textureCoordinates(false), normals(false), textureMaps(false), materialLibrary("generated.mtl") {}
+
+    std::uint64_t seed;
+    // Vertices are laid out on a bumpy grid: faces are polygons between two grid rows.
+    std::size_t nbVertices;
+    std::size_t nbFaces;
+    // Face sizes are picked uniformly between 3 and maxPolygonSize.
+    unsigned int maxPolygonSize;
+    std::size_t nbObjects;
+    std::size_t nbMaterials;
+    // Number of usemtl statements spread over the faces.
+    std::size_t nbMaterialSwitches;
+    bool negativeIndices;
+    bool textureCoordinates;
+    bool normals;
+    // Adds diffuse and bump texture references to the materials.
+    bool textureMaps;
+    std::string materialLibrary;
+};
+
+// Writes a pseudo random model which only depends on the options, seed included.
+// The material library is written only if materials are requested.
+ObjGeneration generate(const GeneratorOptions &options, std::ostream &obj, std::ostream &mtl);
+
+}
+
+#endif // OBJ_GENERATOR_HPP
@@ -1,6 +1,7 @@
 #ifndef OBJMODEL_HPP
 #define OBJMODEL_HPP
 
+#include <cstdint>
 #include <vector>
 #include <fstream>
 #include <string>
@@ -8,11 +9,13 @@
 
 #include "glm/vec4.hpp"
 #include "glm/vec3.hpp"
+#include "OperationResult.hpp"
 
 namespace vfm
 {
 
 typedef std::size_t MaterialIndex;
+typedef std::uint32_t Index;
 typedef std::vector<glm::vec4> Vec4Vector;
 typedef std::vector<glm::vec3> Vec3Vector;
 
@@ -48,13 +51,25 @@ typedef std::map<std::string, Material> MaterialMap;
 
 struct VertexIndex
 {
-    VertexIndex (std::size_t position = 0, std::size_t normal = 0, std::size_t texture = 0);
+    VertexIndex (Index position = 0, Index normal = 0, Index texture = 0);
 
     bool operator == (const VertexIndex &vi) const;
 
-    std::size_t position;
-    std::size_t normal;
-    std::size_t texture;
+    Index position;
+    Index normal;
+    Index texture;
+};
+
+// Homogeneous coordinate of a position, only stored when different from 1.
+struct PositionWeight
+{
+    Index position;
+    float w;
+
+    bool operator == (const PositionWeight &pw) const
+    {
+        return this->position == pw.position && this->w == pw.w;
+    }
 };
 
 struct MaterialId
@@ -88,7 +103,8 @@ struct MaterialActivation
 typedef std::vector<MaterialId> MaterialIdVector;
 typedef std::vector<MaterialActivation> MaterialActivationVector;
 typedef std::vector<VertexIndex> VertexIndexVector;
-typedef std::vector<std::size_t> IndexVector;
+typedef std::vector<Index> IndexVector;
+typedef std::vector<PositionWeight> PositionWeightVector;
 
 struct Object
 {
@@ -102,7 +118,9 @@ typedef std::vector<Object> ObjectVector;
 
 struct ObjModel
 {
-    Vec4Vector positions;
+    Vec3Vector positions;
+    // Sorted by position index
+    PositionWeightVector positionWeights;
     Vec3Vector normals;
     Vec3Vector textures;
     Vec4Vector tangents;
@@ -112,12 +130,53 @@ struct ObjModel
     std::size_t nbTriangleVertices() const;
     std::size_t nbVertexIndices() const;
 
-    void computeNormals(bool normalized = false);
-    void computeTangents();
+    float positionWeight(std::size_t index) const;
+
+    inline glm::vec4 position(std::size_t index) const
+    {
+        return glm::vec4(positions[index], positionWeights.empty() ? 1.0f : positionWeight(index));
+    }
+
+    // nbThreads 0 means as many threads as supported by the hardware.
+    void computeNormals(bool normalized = false, unsigned int nbThreads = 1);
+    void computeTangents(unsigned int nbThreads = 1);
+};
+
+using ObjModelLoading = sys::OperationResult;
+
+struct LoadOptions
+{
+    LoadOptions() : nbThreads(1), reserveCapacities(false), scratchArena(false) {}
+
+    // 0 means as many threads as supported by the hardware.
+    unsigned int nbThreads;
+    // Counts elements in a first pass over the file to reserve exact capacities.
+    bool reserveCapacities;
+    // Allocates temporary parsing data in a monotonic arena released at the end of the loading.
+    bool scratchArena;
 };
 
 std::istream & operator >> (std::istream &is, ObjModel &vfm);
 
+ObjModelLoading load(const char *filename, ObjModel &vfm, const LoadOptions &options = LoadOptions());
+
+// Durations in microseconds of the loading phases.
+struct LoadProfile
+{
+    LoadProfile() : read(0), tokenize(0), index(0), triangulate(0), nbBytes(0), nbFaces(0) {}
+
+    std::uint64_t read;
+    std::uint64_t tokenize;
+    std::uint64_t index;
+    std::uint64_t triangulate;
+    std::size_t nbBytes;
+    std::size_t nbFaces;
+};
+
+// Loads a file running the phases one after the other to time them separately.
+// Slower than load and materials are ignored: only meant to compare builds.
+ObjModelLoading profile(const char *filename, ObjModel &vfm, LoadProfile &profile);
+
 std::istream & operator >> (std::istream &is, MaterialMap &materialMap);
 }
 
@@ -0,0 +1,23 @@
+#ifndef OBJMODEL_CACHE_HPP
+#define OBJMODEL_CACHE_HPP
+
+#include <string>
+#include "ObjModel.hpp"
+
+namespace vfm
+{
+
+using ObjModelCaching = sys::OperationResult;
+
+// Binary image of an ObjModel made of aligned arrays, loaded from a mapped
+// file by bulk copies. The size and the modification time of the source
+// OBJ file are stored to detect outdated caches.
+std::string cacheFilename(const char *objFilename);
+
+ObjModelCaching saveCache(const char *cacheFilename, const char *sourceFilename, const ObjModel &model);
+
+ObjModelLoading loadCache(const char *cacheFilename, const char *sourceFilename, ObjModel &model);
+
+}
+
+#endif // OBJMODEL_CACHE_HPP
@@ -0,0 +1,100 @@
+#ifndef OCCLUSION_CULLING_HPP
+#define OCCLUSION_CULLING_HPP
+
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "gl.hpp"
+#include "OperationResult.hpp"
+#include "ShaderProgram.hpp"
+#include "UniformDeclaration.hpp"
+
+namespace ogl
+{
+
+using OcclusionCullingCreation = sys::OperationResult;
+
+// Occlusion queries generated on demand and reused once their result is read.
+class OcclusionQueryPool
+{
+public:
+    OcclusionQueryPool() = default;
+    ~OcclusionQueryPool();
+    OcclusionQueryPool(const OcclusionQueryPool&) = delete;
+    OcclusionQueryPool& operator = (const OcclusionQueryPool&) = delete;
+
+    GLuint acquire();
+    void release(GLuint query);
+
+    inline std::size_t size() const
+    {
+        return _queries.size();
+    }
+
+private:
+    std::vector<GLuint> _queries;
+    std::vector<GLuint> _freeQueries;
+};
+
+// Draws bounding boxes inside occlusion queries, without writing the color
+// and depth buffers. The query counts the samples passing the depth test,
+// conservatively when GL_ARB_ES3_compatibility is available. The results
+// are read without waiting, usually one frame later.
+class OcclusionCulling
+{
+public:
+    OcclusionCulling();
+    ~OcclusionCulling();
+    OcclusionCulling(const OcclusionCulling&) = delete;
+    OcclusionCulling& operator = (const OcclusionCulling&) = delete;
+
+    // Compiles the program and creates the box vertex array.
+    OcclusionCullingCreation create();
+
+    inline bool created() const
+    {
+        return _vertexArray != 0;
+    }
+
+    // Binds the program and the box vertex array, the boxes being in the
+    // space transformed by the matrix. The previous program, the color and
+    // depth masks, the depth function and the face culling are restored by
+    // endQueries.
+    void beginQueries(const glm::mat4 &modelViewProjectionMatrix);
+
+    // Draws the box in a query acquired from the pool. The box is slightly
+    // enlarged and passes on equal depths, so that the triangles lying on
+    // its faces do not hide it.
+    GLuint queryBox(const glm::vec3 &min, const glm::vec3 &max);
+
+    void endQueries();
+
+    // Returns false when the result is not available yet. Otherwise sets
+    // whether any sample of the box passed and releases the query.
+    bool readQuery(GLuint query, bool &anySamplesPassed);
+
+    // Releases a query whose result is no longer needed.
+    void releaseQuery(GLuint query);
+
+private:
+    void clear();
+
+    ShaderProgram _program;
+    UniformDeclaration _mvpMatrixUniform;
+    UniformDeclaration _boxMinUniform;
+    UniformDeclaration _boxSizeUniform;
+    GLuint _vertexArray;
+    std::vector<GLuint> _buffers;
+    GLenum _queryTarget;
+    GLuint _previousProgram;
+    glm::bvec4 _previousColorMask;
+    GLboolean _previousDepthMask;
+    GLenum _previousDepthFunc;
+    bool _previousCullFace;
+    OcclusionQueryPool _queryPool;
+};
+
+}
+
+#endif // OCCLUSION_CULLING_HPP
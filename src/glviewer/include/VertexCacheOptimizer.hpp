@@ -0,0 +1,48 @@
+#ifndef VERTEX_CACHE_OPTIMIZER_HPP
+#define VERTEX_CACHE_OPTIMIZER_HPP
+
+#include <vector>
+#include "gl.hpp"
+
+namespace ogl
+{
+
+const std::size_t ACMR_CACHE_SIZE = 16;
+
+// Average cache miss ratio: vertices transformed per triangle with a FIFO
+// post-transform cache of cacheSize entries, from about 0.5 to 3.
+float computeAcmr(const GLuint *indices, std::size_t nbIndices, std::size_t cacheSize = ACMR_CACHE_SIZE);
+
+// Renumbers the vertices in order of first use by the indices, which are
+// rewritten, so that vertex fetches follow the triangle order. Returns the
+// previous number of each vertex, unused vertices being dropped.
+std::vector<GLuint> reorderVerticesByFirstUse(GLuint *indices, std::size_t nbIndices, std::size_t nbVertices);
+
+// Reorders triangles for the post-transform vertex cache with Tom Forsyth's
+// linear-speed algorithm, which simulates a LRU cache of 32 entries. The
+// working buffers are kept to optimize many index ranges in a row.
+class VertexCacheOptimizer
+{
+public:
+    void optimize(GLuint *indices, std::size_t nbIndices);
+
+private:
+    void emit(std::size_t triangle);
+
+    std::vector<GLuint> _localVertices;
+    std::vector<GLuint> _globalVertices;
+    std::vector<GLuint> _triangles;
+    std::vector<GLuint> _nbRemainingTriangles;
+    std::vector<std::size_t> _firstAdjacentTriangles;
+    std::vector<GLuint> _adjacentTriangles;
+    std::vector<float> _vertexScores;
+    std::vector<float> _triangleScores;
+    std::vector<bool> _emitted;
+    std::vector<GLuint> _cache;
+    std::vector<GLuint> _previousCache;
+    std::vector<GLuint> _output;
+};
+
+}
+
+#endif // VERTEX_CACHE_OPTIMIZER_HPP
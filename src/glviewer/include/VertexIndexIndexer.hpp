@@ -0,0 +1,166 @@
+#ifndef VERTEX_INDEX_INDEXER_HPP
+#define VERTEX_INDEX_INDEXER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "ObjModel.hpp"
+
+namespace vfm
+{
+
+// Gives the index of each distinct vertex of an object, adding it to the
+// object vertices on first use.
+// Open addressing hash table with linear probing. Slots are kept when the
+// object changes: entries of previous generations are considered as empty.
+class VertexIndexIndexer
+{
+public:
+
+    VertexIndexIndexer(Object *o, std::pmr::memory_resource *scratch) : _object{o}, _generation{1}, _size{0}, _maxSize{0}, _slots{scratch}
+    {
+    }
+
+    VertexIndexIndexer& operator = (Object *o)
+    {
+        if (_object != o)
+        {
+            if (++_generation == 0)
+            {
+                std::fill(_slots.begin(), _slots.end(), Slot());
+                _generation = 1;
+            }
+            _size = 0;
+            _object = o;
+        }
+        return *this;
+    }
+
+    void reserve(std::size_t nbVertices)
+    {
+        std::size_t capacity = MIN_INDEXER_CAPACITY;
+        for (; maxSize(capacity) < nbVertices; capacity *= 2);
+        if (capacity > _slots.size())
+        {
+            rehash(capacity);
+        }
+    }
+
+    Index operator [](const VertexIndex &vi)
+    {
+        if (_size >= _maxSize)
+        {
+            rehash(std::max(MIN_INDEXER_CAPACITY, 2 * _slots.size()));
+        }
+
+        std::size_t mask = _slots.size() - 1;
+        for (std::size_t i = hash(vi) & mask;; i = (i + 1) & mask)
+        {
+            Slot &slot = _slots[i];
+            if (slot.generation != _generation)
+            {
+                slot.vertexIndex = vi;
+                slot.index = static_cast<Index>(_object->vertexIndices.size());
+                slot.generation = _generation;
+                ++_size;
+                _object->vertexIndices.push_back(vi);
+                return slot.index;
+            }
+            if (slot.vertexIndex.position == vi.position && slot.vertexIndex.normal == vi.normal && slot.vertexIndex.texture == vi.texture)
+            {
+                return slot.index;
+            }
+        }
+    }
+
+private:
+    struct Slot
+    {
+        Slot() : index(0), generation(0) {}
+
+        VertexIndex vertexIndex;
+        Index index;
+        std::uint32_t generation;
+    };
+
+    static inline std::size_t hash(const VertexIndex &vi)
+    {
+        std::uint64_t h = static_cast<std::uint64_t>(vi.position) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<std::uint64_t>(vi.normal) * 0xC2B2AE3D27D4EB4Full;
+        h ^= static_cast<std::uint64_t>(vi.texture) * 0x165667B19E3779F9ull;
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ull;
+        h ^= h >> 29;
+        return static_cast<std::size_t>(h);
+    }
+
+    // maximum load factor is 3/4
+    static inline std::size_t maxSize(std::size_t capacity)
+    {
+        return capacity / 4 * 3;
+    }
+
+    void rehash(std::size_t capacity)
+    {
+        _maxSize = maxSize(capacity);
+        std::pmr::vector<Slot> slots(capacity, _slots.get_allocator());
+        std::swap(slots, _slots);
+        std::size_t mask = capacity - 1;
+        for (const Slot &slot : slots)
+        {
+            if (slot.generation == _generation)
+            {
+                std::size_t i = hash(slot.vertexIndex) & mask;
+                for (; _slots[i].generation == _generation; i = (i + 1) & mask);
+                _slots[i] = slot;
+            }
+        }
+    }
+
+    static constexpr std::size_t MIN_INDEXER_CAPACITY = 1024;
+
+    Object *_object;
+    std::uint32_t _generation;
+    std::size_t _size;
+    std::size_t _maxSize;
+    std::pmr::vector<Slot> _slots;
+};
+
+// Triangulates a convex polygon, alternating between both ends of its indices.
+inline void createTriangles(const Index *polygons, std::size_t nbIndices, IndexVector &triangles)
+{
+    if (nbIndices < 3)
+    {
+        return;
+    }
+
+    std::size_t descIndex = nbIndices;
+    std::size_t ascIndex = 2;
+
+    Index previous = polygons[0];
+    Index current = polygons[1];
+    Index next = polygons[2];
+
+    for(bool asc = false; ascIndex < descIndex; asc = !asc)
+    {
+        triangles.push_back(previous);
+        triangles.push_back(current);
+        triangles.push_back(next);
+
+        if (asc)
+        {
+            current = next;
+            next = polygons[++ascIndex];
+        }
+        else
+        {
+            current = previous;
+            previous = polygons[--descIndex];
+        }
+    }
+}
+
+}
+
+#endif // VERTEX_INDEX_INDEXER_HPP
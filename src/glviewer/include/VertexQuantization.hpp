@@ -0,0 +1,22 @@
+#ifndef VERTEX_QUANTIZATION_HPP
+#define VERTEX_QUANTIZATION_HPP
+
+#include "glm/vec4.hpp"
+#include "gl.hpp"
+
+namespace ogl
+{
+
+// Unsigned normalized 16 bits value of v, clamped to [0, 1].
+GLushort quantizeUnorm16(float v);
+
+// GL_INT_2_10_10_10_REV packing of v, clamped to [-1, 1]: 10 bits signed
+// normalized x, y and z, and 2 bits w, which is -1, 0 or 1.
+GLuint packSnorm1010102(const glm::vec4 &v);
+
+// IEEE 754 half precision of v, rounded to nearest even.
+GLhalf toHalfFloat(float v);
+
+}
+
+#endif // VERTEX_QUANTIZATION_HPP
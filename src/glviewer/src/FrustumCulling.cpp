@@ -0,0 +1,211 @@
+#include "glm/geometric.hpp"
+#include "FrustumCulling.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLING_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(FRUSTUM_CULLING_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FRUSTUM_CULLING_AVX
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+// The corner of the box the furthest along the plane normal: the box is
+// outside when this corner is behind the plane.
+struct PlaneCorner
+{
+    const float *x;
+    const float *y;
+    const float *z;
+};
+
+PlaneCorner planeCorner(const glm::vec4 &plane, const ogl::BoundingBoxArrays &boxes)
+{
+    return PlaneCorner{plane.x >= .0f ? boxes.maxX.data() : boxes.minX.data(),
+                       plane.y >= .0f ? boxes.maxY.data() : boxes.minY.data(),
+                       plane.z >= .0f ? boxes.maxZ.data() : boxes.minZ.data()};
+}
+
+void cullBoundingBoxesScalar(const ogl::Frustum &frustum, const ogl::BoundingBoxArrays &boxes, std::size_t first, unsigned char *visible)
+{
+    for (std::size_t i = first; i < boxes.size(); ++i)
+    {
+        visible[i] = 1;
+    }
+    for (std::size_t p = 0; p < ogl::Frustum::NB_PLANES; ++p)
+    {
+        const glm::vec4 &plane = frustum.plane(p);
+        PlaneCorner corner = planeCorner(plane, boxes);
+        for (std::size_t i = first; i < boxes.size(); ++i)
+        {
+            if (plane.x * corner.x[i] + plane.y * corner.y[i] + plane.z * corner.z[i] + plane.w < .0f)
+            {
+                visible[i] = 0;
+            }
+        }
+    }
+}
+
+#ifdef FRUSTUM_CULLING_SSE2
+
+std::size_t cullBoundingBoxesSse2(const ogl::Frustum &frustum, const ogl::BoundingBoxArrays &boxes, unsigned char *visible)
+{
+    PlaneCorner corners[ogl::Frustum::NB_PLANES];
+    for (std::size_t p = 0; p < ogl::Frustum::NB_PLANES; ++p)
+    {
+        corners[p] = planeCorner(frustum.plane(p), boxes);
+    }
+
+    std::size_t i = 0;
+    for (; i + 4 <= boxes.size(); i += 4)
+    {
+        __m128 outside = _mm_setzero_ps();
+        for (std::size_t p = 0; p < ogl::Frustum::NB_PLANES; ++p)
+        {
+            const glm::vec4 &plane = frustum.plane(p);
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), _mm_loadu_ps(corners[p].x + i)),
+                                                    _mm_mul_ps(_mm_set1_ps(plane.y), _mm_loadu_ps(corners[p].y + i))),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), _mm_loadu_ps(corners[p].z + i)), _mm_set1_ps(plane.w)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+        int mask = _mm_movemask_ps(outside);
+        for (std::size_t j = 0; j < 4; ++j)
+        {
+            visible[i + j] = (mask >> j) & 1 ? 0 : 1;
+        }
+    }
+    return i;
+}
+
+#endif
+
+#ifdef FRUSTUM_CULLING_AVX
+
+__attribute__((target("avx")))
+std::size_t cullBoundingBoxesAvx(const ogl::Frustum &frustum, const ogl::BoundingBoxArrays &boxes, unsigned char *visible)
+{
+    PlaneCorner corners[ogl::Frustum::NB_PLANES];
+    for (std::size_t p = 0; p < ogl::Frustum::NB_PLANES; ++p)
+    {
+        corners[p] = planeCorner(frustum.plane(p), boxes);
+    }
+
+    std::size_t i = 0;
+    for (; i + 8 <= boxes.size(); i += 8)
+    {
+        __m256 outside = _mm256_setzero_ps();
+        for (std::size_t p = 0; p < ogl::Frustum::NB_PLANES; ++p)
+        {
+            const glm::vec4 &plane = frustum.plane(p);
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), _mm256_loadu_ps(corners[p].x + i)),
+                                                          _mm256_mul_ps(_mm256_set1_ps(plane.y), _mm256_loadu_ps(corners[p].y + i))),
+                                            _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), _mm256_loadu_ps(corners[p].z + i)), _mm256_set1_ps(plane.w)));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+        int mask = _mm256_movemask_ps(outside);
+        for (std::size_t j = 0; j < 8; ++j)
+        {
+            visible[i + j] = (mask >> j) & 1 ? 0 : 1;
+        }
+    }
+    return i;
+}
+
+#endif
+
+}
+
+ogl::Frustum::Frustum(const glm::mat4 &matrix)
+{
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        _planes[2 * i] = rows[3] + rows[i];
+        _planes[2 * i + 1] = rows[3] - rows[i];
+    }
+    for (glm::vec4 &plane : _planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool ogl::Frustum::intersectsSphere(const glm::vec3 &center, float radius) const
+{
+    for (const glm::vec4 &plane : _planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ogl::Frustum::intersectsBox(const glm::vec3 &min, const glm::vec3 &max) const
+{
+    for (const glm::vec4 &plane : _planes)
+    {
+        glm::vec3 corner(plane.x >= .0f ? max.x : min.x, plane.y >= .0f ? max.y : min.y, plane.z >= .0f ? max.z : min.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < .0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ogl::Frustum::crossesNearPlane(const glm::vec3 &min, const glm::vec3 &max) const
+{
+    const glm::vec4 &plane = _planes[NEAR_PLANE];
+    glm::vec3 corner(plane.x >= .0f ? min.x : max.x, plane.y >= .0f ? min.y : max.y, plane.z >= .0f ? min.z : max.z);
+    return glm::dot(glm::vec3(plane), corner) + plane.w < .0f;
+}
+
+void ogl::BoundingBoxArrays::clear()
+{
+    for (std::vector<float> *values : {&minX, &minY, &minZ, &maxX, &maxY, &maxZ})
+    {
+        values->clear();
+    }
+}
+
+void ogl::BoundingBoxArrays::push_back(const glm::vec3 &min, const glm::vec3 &max)
+{
+    minX.push_back(min.x);
+    minY.push_back(min.y);
+    minZ.push_back(min.z);
+    maxX.push_back(max.x);
+    maxY.push_back(max.y);
+    maxZ.push_back(max.z);
+}
+
+void ogl::cullBoundingBoxes(const Frustum &frustum, const BoundingBoxArrays &boxes, std::vector<unsigned char> &visible, vfm::InstructionSet instructionSet)
+{
+    visible.resize(boxes.size());
+    std::size_t first = 0;
+    switch (instructionSet)
+    {
+#ifdef FRUSTUM_CULLING_AVX
+    case vfm::InstructionSet::AVX:
+        first = cullBoundingBoxesAvx(frustum, boxes, visible.data());
+        break;
+#endif
+#ifdef FRUSTUM_CULLING_SSE2
+    case vfm::InstructionSet::SSE2:
+        first = cullBoundingBoxesSse2(frustum, boxes, visible.data());
+        break;
+#endif
+    default:
+        break;
+    }
+    // Remaining boxes of the last incomplete SIMD batch.
+    cullBoundingBoxesScalar(frustum, boxes, first, visible.data());
+}
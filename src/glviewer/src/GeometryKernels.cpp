@@ -0,0 +1,277 @@
+#include <cmath>
+#include "GeometryKernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GEOMETRY_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(GEOMETRY_KERNELS_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GEOMETRY_KERNELS_AVX
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+const std::size_t N = vfm::TRIANGLE_BATCH_SIZE;
+
+void computeFaceNormalsScalar(const vfm::Vec3Batch p[3], vfm::Vec3Batch &n)
+{
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        float e1x = p[1].x[i] - p[0].x[i], e1y = p[1].y[i] - p[0].y[i], e1z = p[1].z[i] - p[0].z[i];
+        float e2x = p[2].x[i] - p[0].x[i], e2y = p[2].y[i] - p[0].y[i], e2z = p[2].z[i] - p[0].z[i];
+        float nx = e1y * e2z - e1z * e2y;
+        float ny = e1z * e2x - e1x * e2z;
+        float nz = e1x * e2y - e1y * e2x;
+        float inverseLength = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+        n.x[i] = nx * inverseLength;
+        n.y[i] = ny * inverseLength;
+        n.z[i] = nz * inverseLength;
+    }
+}
+
+void computeTangentDirectionsScalar(const vfm::Vec3Batch p[3], const vfm::Vec2Batch t[3], vfm::Vec3Batch &sdir, vfm::Vec3Batch &tdir)
+{
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        float ax = p[1].x[i] - p[0].x[i], ay = p[1].y[i] - p[0].y[i], az = p[1].z[i] - p[0].z[i];
+        float bx = p[2].x[i] - p[0].x[i], by = p[2].y[i] - p[0].y[i], bz = p[2].z[i] - p[0].z[i];
+        float us = t[1].x[i] - t[0].x[i], ut = t[1].y[i] - t[0].y[i];
+        float vs = t[2].x[i] - t[0].x[i], vt = t[2].y[i] - t[0].y[i];
+        float r = 1.0f / (us * vt - vs * ut);
+        sdir.x[i] = (vt * ax - ut * bx) * r;
+        sdir.y[i] = (vt * ay - ut * by) * r;
+        sdir.z[i] = (vt * az - ut * bz) * r;
+        tdir.x[i] = (us * bx - vs * ax) * r;
+        tdir.y[i] = (us * by - vs * ay) * r;
+        tdir.z[i] = (us * bz - vs * az) * r;
+    }
+}
+
+void orthogonalizeTangentsScalar(const vfm::Vec3Batch &n, const vfm::Vec3Batch &s, const vfm::Vec3Batch &t, vfm::Vec4Batch &tangents)
+{
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        float d = n.x[i] * s.x[i] + n.y[i] * s.y[i] + n.z[i] * s.z[i];
+        float x = s.x[i] - n.x[i] * d, y = s.y[i] - n.y[i] * d, z = s.z[i] - n.z[i] * d;
+        float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+        tangents.x[i] = x * inverseLength;
+        tangents.y[i] = y * inverseLength;
+        tangents.z[i] = z * inverseLength;
+        float cx = n.y[i] * s.z[i] - n.z[i] * s.y[i];
+        float cy = n.z[i] * s.x[i] - n.x[i] * s.z[i];
+        float cz = n.x[i] * s.y[i] - n.y[i] * s.x[i];
+        tangents.w[i] = cx * t.x[i] + cy * t.y[i] + cz * t.z[i] < .0f ? -1.0f : 1.0f;
+    }
+}
+
+#ifdef GEOMETRY_KERNELS_SSE2
+
+void computeFaceNormalsSse2(const vfm::Vec3Batch p[3], vfm::Vec3Batch &n)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (std::size_t i = 0; i < N; i += 4)
+    {
+        __m128 p0x = _mm_loadu_ps(p[0].x + i), p0y = _mm_loadu_ps(p[0].y + i), p0z = _mm_loadu_ps(p[0].z + i);
+        __m128 e1x = _mm_sub_ps(_mm_loadu_ps(p[1].x + i), p0x), e1y = _mm_sub_ps(_mm_loadu_ps(p[1].y + i), p0y), e1z = _mm_sub_ps(_mm_loadu_ps(p[1].z + i), p0z);
+        __m128 e2x = _mm_sub_ps(_mm_loadu_ps(p[2].x + i), p0x), e2y = _mm_sub_ps(_mm_loadu_ps(p[2].y + i), p0y), e2z = _mm_sub_ps(_mm_loadu_ps(p[2].z + i), p0z);
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x));
+        __m128 squaredLength = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+        __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(squaredLength));
+        _mm_storeu_ps(n.x + i, _mm_mul_ps(nx, inverseLength));
+        _mm_storeu_ps(n.y + i, _mm_mul_ps(ny, inverseLength));
+        _mm_storeu_ps(n.z + i, _mm_mul_ps(nz, inverseLength));
+    }
+}
+
+void computeTangentDirectionsSse2(const vfm::Vec3Batch p[3], const vfm::Vec2Batch t[3], vfm::Vec3Batch &sdir, vfm::Vec3Batch &tdir)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (std::size_t i = 0; i < N; i += 4)
+    {
+        __m128 p0x = _mm_loadu_ps(p[0].x + i), p0y = _mm_loadu_ps(p[0].y + i), p0z = _mm_loadu_ps(p[0].z + i);
+        __m128 ax = _mm_sub_ps(_mm_loadu_ps(p[1].x + i), p0x), ay = _mm_sub_ps(_mm_loadu_ps(p[1].y + i), p0y), az = _mm_sub_ps(_mm_loadu_ps(p[1].z + i), p0z);
+        __m128 bx = _mm_sub_ps(_mm_loadu_ps(p[2].x + i), p0x), by = _mm_sub_ps(_mm_loadu_ps(p[2].y + i), p0y), bz = _mm_sub_ps(_mm_loadu_ps(p[2].z + i), p0z);
+        __m128 t0s = _mm_loadu_ps(t[0].x + i), t0t = _mm_loadu_ps(t[0].y + i);
+        __m128 us = _mm_sub_ps(_mm_loadu_ps(t[1].x + i), t0s), ut = _mm_sub_ps(_mm_loadu_ps(t[1].y + i), t0t);
+        __m128 vs = _mm_sub_ps(_mm_loadu_ps(t[2].x + i), t0s), vt = _mm_sub_ps(_mm_loadu_ps(t[2].y + i), t0t);
+        __m128 r = _mm_div_ps(one, _mm_sub_ps(_mm_mul_ps(us, vt), _mm_mul_ps(vs, ut)));
+        _mm_storeu_ps(sdir.x + i, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(vt, ax), _mm_mul_ps(ut, bx)), r));
+        _mm_storeu_ps(sdir.y + i, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(vt, ay), _mm_mul_ps(ut, by)), r));
+        _mm_storeu_ps(sdir.z + i, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(vt, az), _mm_mul_ps(ut, bz)), r));
+        _mm_storeu_ps(tdir.x + i, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(us, bx), _mm_mul_ps(vs, ax)), r));
+        _mm_storeu_ps(tdir.y + i, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(us, by), _mm_mul_ps(vs, ay)), r));
+        _mm_storeu_ps(tdir.z + i, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(us, bz), _mm_mul_ps(vs, az)), r));
+    }
+}
+
+void orthogonalizeTangentsSse2(const vfm::Vec3Batch &n, const vfm::Vec3Batch &s, const vfm::Vec3Batch &t, vfm::Vec4Batch &tangents)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    for (std::size_t i = 0; i < N; i += 4)
+    {
+        __m128 nx = _mm_loadu_ps(n.x + i), ny = _mm_loadu_ps(n.y + i), nz = _mm_loadu_ps(n.z + i);
+        __m128 sx = _mm_loadu_ps(s.x + i), sy = _mm_loadu_ps(s.y + i), sz = _mm_loadu_ps(s.z + i);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, sx), _mm_mul_ps(ny, sy)), _mm_mul_ps(nz, sz));
+        __m128 x = _mm_sub_ps(sx, _mm_mul_ps(nx, d)), y = _mm_sub_ps(sy, _mm_mul_ps(ny, d)), z = _mm_sub_ps(sz, _mm_mul_ps(nz, d));
+        __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))));
+        _mm_storeu_ps(tangents.x + i, _mm_mul_ps(x, inverseLength));
+        _mm_storeu_ps(tangents.y + i, _mm_mul_ps(y, inverseLength));
+        _mm_storeu_ps(tangents.z + i, _mm_mul_ps(z, inverseLength));
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(ny, sz), _mm_mul_ps(nz, sy));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(nz, sx), _mm_mul_ps(nx, sz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(nx, sy), _mm_mul_ps(ny, sx));
+        __m128 handedness = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_loadu_ps(t.x + i)), _mm_mul_ps(cy, _mm_loadu_ps(t.y + i))), _mm_mul_ps(cz, _mm_loadu_ps(t.z + i)));
+        __m128 negative = _mm_cmplt_ps(handedness, zero);
+        _mm_storeu_ps(tangents.w + i, _mm_or_ps(_mm_and_ps(negative, minusOne), _mm_andnot_ps(negative, one)));
+    }
+}
+
+#endif
+
+#ifdef GEOMETRY_KERNELS_AVX
+
+__attribute__((target("avx")))
+void computeFaceNormalsAvx(const vfm::Vec3Batch p[3], vfm::Vec3Batch &n)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 p0x = _mm256_loadu_ps(p[0].x), p0y = _mm256_loadu_ps(p[0].y), p0z = _mm256_loadu_ps(p[0].z);
+    __m256 e1x = _mm256_sub_ps(_mm256_loadu_ps(p[1].x), p0x), e1y = _mm256_sub_ps(_mm256_loadu_ps(p[1].y), p0y), e1z = _mm256_sub_ps(_mm256_loadu_ps(p[1].z), p0z);
+    __m256 e2x = _mm256_sub_ps(_mm256_loadu_ps(p[2].x), p0x), e2y = _mm256_sub_ps(_mm256_loadu_ps(p[2].y), p0y), e2z = _mm256_sub_ps(_mm256_loadu_ps(p[2].z), p0z);
+    __m256 nx = _mm256_sub_ps(_mm256_mul_ps(e1y, e2z), _mm256_mul_ps(e1z, e2y));
+    __m256 ny = _mm256_sub_ps(_mm256_mul_ps(e1z, e2x), _mm256_mul_ps(e1x, e2z));
+    __m256 nz = _mm256_sub_ps(_mm256_mul_ps(e1x, e2y), _mm256_mul_ps(e1y, e2x));
+    __m256 squaredLength = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz));
+    __m256 inverseLength = _mm256_div_ps(one, _mm256_sqrt_ps(squaredLength));
+    _mm256_storeu_ps(n.x, _mm256_mul_ps(nx, inverseLength));
+    _mm256_storeu_ps(n.y, _mm256_mul_ps(ny, inverseLength));
+    _mm256_storeu_ps(n.z, _mm256_mul_ps(nz, inverseLength));
+}
+
+__attribute__((target("avx")))
+void computeTangentDirectionsAvx(const vfm::Vec3Batch p[3], const vfm::Vec2Batch t[3], vfm::Vec3Batch &sdir, vfm::Vec3Batch &tdir)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 p0x = _mm256_loadu_ps(p[0].x), p0y = _mm256_loadu_ps(p[0].y), p0z = _mm256_loadu_ps(p[0].z);
+    __m256 ax = _mm256_sub_ps(_mm256_loadu_ps(p[1].x), p0x), ay = _mm256_sub_ps(_mm256_loadu_ps(p[1].y), p0y), az = _mm256_sub_ps(_mm256_loadu_ps(p[1].z), p0z);
+    __m256 bx = _mm256_sub_ps(_mm256_loadu_ps(p[2].x), p0x), by = _mm256_sub_ps(_mm256_loadu_ps(p[2].y), p0y), bz = _mm256_sub_ps(_mm256_loadu_ps(p[2].z), p0z);
+    __m256 t0s = _mm256_loadu_ps(t[0].x), t0t = _mm256_loadu_ps(t[0].y);
+    __m256 us = _mm256_sub_ps(_mm256_loadu_ps(t[1].x), t0s), ut = _mm256_sub_ps(_mm256_loadu_ps(t[1].y), t0t);
+    __m256 vs = _mm256_sub_ps(_mm256_loadu_ps(t[2].x), t0s), vt = _mm256_sub_ps(_mm256_loadu_ps(t[2].y), t0t);
+    __m256 r = _mm256_div_ps(one, _mm256_sub_ps(_mm256_mul_ps(us, vt), _mm256_mul_ps(vs, ut)));
+    _mm256_storeu_ps(sdir.x, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(vt, ax), _mm256_mul_ps(ut, bx)), r));
+    _mm256_storeu_ps(sdir.y, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(vt, ay), _mm256_mul_ps(ut, by)), r));
+    _mm256_storeu_ps(sdir.z, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(vt, az), _mm256_mul_ps(ut, bz)), r));
+    _mm256_storeu_ps(tdir.x, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(us, bx), _mm256_mul_ps(vs, ax)), r));
+    _mm256_storeu_ps(tdir.y, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(us, by), _mm256_mul_ps(vs, ay)), r));
+    _mm256_storeu_ps(tdir.z, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(us, bz), _mm256_mul_ps(vs, az)), r));
+}
+
+__attribute__((target("avx")))
+void orthogonalizeTangentsAvx(const vfm::Vec3Batch &n, const vfm::Vec3Batch &s, const vfm::Vec3Batch &t, vfm::Vec4Batch &tangents)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    __m256 nx = _mm256_loadu_ps(n.x), ny = _mm256_loadu_ps(n.y), nz = _mm256_loadu_ps(n.z);
+    __m256 sx = _mm256_loadu_ps(s.x), sy = _mm256_loadu_ps(s.y), sz = _mm256_loadu_ps(s.z);
+    __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, sx), _mm256_mul_ps(ny, sy)), _mm256_mul_ps(nz, sz));
+    __m256 x = _mm256_sub_ps(sx, _mm256_mul_ps(nx, d)), y = _mm256_sub_ps(sy, _mm256_mul_ps(ny, d)), z = _mm256_sub_ps(sz, _mm256_mul_ps(nz, d));
+    __m256 inverseLength = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z))));
+    _mm256_storeu_ps(tangents.x, _mm256_mul_ps(x, inverseLength));
+    _mm256_storeu_ps(tangents.y, _mm256_mul_ps(y, inverseLength));
+    _mm256_storeu_ps(tangents.z, _mm256_mul_ps(z, inverseLength));
+    __m256 cx = _mm256_sub_ps(_mm256_mul_ps(ny, sz), _mm256_mul_ps(nz, sy));
+    __m256 cy = _mm256_sub_ps(_mm256_mul_ps(nz, sx), _mm256_mul_ps(nx, sz));
+    __m256 cz = _mm256_sub_ps(_mm256_mul_ps(nx, sy), _mm256_mul_ps(ny, sx));
+    __m256 handedness = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, _mm256_loadu_ps(t.x)), _mm256_mul_ps(cy, _mm256_loadu_ps(t.y))), _mm256_mul_ps(cz, _mm256_loadu_ps(t.z)));
+    __m256 negative = _mm256_cmp_ps(handedness, _mm256_setzero_ps(), _CMP_LT_OQ);
+    _mm256_storeu_ps(tangents.w, _mm256_blendv_ps(one, minusOne, negative));
+}
+
+#endif
+
+}
+
+namespace vfm
+{
+
+InstructionSet widestInstructionSet()
+{
+#ifdef GEOMETRY_KERNELS_AVX
+    static const bool hasAvx = __builtin_cpu_supports("avx");
+    if (hasAvx)
+    {
+        return InstructionSet::AVX;
+    }
+#endif
+#ifdef GEOMETRY_KERNELS_SSE2
+    return InstructionSet::SSE2;
+#else
+    return InstructionSet::SCALAR;
+#endif
+}
+
+void computeFaceNormals(const Vec3Batch positions[3], Vec3Batch &normals, InstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+#ifdef GEOMETRY_KERNELS_AVX
+    case InstructionSet::AVX:
+        computeFaceNormalsAvx(positions, normals);
+        return;
+#endif
+#ifdef GEOMETRY_KERNELS_SSE2
+    case InstructionSet::SSE2:
+        computeFaceNormalsSse2(positions, normals);
+        return;
+#endif
+    default:
+        computeFaceNormalsScalar(positions, normals);
+    }
+}
+
+void computeTangentDirections(const Vec3Batch positions[3], const Vec2Batch textures[3], Vec3Batch &sdir, Vec3Batch &tdir, InstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+#ifdef GEOMETRY_KERNELS_AVX
+    case InstructionSet::AVX:
+        computeTangentDirectionsAvx(positions, textures, sdir, tdir);
+        return;
+#endif
+#ifdef GEOMETRY_KERNELS_SSE2
+    case InstructionSet::SSE2:
+        computeTangentDirectionsSse2(positions, textures, sdir, tdir);
+        return;
+#endif
+    default:
+        computeTangentDirectionsScalar(positions, textures, sdir, tdir);
+    }
+}
+
+void orthogonalizeTangents(const Vec3Batch &normals, const Vec3Batch &sdir, const Vec3Batch &tdir, Vec4Batch &tangents, InstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+#ifdef GEOMETRY_KERNELS_AVX
+    case InstructionSet::AVX:
+        orthogonalizeTangentsAvx(normals, sdir, tdir, tangents);
+        return;
+#endif
+#ifdef GEOMETRY_KERNELS_SSE2
+    case InstructionSet::SSE2:
+        orthogonalizeTangentsSse2(normals, sdir, tdir, tangents);
+        return;
+#endif
+    default:
+        orthogonalizeTangentsScalar(normals, sdir, tdir, tangents);
+    }
+}
+
+}
@@ -1,9 +1,17 @@
 #include <memory>
 #include <limits>
 #include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include "glm/geometric.hpp"
 #include "GlError.hpp"
 #include "Duration.hpp"
 #include "GlMesh.hpp"
+#include "StateCache.hpp"
+#include "MeshSimplifier.hpp"
+#include "VertexCacheOptimizer.hpp"
+#include "VertexQuantization.hpp"
 
 namespace
 {
@@ -12,9 +20,12 @@ namespace
     const auto MAX_GL_UNSIGNED_SHORT = std::numeric_limits<GLushort>::max();
     const auto MAX_FLOAT = std::numeric_limits<float>::max();
     const auto MIN_FLOAT = -std::numeric_limits<float>::max();
+    const float MAX_PIXEL_ERROR = 1.0f;
 
     enum VertexAttributeBuffer{VERTEX_POSITION, VERTEX_TEXTURE_COORD, VERTEX_NORMAL, VERTEX_TANGENT, NB_VERTEX_ATTRIBUTES};
 
+    enum MeshBuffer{INDEX_BUFFER, VERTEX_BUFFER, DRAW_COMMAND_BUFFER, DRAW_MATERIAL_INDEX_BUFFER, NB_MESH_BUFFERS};
+
     void copy(GLfloat *dest, const glm::vec4 &source, std::size_t destWitdh, bool homogeneous = false)
     {
         switch(destWitdh)
@@ -58,6 +69,14 @@ namespace
         }
     }
 
+    const char INSTANCE_MODEL_MATRIX_NAME[] = "instanceModelMat";
+    const char INSTANCE_COLOR_NAME[] = "instanceColor";
+
+    inline bool isInstanceAttribute(const ogl::VertexAttributeDeclaration &vad)
+    {
+        return vad.name() == INSTANCE_MODEL_MATRIX_NAME || vad.name() == INSTANCE_COLOR_NAME;
+    }
+
     VertexAttributeBuffer toVertexAttributeBuffer(const ogl::VertexAttributeDeclaration &vad)
     {
         if (vad.name() == "vertexPosition")
@@ -79,45 +98,130 @@ namespace
         return NB_VERTEX_ATTRIBUTES;
     }
 
+    // Offsets and sizes in bytes, size being the number of components.
     struct VertexAttributeBufferDesc
     {
         GLuint index;
         VertexAttributeBuffer type;
         std::size_t offset;
         std::size_t size;
+        std::size_t nbBytes;
+        GLenum glType;
+        GLboolean normalized;
     };
 
     using VertexAttributeBufferDescVector = std::vector<VertexAttributeBufferDesc>;
 
     inline std::size_t computeVertexAttributesStructureSize(const VertexAttributeBufferDescVector &v)
     {
-        return v.empty() ? 0 : v.back().offset + v.back().size;
+        return v.empty() ? 0 : v.back().offset + v.back().nbBytes;
+    }
+
+    // Attributes of 16 bits components are padded to keep the next ones 4 bytes aligned.
+    inline std::size_t alignedNbBytes(std::size_t nbBytes)
+    {
+        return (nbBytes + 3) / 4 * 4;
     }
 
-    VertexAttributeBufferDescVector createVertexAttributeBufferDescVector(const ogl::VertexAttributeDeclarationVector &vads)
+    // The quantized positions are unsigned normalized shorts in the bounding
+    // box, the normals and tangents signed normalized 10 bits and the texture
+    // coordinates half floats.
+    VertexAttributeBufferDescVector createVertexAttributeBufferDescVector(const ogl::VertexAttributeDeclarationVector &vads, bool quantized)
     {
         std::vector<VertexAttributeBufferDesc> vertexAttributeBufferDescVector;
         std::size_t vertexAttributePointerOffset = 0;
         VertexAttributeBufferDesc vabd;
         for(const ogl::VertexAttributeDeclaration &vad : vads)
         {
+            if (isInstanceAttribute(vad))
+            {
+                continue;
+            }
             vabd.index = vad.index();
             vabd.size = vad.sizeOf() / sizeof(GLfloat);
             vabd.type = toVertexAttributeBuffer(vad);
             vabd.offset = vertexAttributePointerOffset;
+            vabd.nbBytes = vabd.size * sizeof(GLfloat);
+            vabd.glType = GL_FLOAT;
+            vabd.normalized = vabd.type == VERTEX_NORMAL ? GL_TRUE : GL_FALSE;
+            if (quantized)
+            {
+                switch (vabd.type)
+                {
+                case VERTEX_POSITION:
+                    vabd.nbBytes = alignedNbBytes(vabd.size * sizeof(GLushort));
+                    vabd.glType = GL_UNSIGNED_SHORT;
+                    vabd.normalized = GL_TRUE;
+                    break;
+                case VERTEX_NORMAL:
+                case VERTEX_TANGENT:
+                    vabd.size = 4;
+                    vabd.nbBytes = sizeof(GLuint);
+                    vabd.glType = GL_INT_2_10_10_10_REV;
+                    vabd.normalized = GL_TRUE;
+                    break;
+                case VERTEX_TEXTURE_COORD:
+                    vabd.nbBytes = alignedNbBytes(vabd.size * sizeof(GLhalf));
+                    vabd.glType = GL_HALF_FLOAT;
+                    break;
+                default:
+                    break;
+                }
+            }
             vertexAttributeBufferDescVector.push_back(vabd);
 
-            vertexAttributePointerOffset += vabd.size;
+            vertexAttributePointerOffset += vabd.nbBytes;
         }
         return vertexAttributeBufferDescVector;
     }
 
-    ogl::GlMeshGeneration checkAndComputeVertexAttributes(const ogl::VertexAttributeDeclarationVector &vads, vfm::ObjModel &objModel)
+    void storeUnorm16(GLubyte *dest, const glm::vec3 &position, std::size_t destWidth, const ogl::BoundingBox &boundingBox)
+    {
+        GLushort *values = reinterpret_cast<GLushort*>(dest);
+        glm::vec3 dimension = boundingBox.dimension();
+        for (std::size_t i = 0; i < std::min<std::size_t>(destWidth, 3); ++i)
+        {
+            values[i] = ogl::quantizeUnorm16(dimension[i] > .0f ? (position[i] - boundingBox.min[i]) / dimension[i] : .0f);
+        }
+        if (destWidth == 4)
+        {
+            values[3] = ogl::quantizeUnorm16(1.0f);
+        }
+    }
+
+    void storeHalfFloats(GLubyte *dest, const glm::vec3 &source, std::size_t destWidth)
+    {
+        GLhalf *values = reinterpret_cast<GLhalf*>(dest);
+        for (std::size_t i = 0; i < std::min<std::size_t>(destWidth, 3); ++i)
+        {
+            values[i] = ogl::toHalfFloat(source[i]);
+        }
+        if (destWidth == 4)
+        {
+            values[3] = ogl::toHalfFloat(1.0f);
+        }
+    }
+
+    inline void storeSnorm1010102(GLubyte *dest, const glm::vec4 &source)
+    {
+        *reinterpret_cast<GLuint*>(dest) = ogl::packSnorm1010102(source);
+    }
+
+    inline GLfloat *floats(GLubyte *dest)
+    {
+        return reinterpret_cast<GLfloat*>(dest);
+    }
+
+    ogl::GlMeshGeneration checkAndComputeVertexAttributes(const ogl::VertexAttributeDeclarationVector &vads, vfm::ObjModel &objModel, unsigned int nbThreads)
     {
         bool noBufferAvailable = false;
         int nbVertexAttributes = 0;
         for(const ogl::VertexAttributeDeclaration &vad : vads)
         {
+            if (isInstanceAttribute(vad))
+            {
+                continue;
+            }
             switch(toVertexAttributeBuffer(vad))
             {
             case VERTEX_POSITION:
@@ -126,14 +230,14 @@ namespace
             case VERTEX_NORMAL:
                 if (objModel.normals.empty())
                 {
-                    objModel.computeNormals();
+                    objModel.computeNormals(false, nbThreads);
                     noBufferAvailable = objModel.normals.empty();
                 }
                 break;
             case VERTEX_TANGENT:
                 if (objModel.tangents.empty())
                 {
-                    objModel.computeTangents();
+                    objModel.computeTangents(nbThreads);
                     noBufferAvailable = objModel.tangents.empty();
                 }
                 break;
@@ -164,7 +268,78 @@ namespace
         return ogl::GlMeshGeneration::succeeded();
     }
 
-    void fillBuffer(GLfloat *tmpBuffer, ogl::BoundingBox &boundingBox, const vfm::ObjModel &objModel, const VertexAttributeBufferDescVector &vertexAttributeBufferDescVector)
+    // Quantized positions are stored in the bounding box, which must already
+    // contain all of them.
+    void fillVertex(GLubyte *vertex, ogl::BoundingBox &boundingBox, const vfm::ObjModel &objModel, const VertexAttributeBufferDescVector &vertexAttributeBufferDescVector, const vfm::VertexIndex &vertexIndex)
+    {
+        for (const VertexAttributeBufferDesc &vabd : vertexAttributeBufferDescVector)
+        {
+            GLubyte *attribute = &vertex[vabd.offset];
+            switch (vabd.type) {
+            case VERTEX_POSITION:
+                if (vertexIndex.position != 0)
+                {
+                    glm::vec4 position = objModel.position(vertexIndex.position-1);
+                    boundingBox.accept(position.x / position.w, position.y / position.w, position.z / position.w);
+                    if (vabd.glType == GL_FLOAT)
+                    {
+                        copy(floats(attribute), position, vabd.size, true);
+                    }
+                    else
+                    {
+                        storeUnorm16(attribute, glm::vec3(position) / position.w, vabd.size, boundingBox);
+                    }
+                }
+                break;
+            case VERTEX_NORMAL:
+                if (vertexIndex.normal != 0)
+                {
+                    const glm::vec3 &normal = objModel.normals[vertexIndex.normal-1];
+                    if (vabd.glType == GL_FLOAT)
+                    {
+                        copy(floats(attribute), normal, vabd.size);
+                    }
+                    else
+                    {
+                        storeSnorm1010102(attribute, glm::vec4(normal, .0f));
+                    }
+                }
+                break;
+            case VERTEX_TANGENT:
+                if (vertexIndex.normal != 0)
+                {
+                    const glm::vec4 &tangent = objModel.tangents[vertexIndex.normal-1];
+                    if (vabd.glType == GL_FLOAT)
+                    {
+                        copy(floats(attribute), tangent, vabd.size);
+                    }
+                    else
+                    {
+                        storeSnorm1010102(attribute, tangent);
+                    }
+                }
+                break;
+            case VERTEX_TEXTURE_COORD:
+                if (vertexIndex.texture != 0)
+                {
+                    const glm::vec3 &texture = objModel.textures[vertexIndex.texture-1];
+                    if (vabd.glType == GL_FLOAT)
+                    {
+                        copy(floats(attribute), texture, vabd.size);
+                    }
+                    else
+                    {
+                        storeHalfFloats(attribute, texture, vabd.size);
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void fillBuffer(GLubyte *tmpBuffer, ogl::BoundingBox &boundingBox, const vfm::ObjModel &objModel, const VertexAttributeBufferDescVector &vertexAttributeBufferDescVector)
     {
         std::size_t tmpBufferOffset = 0;
         std::size_t vertexAttributesStructureSize = computeVertexAttributesStructureSize(vertexAttributeBufferDescVector);
@@ -173,67 +348,225 @@ namespace
         {
             for(const vfm::VertexIndex &vertexIndex : o.vertexIndices)
             {
-                for (const VertexAttributeBufferDesc &vabd : vertexAttributeBufferDescVector)
-                {
-                    switch (vabd.type) {
-                    case VERTEX_POSITION:
-                        if (vertexIndex.position != 0)
-                        {
-                            const glm::vec4 & position = objModel.positions[vertexIndex.position-1];
-                            copy(&tmpBuffer[tmpBufferOffset + vabd.offset], position, vabd.size, true);
-                            boundingBox.accept(position.x / position.w, position.y / position.w, position.z / position.w);
-                        }
-                        break;
-                    case VERTEX_NORMAL:
-                        if (vertexIndex.normal != 0)
-                        {
-                            copy(&tmpBuffer[tmpBufferOffset + vabd.offset], objModel.normals[vertexIndex.normal-1], vabd.size);
-                        }
-                        break;
-                    case VERTEX_TANGENT:
-                        if (vertexIndex.normal != 0)
-                        {
-                            copy(&tmpBuffer[tmpBufferOffset + vabd.offset], objModel.tangents[vertexIndex.normal-1], vabd.size);
-                        }
-                        break;
-                    case VERTEX_TEXTURE_COORD:
-                        if (vertexIndex.texture != 0)
-                        {
-                            copy(&tmpBuffer[tmpBufferOffset + vabd.offset], objModel.textures[vertexIndex.texture-1], vabd.size);
-                        }
-                        break;
-                    default:
-                        break;
-                    }
-                }
+                fillVertex(&tmpBuffer[tmpBufferOffset], boundingBox, objModel, vertexAttributeBufferDescVector, vertexIndex);
                 tmpBufferOffset += vertexAttributesStructureSize;
             }
         }
     }
 
+    // The buffer is written sequentially, the model vertex indices being
+    // read in the given order.
+    void fillBuffer(GLubyte *tmpBuffer, ogl::BoundingBox &boundingBox, const vfm::ObjModel &objModel, const VertexAttributeBufferDescVector &vertexAttributeBufferDescVector,
+                    const std::vector<GLuint> &vertexOrder)
+    {
+        std::vector<const vfm::VertexIndex*> vertexIndices;
+        vertexIndices.reserve(objModel.nbVertexIndices());
+        for(const vfm::Object &o : objModel.objects)
+        {
+            for(const vfm::VertexIndex &vertexIndex : o.vertexIndices)
+            {
+                vertexIndices.push_back(&vertexIndex);
+            }
+        }
+
+        std::size_t vertexAttributesStructureSize = computeVertexAttributesStructureSize(vertexAttributeBufferDescVector);
+        for (std::size_t i = 0; i < vertexOrder.size(); ++i)
+        {
+            fillVertex(&tmpBuffer[i * vertexAttributesStructureSize], boundingBox, objModel, vertexAttributeBufferDescVector, *vertexIndices[vertexOrder[i]]);
+        }
+    }
+
     template<typename T>
-    void createPackedIndexBufferData(const vfm::ObjModel &objModel, std::size_t nbIndices)
+    void createPackedIndexBufferData(const vfm::ObjModel &objModel, std::size_t nbIndices, std::vector<GLubyte> &data)
     {
-        auto indices = std::unique_ptr<T[]>(new T[nbIndices]);
+        data.resize(nbIndices * sizeof(T));
+        T *indices = reinterpret_cast<T*>(data.data());
         std::size_t i = 0;
         std::size_t startIndex = 0;
         for (const vfm::Object &o : objModel.objects)
         {
-            for(std::size_t index : o.triangles)
+            for(vfm::Index index : o.triangles)
             {
                 indices[i++] = static_cast<T>(startIndex + index);
             }
             startIndex += o.vertexIndices.size();
         }
+    }
 
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, nbIndices * sizeof(T), &indices[0], GL_STATIC_DRAW);
+    // Material group of the triangle indices [first, first + size) of the object, with their bounding box.
+    ogl::MaterialGroup createMaterialGroup(const vfm::ObjModel &objModel, const vfm::Object &o, ogl::MaterialIndex index, std::size_t first, std::size_t size)
+    {
+        ogl::MaterialGroup materialGroup{index, size};
+        for (std::size_t i = first; i < first + size; ++i)
+        {
+            const vfm::VertexIndex &vertexIndex = o.vertexIndices[o.triangles[i]];
+            if (vertexIndex.position != 0)
+            {
+                glm::vec4 position = objModel.position(vertexIndex.position-1);
+                materialGroup.boundingBox.accept(position.x / position.w, position.y / position.w, position.z / position.w);
+            }
+        }
+        return materialGroup;
+    }
+
+    void createMaterialGroups(const vfm::ObjModel &objModel, ogl::MaterialGroupVector &materialGroups)
+    {
+        for(const vfm::Object &o : objModel.objects)
+        {
+            if(o.materialActivations.empty())
+            {
+                materialGroups.push_back(createMaterialGroup(objModel, o, ogl::MaterialHandler::NO_MATERIAL_INDEX, 0, o.triangles.size()));
+            }
+            else
+            {
+                if(o.materialActivations[0].start > 0)
+                {
+                    materialGroups.push_back(createMaterialGroup(objModel, o, ogl::MaterialHandler::NO_MATERIAL_INDEX, 0, o.materialActivations[0].start));
+                }
+                for(const vfm::MaterialActivation &ma : o.materialActivations)
+                {
+                    materialGroups.push_back(createMaterialGroup(objModel, o, ma.materialIndex, ma.start, ma.end - ma.start));
+                }
+            }
+        }
+    }
+
+    void createIndexBufferData(const vfm::ObjModel &objModel, ogl::GlMeshData &data)
+    {
+        std::size_t nbIndices = objModel.nbTriangleVertices();
+
+        if(nbIndices < MAX_GL_UNSIGNED_BYTE)
+        {
+            data.indexFormat = GL_UNSIGNED_BYTE;
+            createPackedIndexBufferData<GLubyte>(objModel, nbIndices, data.indices);
+        }
+        else if(nbIndices < MAX_GL_UNSIGNED_SHORT)
+        {
+            data.indexFormat = GL_UNSIGNED_SHORT;
+            createPackedIndexBufferData<GLushort>(objModel, nbIndices, data.indices);
+        }
+        else
+        {
+            data.indexFormat = GL_UNSIGNED_INT;
+            createPackedIndexBufferData<GLuint>(objModel, nbIndices, data.indices);
+        }
+    }
+
+    template<typename T>
+    void unpack(const std::vector<GLubyte> &packedIndices, std::vector<GLuint> &indices)
+    {
+        const T *begin = reinterpret_cast<const T*>(packedIndices.data());
+        indices.assign(begin, begin + packedIndices.size() / sizeof(T));
+    }
+
+    template<typename T>
+    void pack(const std::vector<GLuint> &indices, std::vector<GLubyte> &packedIndices)
+    {
+        packedIndices.resize(indices.size() * sizeof(T));
+        std::transform(indices.begin(), indices.end(), reinterpret_cast<T*>(packedIndices.data()), [](GLuint index) { return static_cast<T>(index); });
+    }
+
+    std::vector<GLuint> unpackIndices(const ogl::GlMeshData &data)
+    {
+        std::vector<GLuint> indices;
+        switch (data.indexFormat)
+        {
+        case GL_UNSIGNED_BYTE:
+            unpack<GLubyte>(data.indices, indices);
+            break;
+        case GL_UNSIGNED_SHORT:
+            unpack<GLushort>(data.indices, indices);
+            break;
+        default:
+            unpack<GLuint>(data.indices, indices);
+        }
+        return indices;
+    }
+
+    void packIndices(const std::vector<GLuint> &indices, ogl::GlMeshData &data)
+    {
+        switch (data.indexFormat)
+        {
+        case GL_UNSIGNED_BYTE:
+            pack<GLubyte>(indices, data.indices);
+            break;
+        case GL_UNSIGNED_SHORT:
+            pack<GLushort>(indices, data.indices);
+            break;
+        default:
+            pack<GLuint>(indices, data.indices);
+        }
+    }
+
+    // Calls f with the first index and the size of the index ranges which
+    // can be reordered independently: the material groups of all the levels
+    // of detail, or the meshlets for the full detail when there are some.
+    template<typename F>
+    void forEachIndexRange(const ogl::GlMeshData &data, F f)
+    {
+        std::size_t first = 0;
+        for (const ogl::MaterialGroup &materialGroup : data.materialGroups)
+        {
+            if (data.meshlets.empty())
+            {
+                f(first, materialGroup.size);
+            }
+            first += materialGroup.size;
+        }
+        for (const ogl::Meshlet &meshlet : data.meshlets)
+        {
+            f(meshlet.firstIndex, meshlet.nbIndices);
+        }
+        for (const ogl::LevelOfDetail &levelOfDetail : data.levelsOfDetail)
+        {
+            first = levelOfDetail.firstIndex;
+            for (const ogl::MaterialGroup &materialGroup : levelOfDetail.materialGroups)
+            {
+                f(first, materialGroup.size);
+                first += materialGroup.size;
+            }
+        }
+    }
+
+    // Positions of the vertices in model order.
+    void collectVertexPositions(const vfm::ObjModel &objModel, std::vector<glm::vec3> &positions)
+    {
+        for (const vfm::Object &o : objModel.objects)
+        {
+            for (const vfm::VertexIndex &vertexIndex : o.vertexIndices)
+            {
+                glm::vec4 position = vertexIndex.position == 0 ? glm::vec4(.0f) : objModel.position(vertexIndex.position-1);
+                positions.push_back(position.w != .0f ? glm::vec3(position) / position.w : glm::vec3(position));
+            }
+        }
+    }
+
+    // Locks the vertices sharing their position with other vertices, at UV
+    // seams or normal creases.
+    void lockSharedPositions(const vfm::ObjModel &objModel, std::vector<bool> &locked)
+    {
+        std::vector<GLuint> nbVerticesPerPosition(objModel.positions.size() + 1, 0);
+        for (const vfm::Object &o : objModel.objects)
+        {
+            for (const vfm::VertexIndex &vertexIndex : o.vertexIndices)
+            {
+                ++nbVerticesPerPosition[vertexIndex.position];
+            }
+        }
+        for (const vfm::Object &o : objModel.objects)
+        {
+            for (const vfm::VertexIndex &vertexIndex : o.vertexIndices)
+            {
+                locked.push_back(vertexIndex.position == 0 || nbVerticesPerPosition[vertexIndex.position] > 1);
+            }
+        }
     }
 
 }
 
 const ogl::MaterialIndex ogl::MaterialHandler::NO_MATERIAL_INDEX = MAX_UINT;
 
-ogl::GlMesh::MaterialGroup::MaterialGroup(MaterialIndex index, std::size_t size) : index{index}, size{size} {}
+ogl::MaterialGroup::MaterialGroup(MaterialIndex index, std::size_t size) : index{index}, size{size} {}
 
 ogl::BoundingBox::BoundingBox() : min{MAX_FLOAT, MAX_FLOAT, MAX_FLOAT}, max{MIN_FLOAT, MIN_FLOAT, MIN_FLOAT}
 {
@@ -249,31 +582,340 @@ void ogl::BoundingBox::accept(float x, float y, float z)
     max.z = std::max(max.z, z);
 }
 
-ogl::GlMesh::GlMesh() : _vertexArray{0}, _indexFormat{GL_UNSIGNED_SHORT}
+ogl::InstanceBuffer::InstanceBuffer() : _buffer{0}, _nbInstances{0}, _hasColors{false}
 {
 }
 
-void ogl::GlMesh::render(ogl::MaterialHandler *handler)
+ogl::InstanceBuffer::~InstanceBuffer()
 {
-    glBindVertexArray(_vertexArray);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffers[0]);
-    std::for_each(_definedVertexAttributes.begin(), _definedVertexAttributes.end(), glEnableVertexAttribArray);
+    if (_buffer > 0)
+    {
+        StateCache::current().deleteBuffers(1, &_buffer);
+    }
+}
+
+ogl::GlMeshGeneration ogl::InstanceBuffer::upload(const std::vector<glm::mat4> &modelMatrices, const std::vector<glm::vec4> &colors)
+{
+    sys::Duration duration;
+    if (!colors.empty() && colors.size() != modelMatrices.size())
+    {
+        return GlMeshGeneration::failed("Not one color by instance!", duration.elapsed());
+    }
+
+    GlError glError;
+    if (_buffer == 0)
+    {
+        glGenBuffers(1, &_buffer);
+    }
+    // The colors follow the matrices.
+    std::size_t matricesSize = modelMatrices.size() * sizeof(glm::mat4);
+    StateCache::current().bindBuffer(GL_ARRAY_BUFFER, _buffer);
+    glBufferData(GL_ARRAY_BUFFER, matricesSize + colors.size() * sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, matricesSize, modelMatrices.data());
+    glBufferSubData(GL_ARRAY_BUFFER, matricesSize, colors.size() * sizeof(glm::vec4), colors.data());
+    if (glError)
+    {
+        _nbInstances = 0;
+        return GlMeshGeneration::failed(glError.toString("Error during instance buffer upload"), duration.elapsed());
+    }
+    _nbInstances = modelMatrices.size();
+    _hasColors = !colors.empty();
+    return GlMeshGeneration::succeeded(duration.elapsed());
+}
+
+ogl::GlMesh::GlMesh() : _vertexArray{0}, _indexFormat{GL_UNSIGNED_SHORT}, _instanceModelMatrixIndex{-1}, _instanceColorIndex{-1}, _levelOfDetail{0}, _modelViewProjectionMatrix(1.0f),
+    _occlusionCulling{nullptr}, _multiDrawIndirect{false}, _quantizedVertexAttributes{false}
+{
+}
+
+glm::mat4 ogl::GlMesh::dequantizationMatrix() const
+{
+    glm::mat4 matrix(1.0f);
+    if (_quantizedVertexAttributes)
+    {
+        glm::vec3 dimension = _boundingBox.dimension();
+        matrix[0][0] = dimension.x;
+        matrix[1][1] = dimension.y;
+        matrix[2][2] = dimension.z;
+        matrix[3] = glm::vec4(_boundingBox.min, 1.0f);
+    }
+    return matrix;
+}
+
+void ogl::GlMesh::cullMaterialGroups(const glm::mat4 &modelViewProjectionMatrix)
+{
+    cullBoundingBoxes(Frustum(modelViewProjectionMatrix), _materialGroupBoundingBoxes, _visibleMaterialGroups);
+    _modelViewProjectionMatrix = modelViewProjectionMatrix;
+}
+
+void ogl::GlMesh::setOcclusionCulling(OcclusionCulling *occlusionCulling)
+{
+    releaseOcclusionQueries();
+    _occlusionCulling = occlusionCulling;
+}
+
+void ogl::GlMesh::readOcclusionQueries()
+{
+    for (std::size_t group = 0; group < _occlusionQueries.size(); ++group)
+    {
+        bool anySamplesPassed = true;
+        if (_occlusionQueries[group] != 0 && _occlusionCulling->readQuery(_occlusionQueries[group], anySamplesPassed))
+        {
+            _occlusionQueries[group] = 0;
+            _occludedMaterialGroups[group] = anySamplesPassed ? 0 : 1;
+        }
+    }
+}
+
+void ogl::GlMesh::releaseOcclusionQueries()
+{
+    for (GLuint &query : _occlusionQueries)
+    {
+        if (query != 0)
+        {
+            _occlusionCulling->releaseQuery(query);
+            query = 0;
+        }
+    }
+    std::fill(_occludedMaterialGroups.begin(), _occludedMaterialGroups.end(), 0);
+}
+
+void ogl::GlMesh::fillDrawCommands(const DrawCallVector &drawCalls, DrawElementsIndirectCommandVector &commands, std::vector<GLuint> &materialIndices)
+{
+    commands.clear();
+    materialIndices.clear();
+    for (const DrawCall &drawCall : drawCalls)
+    {
+        commands.push_back(DrawElementsIndirectCommand{static_cast<GLuint>(drawCall.nbIndices), 1, static_cast<GLuint>(drawCall.firstIndex), 0, 0});
+        materialIndices.push_back(static_cast<GLuint>(drawCall.materialIndex));
+    }
+}
+
+bool ogl::GlMesh::setMultiDrawIndirect(bool multiDrawIndirect)
+{
+    _multiDrawIndirect = multiDrawIndirect && GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_shader_draw_parameters && GLAD_GL_ARB_shader_storage_buffer_object;
+    return _multiDrawIndirect == multiDrawIndirect;
+}
+
+void ogl::GlMesh::submitDrawCalls(const DrawCallVector &drawCalls, MaterialHandler *handler, RenderStatistics &statistics)
+{
+    if (_multiDrawIndirect)
+    {
+        if (drawCalls.empty())
+        {
+            return;
+        }
+        fillDrawCommands(drawCalls, _drawCommands, _drawMaterialIndices);
+        // The buffers are orphaned as their content changes every frame.
+        StateCache &stateCache = StateCache::current();
+        stateCache.bindBuffer(GL_SHADER_STORAGE_BUFFER, _buffers[DRAW_MATERIAL_INDEX_BUFFER]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, _drawMaterialIndices.size() * sizeof(GLuint), _drawMaterialIndices.data(), GL_STREAM_DRAW);
+        stateCache.bindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_MATERIAL_INDICES_BINDING, _buffers[DRAW_MATERIAL_INDEX_BUFFER]);
+        stateCache.bindBuffer(GL_DRAW_INDIRECT_BUFFER, _buffers[DRAW_COMMAND_BUFFER]);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, _drawCommands.size() * sizeof(DrawElementsIndirectCommand), _drawCommands.data(), GL_STREAM_DRAW);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, _indexFormat, nullptr, static_cast<GLsizei>(_drawCommands.size()), 0);
+        ++statistics.nbDrawCalls;
+        return;
+    }
 
-    std::size_t firstPrimitive = 0;
     std::size_t sizeofIndex = ogl::glSizeof(_indexFormat);
-    for(ogl::GlMesh::MaterialGroup &materialGroup : _materialGroups)
+    for (const DrawCall &drawCall : drawCalls)
+    {
+        if (handler)
+        {
+            handler->use(drawCall.materialIndex);
+        }
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(drawCall.nbIndices), _indexFormat, (void*)(drawCall.firstIndex * sizeofIndex));
+    }
+    statistics.nbDrawCalls += drawCalls.size();
+}
+
+// The index buffer and the enabled vertex attributes being part of the
+// vertex array, binding it is enough. It stays bound after the render.
+void ogl::GlMesh::beginRender()
+{
+    StateCache::current().bindVertexArray(_vertexArray);
+
+    // The instance attributes read their constant values when not instanced.
+    if (_instanceModelMatrixIndex >= 0)
+    {
+        glm::mat4 identity(1.0f);
+        for (GLuint column = 0; column < 4; ++column)
+        {
+            glVertexAttrib4fv(_instanceModelMatrixIndex + column, &identity[column][0]);
+        }
+    }
+    if (_instanceColorIndex >= 0)
+    {
+        glVertexAttrib4f(_instanceColorIndex, 1.0f, 1.0f, 1.0f, 1.0f);
+    }
+}
+
+ogl::RenderStatistics ogl::GlMesh::renderInstanced(const InstanceBuffer &instances, MaterialHandler *handler)
+{
+    RenderStatistics statistics;
+    if (instances.size() == 0)
+    {
+        return statistics;
+    }
+    beginRender();
+
+    std::vector<GLuint> instanceAttributes;
+    StateCache::current().bindBuffer(GL_ARRAY_BUFFER, instances.buffer());
+    if (_instanceModelMatrixIndex >= 0)
+    {
+        for (GLuint column = 0; column < 4; ++column)
+        {
+            instanceAttributes.push_back(_instanceModelMatrixIndex + column);
+            glVertexAttribPointer(instanceAttributes.back(), 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+        }
+    }
+    if (_instanceColorIndex >= 0 && instances.hasColors())
+    {
+        instanceAttributes.push_back(_instanceColorIndex);
+        glVertexAttribPointer(instanceAttributes.back(), 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(instances.size() * sizeof(glm::mat4)));
+    }
+    for (GLuint attribute : instanceAttributes)
+    {
+        glVertexAttribDivisor(attribute, 1);
+        glEnableVertexAttribArray(attribute);
+    }
+
+    const MaterialGroupVector &materialGroups = _levelOfDetail == 0 ? _materialGroups : _levelsOfDetail[_levelOfDetail - 1].materialGroups;
+    std::size_t firstPrimitive = _levelOfDetail == 0 ? 0 : _levelsOfDetail[_levelOfDetail - 1].firstIndex;
+    std::size_t sizeofIndex = ogl::glSizeof(_indexFormat);
+    for (const MaterialGroup &materialGroup : materialGroups)
     {
         if (handler)
         {
             handler->use(materialGroup.index);
         }
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(materialGroup.size), _indexFormat, (void*)(firstPrimitive * sizeofIndex));
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(materialGroup.size), _indexFormat, (void*)(firstPrimitive * sizeofIndex),
+                                          static_cast<GLsizei>(instances.size()), 0);
         firstPrimitive += materialGroup.size;
     }
+    statistics.nbDrawnMaterialGroups = materialGroups.size();
+    statistics.nbDrawCalls = materialGroups.size();
+
+    for (GLuint attribute : instanceAttributes)
+    {
+        glVertexAttribDivisor(attribute, 0);
+        glDisableVertexAttribArray(attribute);
+    }
+    return statistics;
+}
+
+ogl::RenderStatistics ogl::GlMesh::render(ogl::MaterialHandler *handler)
+{
+    beginRender();
+
+    RenderStatistics statistics;
+    if (_levelOfDetail == 0 && !_meshlets.empty())
+    {
+        // The meshlets are already culled against the view frustum.
+        submitDrawCalls(_drawCalls, handler, statistics);
+        statistics.nbDrawnMaterialGroups = static_cast<std::size_t>(std::count(_visibleMaterialGroups.begin(), _visibleMaterialGroups.end(), 1));
+        statistics.nbCulledMaterialGroups = _visibleMaterialGroups.size() - statistics.nbDrawnMaterialGroups;
+    }
+    else
+    {
+        const MaterialGroupVector &materialGroups = _levelOfDetail == 0 ? _materialGroups : _levelsOfDetail[_levelOfDetail - 1].materialGroups;
+        std::size_t firstPrimitive = _levelOfDetail == 0 ? 0 : _levelsOfDetail[_levelOfDetail - 1].firstIndex;
+        bool occlusionCulling = _occlusionCulling && _occlusionCulling->created() && materialGroups.size() <= _occlusionQueries.size();
+        if (occlusionCulling)
+        {
+            readOcclusionQueries();
+        }
+        Frustum frustum(_modelViewProjectionMatrix);
+        auto crossesNearPlane = [&](std::size_t group)
+        {
+            const BoundingBoxArrays &boxes = _materialGroupBoundingBoxes;
+            return frustum.crossesNearPlane(glm::vec3(boxes.minX[group], boxes.minY[group], boxes.minZ[group]),
+                                            glm::vec3(boxes.maxX[group], boxes.maxY[group], boxes.maxZ[group]));
+        };
 
-    std::for_each(_definedVertexAttributes.begin(), _definedVertexAttributes.end(), glDisableVertexAttribArray);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+        _submittedDrawCalls.clear();
+        for (std::size_t group = 0; group < materialGroups.size(); ++group)
+        {
+            if (group < _visibleMaterialGroups.size() && _visibleMaterialGroups[group] == 0)
+            {
+                ++statistics.nbCulledMaterialGroups;
+            }
+            else if (occlusionCulling && _occludedMaterialGroups[group] != 0 && !crossesNearPlane(group))
+            {
+                ++statistics.nbOccludedMaterialGroups;
+            }
+            else
+            {
+                if (occlusionCulling)
+                {
+                    _occludedMaterialGroups[group] = 0;
+                }
+                _submittedDrawCalls.push_back(DrawCall{materialGroups[group].index, firstPrimitive, materialGroups[group].size});
+                ++statistics.nbDrawnMaterialGroups;
+            }
+            firstPrimitive += materialGroups[group].size;
+        }
+        submitDrawCalls(_submittedDrawCalls, handler, statistics);
+
+        if (occlusionCulling)
+        {
+            // The boxes are tested against the depth of the groups drawn, the
+            // results being read in a later frame. A group waiting for its
+            // result is not queried again. Boxes crossing the near plane are
+            // always visible.
+            const BoundingBoxArrays &boxes = _materialGroupBoundingBoxes;
+            _occlusionCulling->beginQueries(_modelViewProjectionMatrix);
+            for (std::size_t group = 0; group < materialGroups.size(); ++group)
+            {
+                if (_visibleMaterialGroups[group] != 0 && _occlusionQueries[group] == 0 && !crossesNearPlane(group))
+                {
+                    _occlusionQueries[group] = _occlusionCulling->queryBox(glm::vec3(boxes.minX[group], boxes.minY[group], boxes.minZ[group]),
+                                                                           glm::vec3(boxes.maxX[group], boxes.maxY[group], boxes.maxZ[group]));
+                    ++statistics.nbOcclusionQueries;
+                }
+            }
+            _occlusionCulling->endQueries();
+            StateCache::current().bindVertexArray(_vertexArray);
+        }
+
+        if (occlusionCulling)
+        {
+            // The occluded groups appearing in this frame are drawn without
+            // waiting for the results on the CPU. Out of a multi draw, the
+            // shader reads the first material index of the buffer, which is
+            // replaced before each draw.
+            std::size_t sizeofIndex = ogl::glSizeof(_indexFormat);
+            if (_multiDrawIndirect)
+            {
+                StateCache::current().bindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_MATERIAL_INDICES_BINDING, _buffers[DRAW_MATERIAL_INDEX_BUFFER]);
+            }
+            firstPrimitive = _levelOfDetail == 0 ? 0 : _levelsOfDetail[_levelOfDetail - 1].firstIndex;
+            for (std::size_t group = 0; group < materialGroups.size(); ++group)
+            {
+                const MaterialGroup &materialGroup = materialGroups[group];
+                if (_visibleMaterialGroups[group] != 0 && _occludedMaterialGroups[group] != 0)
+                {
+                    if (_multiDrawIndirect)
+                    {
+                        GLuint materialIndex = static_cast<GLuint>(materialGroup.index);
+                        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), &materialIndex, GL_STREAM_DRAW);
+                    }
+                    else if (handler)
+                    {
+                        handler->use(materialGroup.index);
+                    }
+                    glBeginConditionalRender(_occlusionQueries[group], GL_QUERY_NO_WAIT);
+                    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(materialGroup.size), _indexFormat, (void*)(firstPrimitive * sizeofIndex));
+                    glEndConditionalRender();
+                    ++statistics.nbDrawCalls;
+                }
+                firstPrimitive += materialGroup.size;
+            }
+        }
+    }
+
+    return statistics;
 }
 
 ogl::GlMesh::~GlMesh()
@@ -283,82 +925,242 @@ ogl::GlMesh::~GlMesh()
 
 void ogl::GlMesh::clear()
 {
-    glBindVertexArray(0);
+    StateCache &stateCache = StateCache::current();
     if (_vertexArray > 0)
     {
-        glDeleteVertexArrays(1, &_vertexArray);
+        stateCache.deleteVertexArrays(1, &_vertexArray);
         _vertexArray = 0;
     }
     if (! _buffers.empty())
     {
-		glDeleteBuffers(static_cast<GLsizei>(_buffers.size()), &_buffers[0]);
+        stateCache.deleteBuffers(static_cast<GLsizei>(_buffers.size()), &_buffers[0]);
         _buffers.clear();
     }
     _boundingBox = {};
-    _definedVertexAttributes.clear();
+    _instanceModelMatrixIndex = -1;
+    _instanceColorIndex = -1;
     _materialGroups.clear();
+    _levelsOfDetail.clear();
+    _levelOfDetail = 0;
+    _meshlets.clear();
+    _drawCalls.clear();
+    _materialGroupBoundingBoxes.clear();
+    _visibleMaterialGroups.clear();
+    releaseOcclusionQueries();
+    _occlusionQueries.clear();
+    _occludedMaterialGroups.clear();
+    _quantizedVertexAttributes = false;
 }
 
-void ogl::GlMesh::createMaterialGroups(const vfm::ObjModel &objModel)
+ogl::GlMeshGeneration ogl::GlMesh::prepare(vfm::ObjModel &objModel, const ogl::VertexAttributeDeclarationVector &vads, GlMeshData &data, const GlMeshOptions &options)
 {
-    for(const vfm::Object &o : objModel.objects)
+    sys::Duration duration;
+    data = GlMeshData();
+    data.quantizedVertexAttributes = options.quantizeVertexAttributes;
+
+    GlMeshGeneration result = checkAndComputeVertexAttributes(vads, objModel, options.nbThreads);
+    if (!result) {
+        return result;
+    }
+
+    createMaterialGroups(objModel, data.materialGroups);
+    fillIndices(objModel, data);
+
+    std::string message;
+    if (!options.levelsOfDetail.empty())
     {
-        if(o.materialActivations.empty())
-        {
-            _materialGroups.push_back(MaterialGroup{MaterialHandler::NO_MATERIAL_INDEX, o.triangles.size()});
-        }
-        else
-        {
-            if(o.materialActivations[0].start > 0)
-            {
-                _materialGroups.push_back(MaterialGroup{MaterialHandler::NO_MATERIAL_INDEX, o.materialActivations[0].start});
-            }
-            for(const vfm::MaterialActivation &ma : o.materialActivations)
-            {
-                _materialGroups.push_back(MaterialGroup{ma.materialIndex, ma.end - ma.start});
-            }
-        }
+        message = generateLevelsOfDetail(objModel, options.levelsOfDetail, data).message();
+    }
+    if (options.buildMeshlets)
+    {
+        message += (message.empty() ? "" : " ") + buildMeshlets(objModel, data).message();
     }
+    if (options.optimizeVertexCache)
+    {
+        message += (message.empty() ? "" : " ") + optimizeVertexCache(data).message();
+    }
+
+    if (options.optimizeVertexFetch)
+    {
+        std::vector<GLuint> vertexOrder = optimizeVertexFetch(data, objModel.nbVertexIndices());
+        fillVertexAttributes(objModel, vads, data, &vertexOrder);
+    }
+    else
+    {
+        fillVertexAttributes(objModel, vads, data);
+    }
+
+    return GlMeshGeneration::succeeded(message, duration.elapsed());
 }
 
-void ogl::GlMesh::createIndexBufferData(const vfm::ObjModel &objModel)
+void ogl::GlMesh::fillVertexAttributes(const vfm::ObjModel &objModel, const ogl::VertexAttributeDeclarationVector &vads, GlMeshData &data,
+                                        const std::vector<GLuint> *vertexOrder)
 {
-    std::size_t nbIndices = objModel.nbTriangleVertices();
+    VertexAttributeBufferDescVector vertexAttributeBufferDescVector = createVertexAttributeBufferDescVector(vads, data.quantizedVertexAttributes);
+    std::size_t vertexAttributesStructureSize = computeVertexAttributesStructureSize(vertexAttributeBufferDescVector);
 
-    if(nbIndices < MAX_GL_UNSIGNED_BYTE)
+    data.boundingBox = BoundingBox();
+    if (data.quantizedVertexAttributes)
     {
-        this->_indexFormat = GL_UNSIGNED_BYTE;
-        createPackedIndexBufferData<GLubyte>(objModel, nbIndices);
+        // Positions are quantized in the bounding box of all the model positions.
+        for (std::size_t i = 0; i < objModel.positions.size(); ++i)
+        {
+            glm::vec4 position = objModel.position(i);
+            data.boundingBox.accept(position.x / position.w, position.y / position.w, position.z / position.w);
+        }
     }
-    else if(nbIndices < MAX_GL_UNSIGNED_SHORT)
+    if (vertexOrder)
     {
-        this->_indexFormat = GL_UNSIGNED_SHORT;
-        createPackedIndexBufferData<GLushort>(objModel, nbIndices);
+        data.vertexAttributes.resize(vertexOrder->size() * vertexAttributesStructureSize);
+        fillBuffer(data.vertexAttributes.data(), data.boundingBox, objModel, vertexAttributeBufferDescVector, *vertexOrder);
     }
     else
     {
-        this->_indexFormat = GL_UNSIGNED_INT;
-        createPackedIndexBufferData<GLuint>(objModel, nbIndices);
+        data.vertexAttributes.resize(objModel.nbVertexIndices() * vertexAttributesStructureSize);
+        fillBuffer(data.vertexAttributes.data(), data.boundingBox, objModel, vertexAttributeBufferDescVector);
     }
 }
 
-ogl::GlMeshGeneration ogl::GlMesh::generate(vfm::ObjModel &objModel, const ogl::VertexAttributeDeclarationVector &vads)
+void ogl::GlMesh::fillIndices(const vfm::ObjModel &objModel, GlMeshData &data)
+{
+    createIndexBufferData(objModel, data);
+}
+
+ogl::GlMeshGeneration ogl::GlMesh::optimizeVertexCache(GlMeshData &data)
 {
-    clear();
     sys::Duration duration;
 
-    GlMeshGeneration result = checkAndComputeVertexAttributes(vads, objModel);
-    if (!result) {
-        return result;
+    std::vector<GLuint> indices = unpackIndices(data);
+    VertexCacheOptimizer optimizer;
+    float nbMissesBefore = .0f;
+    float nbMissesAfter = .0f;
+    float nbTriangles = .0f;
+    forEachIndexRange(data, [&](std::size_t first, std::size_t size)
+    {
+        // The ACMR is weighted by the number of triangles of each range.
+        float nbRangeTriangles = static_cast<float>(size / 3);
+        nbMissesBefore += computeAcmr(&indices[first], size) * nbRangeTriangles;
+        optimizer.optimize(&indices[first], size);
+        nbMissesAfter += computeAcmr(&indices[first], size) * nbRangeTriangles;
+        nbTriangles += nbRangeTriangles;
+    });
+    packIndices(indices, data);
+
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(3) << "ACMR " << (nbTriangles == .0f ? .0f : nbMissesBefore / nbTriangles)
+            << " -> " << (nbTriangles == .0f ? .0f : nbMissesAfter / nbTriangles) << " after vertex cache optimization.";
+    return GlMeshGeneration::succeeded(message.str(), duration.elapsed());
+}
+
+std::vector<GLuint> ogl::GlMesh::optimizeVertexFetch(GlMeshData &data, std::size_t nbVertices)
+{
+    std::vector<GLuint> indices = unpackIndices(data);
+    std::vector<GLuint> vertexOrder = reorderVerticesByFirstUse(indices.data(), indices.size(), nbVertices);
+    packIndices(indices, data);
+    return vertexOrder;
+}
+
+ogl::GlMeshGeneration ogl::GlMesh::generateLevelsOfDetail(const vfm::ObjModel &objModel, const std::vector<float> &ratios, GlMeshData &data)
+{
+    sys::Duration duration;
+
+    std::vector<glm::vec3> positions;
+    std::vector<bool> locked;
+    collectVertexPositions(objModel, positions);
+    lockSharedPositions(objModel, locked);
+
+    // Vertices shared by several material groups keep the groups closed.
+    std::vector<GLuint> indices = unpackIndices(data);
+    std::vector<MaterialIndex> vertexGroups(positions.size(), MAX_UINT);
+    std::size_t first = 0;
+    for (std::size_t group = 0; group < data.materialGroups.size(); ++group)
+    {
+        for (std::size_t i = first; i < first + data.materialGroups[group].size; ++i)
+        {
+            MaterialIndex &vertexGroup = vertexGroups[indices[i]];
+            locked[indices[i]] = locked[indices[i]] || (vertexGroup != MAX_UINT && vertexGroup != group);
+            vertexGroup = static_cast<MaterialIndex>(group);
+        }
+        first += data.materialGroups[group].size;
     }
 
-    createMaterialGroups(objModel);
+    BoundingBox boundingBox;
+    for (const glm::vec3 &position : positions)
+    {
+        boundingBox.accept(position.x, position.y, position.z);
+    }
+    float diagonal = glm::length(boundingBox.dimension());
 
-    VertexAttributeBufferDescVector vertexAttributeBufferDescVector = createVertexAttributeBufferDescVector(vads);
-    std::size_t vertexAttributesStructureSize = computeVertexAttributesStructureSize(vertexAttributeBufferDescVector);
+    // Each level is simplified from the previous one, its error adds the
+    // error of the previous level to bound the distance to the full detail.
+    std::size_t nbIndices = indices.size();
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(1);
+    data.levelsOfDetail.clear();
+    for (float ratio : ratios)
+    {
+        LevelOfDetail levelOfDetail;
+        levelOfDetail.firstIndex = indices.size();
+        float stepError = .0f;
+        std::size_t previousFirst = data.levelsOfDetail.empty() ? 0 : data.levelsOfDetail.back().firstIndex;
+        const MaterialGroupVector &previousGroups = data.levelsOfDetail.empty() ? data.materialGroups : data.levelsOfDetail.back().materialGroups;
+        for (std::size_t group = 0; group < previousGroups.size(); ++group)
+        {
+            const MaterialGroup &fullDetailGroup = data.materialGroups[group];
+            std::size_t targetNbIndices = static_cast<std::size_t>(static_cast<float>(fullDetailGroup.size / 3) * ratio) * 3;
+            float error;
+            std::vector<GLuint> simplified = simplify(&indices[previousFirst], previousGroups[group].size, targetNbIndices, positions, locked, error);
+            stepError = std::max(stepError, diagonal > .0f ? error / diagonal : .0f);
+            levelOfDetail.materialGroups.push_back(MaterialGroup{fullDetailGroup.index, simplified.size()});
+            levelOfDetail.materialGroups.back().boundingBox = fullDetailGroup.boundingBox;
+            previousFirst += previousGroups[group].size;
+            indices.insert(indices.end(), simplified.begin(), simplified.end());
+        }
+        levelOfDetail.error = (data.levelsOfDetail.empty() ? .0f : data.levelsOfDetail.back().error) + stepError;
+        message << (message.tellp() == 0 ? "Levels of detail with " : ", ")
+                << 100.0f * static_cast<float>(indices.size() - levelOfDetail.firstIndex) / static_cast<float>(std::max<std::size_t>(1, nbIndices)) << "%";
+        data.levelsOfDetail.push_back(std::move(levelOfDetail));
+    }
+    packIndices(indices, data);
+
+    message << " of the triangles.";
+    return GlMeshGeneration::succeeded(ratios.empty() ? std::string() : message.str(), duration.elapsed());
+}
+
+std::size_t ogl::GlMesh::selectLevelOfDetail(const LevelOfDetailVector &levelsOfDetail, const BoundingBox &boundingBox,
+                                             const PerspectiveCamera &camera, const glm::mat4 &modelViewMatrix)
+{
+    // Radius of the bounding sphere in view space, the model view matrix may scale the model.
+    float scale = std::max(glm::length(glm::vec3(modelViewMatrix[0])), std::max(glm::length(glm::vec3(modelViewMatrix[1])), glm::length(glm::vec3(modelViewMatrix[2]))));
+    float radius = glm::length(boundingBox.dimension()) * 0.5f * scale;
+    float distance = glm::length(glm::vec3(modelViewMatrix * glm::vec4(boundingBox.center(), 1.0f)));
+    if (distance <= radius || radius <= .0f)
+    {
+        return 0;
+    }
+
+    // Projected size of the bounding box diagonal in pixels.
+    float size = 2.0f * radius * static_cast<float>(camera.viewport().height()) / (2.0f * distance * std::tan(camera.fovy() * 0.5f));
+    std::size_t level = 0;
+    for (std::size_t i = 0; i < levelsOfDetail.size() && levelsOfDetail[i].error * size <= MAX_PIXEL_ERROR; ++i)
+    {
+        level = i + 1;
+    }
+    return level;
+}
+
+void ogl::GlMesh::selectLevelOfDetail(const PerspectiveCamera &camera, const glm::mat4 &modelViewMatrix)
+{
+    _levelOfDetail = selectLevelOfDetail(_levelsOfDetail, _boundingBox, camera, modelViewMatrix);
+}
+
+ogl::GlMeshGeneration ogl::GlMesh::upload(const GlMeshData &data, const ogl::VertexAttributeDeclarationVector &vads)
+{
+    clear();
+    sys::Duration duration;
 
-    std::vector<GLfloat> vertexAttributeBuffer(objModel.nbVertexIndices() * vertexAttributesStructureSize);
-    fillBuffer(vertexAttributeBuffer.data(), _boundingBox, objModel, vertexAttributeBufferDescVector);
+    VertexAttributeBufferDescVector vertexAttributeBufferDescVector = createVertexAttributeBufferDescVector(vads, data.quantizedVertexAttributes);
+    std::size_t vertexAttributesStructureSize = computeVertexAttributesStructureSize(vertexAttributeBufferDescVector);
 
     GlError glError;
 
@@ -368,34 +1170,145 @@ ogl::GlMeshGeneration ogl::GlMesh::generate(vfm::ObjModel &objModel, const ogl::
         return GlMeshGeneration::failed(glError.toString("Error during vertex array generation"), duration.elapsed());
     }
 
-    glBindVertexArray(_vertexArray);
-    _buffers.resize(2);
+    StateCache &stateCache = StateCache::current();
+    stateCache.bindVertexArray(_vertexArray);
+    _buffers.resize(NB_MESH_BUFFERS);
 	glGenBuffers(static_cast<GLsizei>(_buffers.size()), &_buffers[0]);
     if (glError)
     {
-        glBindVertexArray(0);
+        stateCache.bindVertexArray(0);
         return GlMeshGeneration::failed(glError.toString("Error during buffers generation"), duration.elapsed());
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffers[0]);
-    createIndexBufferData(objModel);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    stateCache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffers[INDEX_BUFFER]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size(), data.indices.data(), GL_STATIC_DRAW);
 
-    glBindBuffer(GL_ARRAY_BUFFER, _buffers[1]);
+    stateCache.bindBuffer(GL_ARRAY_BUFFER, _buffers[VERTEX_BUFFER]);
 
     for (VertexAttributeBufferDesc vabd : vertexAttributeBufferDescVector)
     {
-		glVertexAttribPointer(vabd.index, static_cast<GLsizei>(vabd.size), GL_FLOAT, (vabd.type == VERTEX_NORMAL ? GL_TRUE : GL_FALSE), static_cast<GLsizei>(vertexAttributesStructureSize * sizeof(GL_FLOAT)), (void*)(vabd.offset  * sizeof(GL_FLOAT)));
-        _definedVertexAttributes.push_back(vabd.index);
+		glVertexAttribPointer(vabd.index, static_cast<GLsizei>(vabd.size), vabd.glType, vabd.normalized, static_cast<GLsizei>(vertexAttributesStructureSize), (void*)(vabd.offset));
+        glEnableVertexAttribArray(vabd.index);
+    }
+    glBufferData(GL_ARRAY_BUFFER, data.vertexAttributes.size(), data.vertexAttributes.data(), GL_STATIC_DRAW);
+    stateCache.bindVertexArray(0);
+
+    for (const VertexAttributeDeclaration &vad : vads)
+    {
+        if (vad.name() == INSTANCE_MODEL_MATRIX_NAME && vad.type() == GL_FLOAT_MAT4)
+        {
+            _instanceModelMatrixIndex = static_cast<GLint>(vad.index());
+        }
+        else if (vad.name() == INSTANCE_COLOR_NAME && vad.type() == GL_FLOAT_VEC4)
+        {
+            _instanceColorIndex = static_cast<GLint>(vad.index());
+        }
     }
-    glBufferData(GL_ARRAY_BUFFER, vertexAttributeBuffer.size() * sizeof(GLfloat), vertexAttributeBuffer.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
 
     if (glError)
     {
         return GlMeshGeneration::failed(glError.toString("defining vertex attribute"));
     }
 
+    _indexFormat = data.indexFormat;
+    _materialGroups = data.materialGroups;
+    _levelsOfDetail = data.levelsOfDetail;
+    _meshlets = data.meshlets;
+    _quantizedVertexAttributes = data.quantizedVertexAttributes;
+    _drawCalls.clear();
+    std::size_t firstIndex = 0;
+    for (const MaterialGroup &materialGroup : _materialGroups)
+    {
+        _drawCalls.push_back(DrawCall{materialGroup.index, firstIndex, materialGroup.size});
+        firstIndex += materialGroup.size;
+        // Groups without bounding box use the one of the mesh.
+        const BoundingBox &boundingBox = materialGroup.boundingBox.empty() ? data.boundingBox : materialGroup.boundingBox;
+        _materialGroupBoundingBoxes.push_back(boundingBox.min, boundingBox.max);
+    }
+    _visibleMaterialGroups.assign(_materialGroups.size(), 1);
+    _occlusionQueries.assign(_materialGroups.size(), 0);
+    _occludedMaterialGroups.assign(_materialGroups.size(), 0);
+    _boundingBox = data.boundingBox;
+
     return GlMeshGeneration::succeeded(duration.elapsed());
 }
+
+ogl::GlMeshGeneration ogl::GlMesh::buildMeshlets(const vfm::ObjModel &objModel, GlMeshData &data)
+{
+    sys::Duration duration;
+
+    std::vector<glm::vec3> positions;
+    collectVertexPositions(objModel, positions);
+
+    std::vector<GLuint> indices = unpackIndices(data);
+    MeshletBuilder builder;
+    data.meshlets.clear();
+    std::size_t first = 0;
+    for (const MaterialGroup &materialGroup : data.materialGroups)
+    {
+        builder.build(&indices[first], materialGroup.size, first, positions, data.meshlets);
+        first += materialGroup.size;
+    }
+    packIndices(indices, data);
+
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(1) << data.meshlets.size() << " meshlets of "
+            << (data.meshlets.empty() ? .0f : static_cast<float>(first / 3) / static_cast<float>(data.meshlets.size())) << " triangles on average.";
+    return GlMeshGeneration::succeeded(message.str(), duration.elapsed());
+}
+
+ogl::DrawCallVector ogl::GlMesh::cullMeshlets(const MeshletVector &meshlets, const MaterialGroupVector &materialGroups,
+                                              const PerspectiveCamera &camera, const glm::mat4 &modelViewMatrix)
+{
+    MeshletCulling culling(camera.projectionMatrix(), modelViewMatrix);
+    DrawCallVector drawCalls;
+    std::size_t group = 0;
+    std::size_t groupEnd = materialGroups.empty() ? 0 : materialGroups[0].size;
+    for (const Meshlet &meshlet : meshlets)
+    {
+        while (meshlet.firstIndex >= groupEnd && group + 1 < materialGroups.size())
+        {
+            groupEnd += materialGroups[++group].size;
+        }
+        if (!culling.isVisible(meshlet))
+        {
+            continue;
+        }
+
+        MaterialIndex materialIndex = materialGroups[group].index;
+        if (!drawCalls.empty() && drawCalls.back().materialIndex == materialIndex && drawCalls.back().firstIndex + drawCalls.back().nbIndices == meshlet.firstIndex)
+        {
+            drawCalls.back().nbIndices += meshlet.nbIndices;
+        }
+        else
+        {
+            drawCalls.push_back(DrawCall{materialIndex, meshlet.firstIndex, meshlet.nbIndices});
+        }
+    }
+    return drawCalls;
+}
+
+void ogl::GlMesh::cullMeshlets(const PerspectiveCamera &camera, const glm::mat4 &modelViewMatrix)
+{
+    if (!_meshlets.empty())
+    {
+        _drawCalls = cullMeshlets(_meshlets, _materialGroups, camera, modelViewMatrix);
+    }
+}
+
+ogl::GlMeshGeneration ogl::GlMesh::generate(vfm::ObjModel &objModel, const ogl::VertexAttributeDeclarationVector &vads, const GlMeshOptions &options)
+{
+    sys::Duration duration;
+
+    GlMeshData data;
+    GlMeshGeneration preparation = prepare(objModel, vads, data, options);
+    if (!preparation) {
+        return preparation;
+    }
+
+    GlMeshGeneration result = upload(data, vads);
+    if (!result) {
+        return result;
+    }
+    return GlMeshGeneration::succeeded(preparation.message(), duration.elapsed());
+}
@@ -0,0 +1,352 @@
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include "BinaryImage.hpp"
+#include "Duration.hpp"
+#include "FileStatus.hpp"
+#include "MappedFile.hpp"
+#include "GlMeshCache.hpp"
+
+namespace
+{
+
+const char MESH_CACHE_MAGIC[8] = {'V', 'F', 'M', 'G', 'L', 'M', 'S', 'H'};
+const std::uint32_t MESH_CACHE_VERSION = 6;
+
+struct MeshCacheHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t sourceSize;
+    std::int64_t sourceModificationTime;
+    std::uint64_t key;
+    std::uint32_t indexFormat;
+    std::uint32_t quantizedVertexAttributes;
+    float boundingBoxMin[3];
+    float boundingBoxMax[3];
+    std::uint64_t nbVertexAttributeBytes;
+    std::uint64_t nbIndexBytes;
+    std::uint64_t nbMaterialGroups;
+    std::uint64_t nbMaterialIds;
+    std::uint64_t nbLevelsOfDetail;
+    std::uint64_t nbMeshlets;
+};
+
+struct MeshCacheMaterialGroup
+{
+    std::uint64_t index;
+    std::uint64_t size;
+    float boundingBoxMin[3];
+    float boundingBoxMax[3];
+};
+
+struct MeshCacheLevelOfDetail
+{
+    float error;
+    std::uint32_t padding;
+    std::uint64_t firstIndex;
+    std::uint64_t nbMaterialGroups;
+};
+
+struct MeshCacheMeshlet
+{
+    std::uint64_t firstIndex;
+    std::uint64_t nbIndices;
+    float center[3];
+    float radius;
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+struct MeshCacheMaterialId
+{
+    std::uint64_t librarySize;
+    std::uint64_t nameSize;
+};
+
+// FNV-1a
+class CacheKeyHash
+{
+public:
+    CacheKeyHash() : _hash(0xCBF29CE484222325ull)
+    {
+    }
+
+    void add(const void *data, std::size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            _hash = (_hash ^ bytes[i]) * 0x100000001B3ull;
+        }
+    }
+
+    template<typename T>
+    void add(const T &value)
+    {
+        add(&value, sizeof(T));
+    }
+
+    inline std::uint64_t value() const
+    {
+        return _hash;
+    }
+
+private:
+    std::uint64_t _hash;
+};
+
+// The vertex attribute layout and the options changing the prepared data,
+// the number of threads does not.
+std::uint64_t cacheKey(const ogl::VertexAttributeDeclarationVector &vads, const ogl::GlMeshOptions &options)
+{
+    CacheKeyHash hash;
+    hash.add(MESH_CACHE_VERSION);
+    for (const ogl::VertexAttributeDeclaration &vad : vads)
+    {
+        hash.add(vad.index());
+        hash.add(vad.type());
+        hash.add(vad.size());
+        hash.add(vad.name().data(), vad.name().size() + 1);
+    }
+    hash.add(static_cast<std::uint64_t>(options.levelsOfDetail.size()));
+    hash.add(options.levelsOfDetail.data(), options.levelsOfDetail.size() * sizeof(float));
+    hash.add(static_cast<std::uint8_t>(options.optimizeVertexCache));
+    hash.add(static_cast<std::uint8_t>(options.optimizeVertexFetch));
+    hash.add(static_cast<std::uint8_t>(options.buildMeshlets));
+    hash.add(static_cast<std::uint8_t>(options.quantizeVertexAttributes));
+    return hash.value();
+}
+
+void toCache(const ogl::MaterialGroupVector &materialGroups, std::vector<MeshCacheMaterialGroup> &cacheMaterialGroups)
+{
+    cacheMaterialGroups.clear();
+    cacheMaterialGroups.reserve(materialGroups.size());
+    for (const ogl::MaterialGroup &materialGroup : materialGroups)
+    {
+        MeshCacheMaterialGroup cacheMaterialGroup = {materialGroup.index, materialGroup.size, {}, {}};
+        for (int i = 0; i < 3; ++i)
+        {
+            cacheMaterialGroup.boundingBoxMin[i] = materialGroup.boundingBox.min[i];
+            cacheMaterialGroup.boundingBoxMax[i] = materialGroup.boundingBox.max[i];
+        }
+        cacheMaterialGroups.push_back(cacheMaterialGroup);
+    }
+}
+
+void fromCache(const std::vector<MeshCacheMaterialGroup> &cacheMaterialGroups, ogl::MaterialGroupVector &materialGroups)
+{
+    materialGroups.reserve(cacheMaterialGroups.size());
+    for (const MeshCacheMaterialGroup &cacheMaterialGroup : cacheMaterialGroups)
+    {
+        ogl::MaterialGroup materialGroup{static_cast<ogl::MaterialIndex>(cacheMaterialGroup.index), static_cast<std::size_t>(cacheMaterialGroup.size)};
+        for (int i = 0; i < 3; ++i)
+        {
+            materialGroup.boundingBox.min[i] = cacheMaterialGroup.boundingBoxMin[i];
+            materialGroup.boundingBox.max[i] = cacheMaterialGroup.boundingBoxMax[i];
+        }
+        materialGroups.push_back(materialGroup);
+    }
+}
+
+void toCache(const ogl::MeshletVector &meshlets, std::vector<MeshCacheMeshlet> &cacheMeshlets)
+{
+    cacheMeshlets.reserve(meshlets.size());
+    for (const ogl::Meshlet &meshlet : meshlets)
+    {
+        MeshCacheMeshlet cacheMeshlet = {meshlet.firstIndex, meshlet.nbIndices, {}, meshlet.radius, {}, meshlet.coneCutoff};
+        for (int i = 0; i < 3; ++i)
+        {
+            cacheMeshlet.center[i] = meshlet.center[i];
+            cacheMeshlet.coneAxis[i] = meshlet.coneAxis[i];
+        }
+        cacheMeshlets.push_back(cacheMeshlet);
+    }
+}
+
+void fromCache(const std::vector<MeshCacheMeshlet> &cacheMeshlets, ogl::MeshletVector &meshlets)
+{
+    meshlets.reserve(cacheMeshlets.size());
+    for (const MeshCacheMeshlet &cacheMeshlet : cacheMeshlets)
+    {
+        ogl::Meshlet meshlet;
+        meshlet.firstIndex = static_cast<std::size_t>(cacheMeshlet.firstIndex);
+        meshlet.nbIndices = static_cast<std::size_t>(cacheMeshlet.nbIndices);
+        for (int i = 0; i < 3; ++i)
+        {
+            meshlet.center[i] = cacheMeshlet.center[i];
+            meshlet.coneAxis[i] = cacheMeshlet.coneAxis[i];
+        }
+        meshlet.radius = cacheMeshlet.radius;
+        meshlet.coneCutoff = cacheMeshlet.coneCutoff;
+        meshlets.push_back(meshlet);
+    }
+}
+
+bool readLevelsOfDetail(sys::BinaryImageReader &reader, const MeshCacheHeader &header, ogl::LevelOfDetailVector &levelsOfDetail)
+{
+    std::vector<MeshCacheMaterialGroup> materialGroups;
+    for (std::uint64_t i = 0; i < header.nbLevelsOfDetail; ++i)
+    {
+        MeshCacheLevelOfDetail cacheLevelOfDetail;
+        if (!reader.read(cacheLevelOfDetail) || !reader.read(materialGroups, cacheLevelOfDetail.nbMaterialGroups))
+        {
+            return false;
+        }
+        ogl::LevelOfDetail levelOfDetail;
+        levelOfDetail.error = cacheLevelOfDetail.error;
+        levelOfDetail.firstIndex = static_cast<std::size_t>(cacheLevelOfDetail.firstIndex);
+        fromCache(materialGroups, levelOfDetail.materialGroups);
+        levelsOfDetail.push_back(std::move(levelOfDetail));
+    }
+    return true;
+}
+
+bool readMaterialIds(sys::BinaryImageReader &reader, const MeshCacheHeader &header, vfm::MaterialIdVector &materialIds)
+{
+    for (std::uint64_t i = 0; i < header.nbMaterialIds; ++i)
+    {
+        MeshCacheMaterialId cacheMaterialId;
+        vfm::MaterialId materialId;
+        if (!reader.read(cacheMaterialId) ||
+            !reader.read(materialId.library, cacheMaterialId.librarySize) ||
+            !reader.read(materialId.name, cacheMaterialId.nameSize))
+        {
+            return false;
+        }
+        materialIds.push_back(materialId);
+    }
+    return true;
+}
+
+}
+
+std::string ogl::meshCacheFilename(const char *objFilename, const VertexAttributeDeclarationVector &vads, const GlMeshOptions &options)
+{
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(cacheKey(vads, options)));
+    return std::string(objFilename) + "." + hash + ".vfmb";
+}
+
+ogl::GlMeshCaching ogl::saveMeshCache(const char *cacheFilename, const char *sourceFilename, const VertexAttributeDeclarationVector &vads,
+                                      const GlMeshOptions &options, const GlMeshData &data, const vfm::MaterialIdVector &materialIds)
+{
+    sys::Duration duration;
+    sys::FileStatus sourceStatus(sourceFilename);
+    if (!sourceStatus)
+    {
+        return GlMeshCaching::failed("Cannot read source file status!", duration.elapsed());
+    }
+
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.byteOrder = sys::BinaryImage::BYTE_ORDER_MARK;
+    header.sourceSize = sourceStatus.size();
+    header.sourceModificationTime = sourceStatus.modificationTime();
+    header.key = cacheKey(vads, options);
+    header.indexFormat = data.indexFormat;
+    header.quantizedVertexAttributes = data.quantizedVertexAttributes ? 1 : 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        header.boundingBoxMin[i] = data.boundingBox.min[i];
+        header.boundingBoxMax[i] = data.boundingBox.max[i];
+    }
+    header.nbVertexAttributeBytes = data.vertexAttributes.size();
+    header.nbIndexBytes = data.indices.size();
+    header.nbMaterialGroups = data.materialGroups.size();
+    header.nbMaterialIds = materialIds.size();
+    header.nbLevelsOfDetail = data.levelsOfDetail.size();
+    header.nbMeshlets = data.meshlets.size();
+
+    std::vector<MeshCacheMaterialGroup> materialGroups;
+    toCache(data.materialGroups, materialGroups);
+
+    sys::BinaryImageWriter writer(cacheFilename);
+    writer.write(header);
+    writer.write(data.vertexAttributes);
+    writer.write(data.indices);
+    writer.write(materialGroups);
+    for (const LevelOfDetail &levelOfDetail : data.levelsOfDetail)
+    {
+        toCache(levelOfDetail.materialGroups, materialGroups);
+        writer.write(MeshCacheLevelOfDetail{levelOfDetail.error, 0, levelOfDetail.firstIndex, materialGroups.size()});
+        writer.write(materialGroups);
+    }
+    std::vector<MeshCacheMeshlet> meshlets;
+    toCache(data.meshlets, meshlets);
+    writer.write(meshlets);
+    for (const vfm::MaterialId &materialId : materialIds)
+    {
+        writer.write(MeshCacheMaterialId{materialId.library.size(), materialId.name.size()});
+        writer.write(materialId.library);
+        writer.write(materialId.name);
+    }
+
+    if (!writer)
+    {
+        return GlMeshCaching::failed("Cannot write mesh cache file!", duration.elapsed());
+    }
+    return GlMeshCaching::succeeded(duration.elapsed());
+}
+
+ogl::GlMeshGeneration ogl::loadMeshCache(const char *cacheFilename, const char *sourceFilename, const VertexAttributeDeclarationVector &vads,
+                                         const GlMeshOptions &options, GlMeshData &data, vfm::MaterialIdVector &materialIds)
+{
+    sys::Duration duration;
+    sys::MappedFile mappedFile(cacheFilename);
+    if (!mappedFile)
+    {
+        return GlMeshGeneration::failed("Cannot read mesh cache file!", duration.elapsed());
+    }
+
+    sys::BinaryImageReader reader(mappedFile.data(), mappedFile.size());
+    MeshCacheHeader header;
+    if (!reader.read(header) || std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 || header.byteOrder != sys::BinaryImage::BYTE_ORDER_MARK)
+    {
+        return GlMeshGeneration::failed("Invalid mesh cache file!", duration.elapsed());
+    }
+    if (header.version != MESH_CACHE_VERSION || header.key != cacheKey(vads, options))
+    {
+        return GlMeshGeneration::failed("Mesh cache file does not match the vertex attributes and the mesh options!", duration.elapsed());
+    }
+    if ((header.quantizedVertexAttributes != 0) != options.quantizeVertexAttributes)
+    {
+        return GlMeshGeneration::failed("Mesh cache file does not match the vertex attribute format!", duration.elapsed());
+    }
+
+    sys::FileStatus sourceStatus(sourceFilename);
+    if (!sourceStatus || sourceStatus.size() != header.sourceSize || sourceStatus.modificationTime() != header.sourceModificationTime)
+    {
+        return GlMeshGeneration::failed("Mesh cache file is outdated!", duration.elapsed());
+    }
+
+    GlMeshData cachedData;
+    std::vector<MeshCacheMaterialGroup> materialGroups;
+    std::vector<MeshCacheMeshlet> meshlets;
+    vfm::MaterialIdVector cachedMaterialIds;
+    if (!reader.read(cachedData.vertexAttributes, header.nbVertexAttributeBytes) ||
+        !reader.read(cachedData.indices, header.nbIndexBytes) ||
+        !reader.read(materialGroups, header.nbMaterialGroups) ||
+        !readLevelsOfDetail(reader, header, cachedData.levelsOfDetail) ||
+        !reader.read(meshlets, header.nbMeshlets) ||
+        !readMaterialIds(reader, header, cachedMaterialIds))
+    {
+        return GlMeshGeneration::failed("Truncated mesh cache file!", duration.elapsed());
+    }
+
+    cachedData.indexFormat = header.indexFormat;
+    cachedData.quantizedVertexAttributes = header.quantizedVertexAttributes != 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        cachedData.boundingBox.min[i] = header.boundingBoxMin[i];
+        cachedData.boundingBox.max[i] = header.boundingBoxMax[i];
+    }
+    fromCache(materialGroups, cachedData.materialGroups);
+    fromCache(meshlets, cachedData.meshlets);
+
+    data = std::move(cachedData);
+    materialIds = std::move(cachedMaterialIds);
+    return GlMeshGeneration::succeeded(duration.elapsed());
+}
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cmath>
+#include "glm/geometric.hpp"
+#include "MeshSimplifier.hpp"
+
+namespace
+{
+
+using dvec3 = glm::tvec3<double>;
+
+// Collapses changing the orientation of a triangle more than that are rejected.
+const float MIN_NORMAL_COSINE = 0.25f;
+
+// Symmetric matrix A, vector b and constant c of the sum of the squared
+// distances to planes, weighted by the triangle areas.
+struct Quadric
+{
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+
+    static Quadric plane(const dvec3 &n, double d, double weight)
+    {
+        return Quadric{n.x * n.x * weight, n.x * n.y * weight, n.x * n.z * weight, n.y * n.y * weight, n.y * n.z * weight, n.z * n.z * weight,
+                       n.x * d * weight, n.y * d * weight, n.z * d * weight, d * d * weight, weight};
+    }
+
+    Quadric &operator += (const Quadric &q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2;
+        c += q.c;
+        weight += q.weight;
+        return *this;
+    }
+
+    // Mean squared distance of p to the planes.
+    double error(const glm::vec3 &p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + a11 * y * y + 2 * a12 * y * z + a22 * z * z
+                + 2 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > .0 ? std::max(.0, e) / weight : .0;
+    }
+};
+
+struct Collapse
+{
+    double cost;
+    GLuint from;
+    GLuint to;
+
+    bool operator < (const Collapse &collapse) const
+    {
+        return cost < collapse.cost;
+    }
+};
+
+inline glm::vec3 triangleNormal(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+{
+    return glm::cross(b - a, c - a);
+}
+
+}
+
+std::vector<GLuint> ogl::simplify(const GLuint *indices, std::size_t nbIndices, std::size_t targetNbIndices,
+                                  const std::vector<glm::vec3> &positions, const std::vector<bool> &locked, float &error)
+{
+    error = .0f;
+
+    // Local numbering of the vertices of the triangles.
+    std::vector<GLuint> vertices(indices, indices + nbIndices);
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    std::vector<GLuint> triangles(nbIndices);
+    for (std::size_t i = 0; i < nbIndices; ++i)
+    {
+        triangles[i] = static_cast<GLuint>(std::lower_bound(vertices.begin(), vertices.end(), indices[i]) - vertices.begin());
+    }
+    std::size_t nbVertices = vertices.size();
+
+    std::vector<glm::vec3> points(nbVertices);
+    std::vector<bool> fixed(nbVertices);
+    for (std::size_t v = 0; v < nbVertices; ++v)
+    {
+        points[v] = positions[vertices[v]];
+        fixed[v] = locked[vertices[v]];
+    }
+
+    std::vector<Quadric> quadrics(nbVertices, Quadric{});
+    for (std::size_t t = 0; t < nbIndices; t += 3)
+    {
+        dvec3 a(points[triangles[t]]), b(points[triangles[t + 1]]), c(points[triangles[t + 2]]);
+        dvec3 n = glm::cross(b - a, c - a);
+        double length = glm::length(n);
+        if (length > .0)
+        {
+            Quadric q = Quadric::plane(n / length, -glm::dot(n / length, a), length * 0.5);
+            for (int i = 0; i < 3; ++i)
+            {
+                quadrics[triangles[t + i]] += q;
+            }
+        }
+    }
+
+    // Vertices of edges which do not have exactly two triangles are fixed.
+    std::vector<std::pair<GLuint, GLuint>> edges;
+    edges.reserve(nbIndices);
+    for (std::size_t t = 0; t < nbIndices; t += 3)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            GLuint a = triangles[t + i], b = triangles[t + (i + 1) % 3];
+            edges.emplace_back(std::min(a, b), std::max(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (std::size_t i = 0; i < edges.size();)
+    {
+        std::size_t j = i;
+        for (; j < edges.size() && edges[j] == edges[i]; ++j);
+        if (j - i != 2)
+        {
+            fixed[edges[i].first] = true;
+            fixed[edges[i].second] = true;
+        }
+        i = j;
+    }
+
+    std::vector<GLuint> remap(nbVertices);
+    std::vector<bool> dirty(nbVertices);
+    std::vector<std::size_t> firstAdjacentTriangles(nbVertices + 1);
+    std::vector<GLuint> adjacentTriangles;
+    std::vector<Collapse> collapses;
+    double maxCost = .0;
+    bool collapsed = true;
+    while (triangles.size() > targetNbIndices && collapsed)
+    {
+        std::fill(firstAdjacentTriangles.begin(), firstAdjacentTriangles.end(), 0);
+        for (GLuint v : triangles)
+        {
+            ++firstAdjacentTriangles[v + 1];
+        }
+        for (std::size_t v = 0; v < nbVertices; ++v)
+        {
+            firstAdjacentTriangles[v + 1] += firstAdjacentTriangles[v];
+        }
+        adjacentTriangles.resize(triangles.size());
+        std::vector<std::size_t> next(firstAdjacentTriangles.begin(), firstAdjacentTriangles.end() - 1);
+        for (std::size_t i = 0; i < triangles.size(); ++i)
+        {
+            adjacentTriangles[next[triangles[i]]++] = static_cast<GLuint>(i / 3);
+        }
+
+        collapses.clear();
+        for (std::size_t t = 0; t < triangles.size(); t += 3)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                GLuint from = triangles[t + i];
+                GLuint to = triangles[t + (i + 1) % 3];
+                for (int direction = 0; direction < 2; ++direction, std::swap(from, to))
+                {
+                    if (!fixed[from])
+                    {
+                        Quadric q = quadrics[from];
+                        q += quadrics[to];
+                        collapses.push_back(Collapse{q.error(points[to]), from, to});
+                    }
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end());
+
+        for (std::size_t v = 0; v < nbVertices; ++v)
+        {
+            remap[v] = static_cast<GLuint>(v);
+        }
+        std::fill(dirty.begin(), dirty.end(), false);
+        std::size_t nbIndicesLeft = triangles.size();
+        collapsed = false;
+        for (const Collapse &collapse : collapses)
+        {
+            if (nbIndicesLeft <= targetNbIndices)
+            {
+                break;
+            }
+            if (dirty[collapse.from] || dirty[collapse.to])
+            {
+                continue;
+            }
+
+            // Rejects the collapse if a remaining triangle of the removed vertex flips.
+            bool valid = true;
+            std::size_t nbRemovedTriangles = 0;
+            for (std::size_t i = firstAdjacentTriangles[collapse.from]; i < firstAdjacentTriangles[collapse.from + 1] && valid; ++i)
+            {
+                const GLuint *triangle = &triangles[3 * adjacentTriangles[i]];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    ++nbRemovedTriangles;
+                    continue;
+                }
+                glm::vec3 p[3];
+                for (int j = 0; j < 3; ++j)
+                {
+                    p[j] = points[triangle[j]];
+                }
+                glm::vec3 before = triangleNormal(p[0], p[1], p[2]);
+                for (int j = 0; j < 3; ++j)
+                {
+                    p[j] = points[triangle[j] == collapse.from ? collapse.to : triangle[j]];
+                }
+                glm::vec3 after = triangleNormal(p[0], p[1], p[2]);
+                valid = glm::dot(before, after) > MIN_NORMAL_COSINE * glm::length(before) * glm::length(after);
+            }
+            if (!valid)
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            maxCost = std::max(maxCost, collapse.cost);
+            nbIndicesLeft -= 3 * nbRemovedTriangles;
+            collapsed = true;
+            for (std::size_t i = firstAdjacentTriangles[collapse.from]; i < firstAdjacentTriangles[collapse.from + 1]; ++i)
+            {
+                const GLuint *triangle = &triangles[3 * adjacentTriangles[i]];
+                for (int j = 0; j < 3; ++j)
+                {
+                    dirty[triangle[j]] = true;
+                }
+            }
+        }
+
+        std::size_t size = 0;
+        for (std::size_t t = 0; t < triangles.size(); t += 3)
+        {
+            GLuint a = remap[triangles[t]], b = remap[triangles[t + 1]], c = remap[triangles[t + 2]];
+            if (a != b && b != c && c != a)
+            {
+                triangles[size++] = a;
+                triangles[size++] = b;
+                triangles[size++] = c;
+            }
+        }
+        triangles.resize(size);
+    }
+
+    error = static_cast<float>(std::sqrt(maxCost));
+    for (GLuint &v : triangles)
+    {
+        v = vertices[v];
+    }
+    return triangles;
+}
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "glm/geometric.hpp"
+#include "MeshletBuilder.hpp"
+
+namespace
+{
+
+const GLuint NO_VERTEX = std::numeric_limits<GLuint>::max();
+
+// Weight of the normal deviation against the number of vertices added by a triangle.
+const float NORMAL_DEVIATION_WEIGHT = 0.5f;
+
+}
+
+void ogl::MeshletBuilder::build(GLuint *indices, std::size_t nbIndices, std::size_t firstIndex, const std::vector<glm::vec3> &positions, MeshletVector &meshlets)
+{
+    std::size_t nbTriangles = nbIndices / 3;
+    if (nbTriangles == 0)
+    {
+        return;
+    }
+
+    // Vertices are renumbered in order of appearance so that the working
+    // buffers only cover the vertices of the range.
+    _globalVertices.clear();
+    _triangles.resize(3 * nbTriangles);
+    for (std::size_t i = 0; i < 3 * nbTriangles; ++i)
+    {
+        GLuint vertex = indices[i];
+        if (vertex >= _localVertices.size())
+        {
+            _localVertices.resize(vertex + 1, NO_VERTEX);
+        }
+        if (_localVertices[vertex] == NO_VERTEX)
+        {
+            _localVertices[vertex] = static_cast<GLuint>(_globalVertices.size());
+            _globalVertices.push_back(vertex);
+        }
+        _triangles[i] = _localVertices[vertex];
+    }
+    for (GLuint vertex : _globalVertices)
+    {
+        _localVertices[vertex] = NO_VERTEX;
+    }
+    std::size_t nbVertices = _globalVertices.size();
+
+    _triangleNormals.resize(nbTriangles);
+    for (std::size_t triangle = 0; triangle < nbTriangles; ++triangle)
+    {
+        const GLuint *vertices = &_triangles[3 * triangle];
+        const glm::vec3 &p0 = positions[_globalVertices[vertices[0]]];
+        glm::vec3 normal = glm::cross(positions[_globalVertices[vertices[1]]] - p0, positions[_globalVertices[vertices[2]]] - p0);
+        float length = glm::length(normal);
+        _triangleNormals[triangle] = length > .0f ? normal / length : glm::vec3(.0f);
+    }
+
+    _firstAdjacentTriangles.assign(nbVertices + 1, 0);
+    for (GLuint vertex : _triangles)
+    {
+        ++_firstAdjacentTriangles[vertex + 1];
+    }
+    for (std::size_t vertex = 0; vertex < nbVertices; ++vertex)
+    {
+        _firstAdjacentTriangles[vertex + 1] += _firstAdjacentTriangles[vertex];
+    }
+    _adjacentTriangles.resize(3 * nbTriangles);
+    std::vector<std::size_t> nextAdjacentTriangles(_firstAdjacentTriangles.begin(), _firstAdjacentTriangles.end() - 1);
+    for (std::size_t i = 0; i < 3 * nbTriangles; ++i)
+    {
+        _adjacentTriangles[nextAdjacentTriangles[_triangles[i]]++] = static_cast<GLuint>(i / 3);
+    }
+
+    _emitted.assign(nbTriangles, false);
+    _inMeshlet.assign(nbVertices, false);
+    _meshletVertices.clear();
+    _meshletTriangles.clear();
+    _candidates.clear();
+    _meshletNormal = glm::vec3(.0f);
+    _output.clear();
+    _output.reserve(3 * nbTriangles);
+    std::size_t nextUnemitted = 0;
+    for (std::size_t nbEmitted = 0; nbEmitted < nbTriangles; ++nbEmitted)
+    {
+        // Best candidate adjacent to the meshlet, emitted ones being dropped.
+        std::size_t best = 0;
+        int bestNbNewVertices = 4;
+        float bestScore = std::numeric_limits<float>::max();
+        float meshletNormalLength = glm::length(_meshletNormal);
+        glm::vec3 meshletNormal = meshletNormalLength > .0f ? _meshletNormal / meshletNormalLength : glm::vec3(.0f);
+        for (std::size_t i = 0; i < _candidates.size();)
+        {
+            GLuint triangle = _candidates[i];
+            if (_emitted[triangle])
+            {
+                _candidates[i] = _candidates.back();
+                _candidates.pop_back();
+                continue;
+            }
+            const GLuint *vertices = &_triangles[3 * triangle];
+            int nbNewVertices = !_inMeshlet[vertices[0]] + !_inMeshlet[vertices[1]] + !_inMeshlet[vertices[2]];
+            float score = static_cast<float>(nbNewVertices) + NORMAL_DEVIATION_WEIGHT * (1.0f - glm::dot(_triangleNormals[triangle], meshletNormal));
+            if (score < bestScore)
+            {
+                best = triangle;
+                bestNbNewVertices = nbNewVertices;
+                bestScore = score;
+            }
+            ++i;
+        }
+
+        if (_candidates.empty())
+        {
+            // Dead end: the meshlet continues with the next triangle of the range.
+            for (; _emitted[nextUnemitted]; ++nextUnemitted);
+            best = nextUnemitted;
+            const GLuint *vertices = &_triangles[3 * best];
+            bestNbNewVertices = !_inMeshlet[vertices[0]] + !_inMeshlet[vertices[1]] + !_inMeshlet[vertices[2]];
+        }
+
+        if (_meshletTriangles.size() == MAX_MESHLET_TRIANGLES || _meshletVertices.size() + static_cast<std::size_t>(bestNbNewVertices) > MAX_MESHLET_VERTICES)
+        {
+            meshlets.push_back(finishMeshlet(positions));
+            meshlets.back().firstIndex = firstIndex + _output.size() - meshlets.back().nbIndices;
+        }
+        addTriangle(best);
+    }
+    meshlets.push_back(finishMeshlet(positions));
+    meshlets.back().firstIndex = firstIndex + _output.size() - meshlets.back().nbIndices;
+
+    std::copy(_output.begin(), _output.end(), indices);
+}
+
+void ogl::MeshletBuilder::addTriangle(std::size_t triangle)
+{
+    _emitted[triangle] = true;
+    _meshletTriangles.push_back(static_cast<GLuint>(triangle));
+    _meshletNormal += _triangleNormals[triangle];
+    for (std::size_t i = 3 * triangle; i < 3 * triangle + 3; ++i)
+    {
+        GLuint vertex = _triangles[i];
+        if (!_inMeshlet[vertex])
+        {
+            _inMeshlet[vertex] = true;
+            _meshletVertices.push_back(vertex);
+            for (std::size_t j = _firstAdjacentTriangles[vertex]; j < _firstAdjacentTriangles[vertex + 1]; ++j)
+            {
+                if (!_emitted[_adjacentTriangles[j]])
+                {
+                    _candidates.push_back(_adjacentTriangles[j]);
+                }
+            }
+        }
+    }
+}
+
+ogl::Meshlet ogl::MeshletBuilder::finishMeshlet(const std::vector<glm::vec3> &positions)
+{
+    Meshlet meshlet;
+    meshlet.nbIndices = 3 * _meshletTriangles.size();
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    for (GLuint vertex : _meshletVertices)
+    {
+        const glm::vec3 &position = positions[_globalVertices[vertex]];
+        for (int i = 0; i < 3; ++i)
+        {
+            min[i] = std::min(min[i], position[i]);
+            max[i] = std::max(max[i], position[i]);
+        }
+    }
+    meshlet.center = (min + max) * 0.5f;
+    for (GLuint vertex : _meshletVertices)
+    {
+        meshlet.radius = std::max(meshlet.radius, glm::length(positions[_globalVertices[vertex]] - meshlet.center));
+        _inMeshlet[vertex] = false;
+    }
+
+    // The cone axis is the mean direction of the triangles, and the cutoff
+    // the sine of the largest angle between a triangle and the axis.
+    float meshletNormalLength = glm::length(_meshletNormal);
+    if (meshletNormalLength > .0f)
+    {
+        meshlet.coneAxis = _meshletNormal / meshletNormalLength;
+        float minDot = 1.0f;
+        for (GLuint triangle : _meshletTriangles)
+        {
+            if (glm::dot(_triangleNormals[triangle], _triangleNormals[triangle]) > .0f)
+            {
+                minDot = std::min(minDot, glm::dot(_triangleNormals[triangle], meshlet.coneAxis));
+            }
+        }
+        meshlet.coneCutoff = minDot <= .0f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+    }
+
+    for (GLuint triangle : _meshletTriangles)
+    {
+        for (std::size_t i = 3 * triangle; i < 3 * triangle + 3; ++i)
+        {
+            _output.push_back(_globalVertices[_triangles[i]]);
+        }
+    }
+
+    _meshletVertices.clear();
+    _meshletTriangles.clear();
+    _candidates.clear();
+    _meshletNormal = glm::vec3(.0f);
+    return meshlet;
+}
+
+ogl::MeshletCulling::MeshletCulling(const glm::mat4 &projectionMatrix, const glm::mat4 &modelViewMatrix)
+    : _modelViewMatrix(modelViewMatrix), _frustum(projectionMatrix)
+{
+    _scale = std::max(glm::length(glm::vec3(modelViewMatrix[0])), std::max(glm::length(glm::vec3(modelViewMatrix[1])), glm::length(glm::vec3(modelViewMatrix[2]))));
+}
+
+bool ogl::MeshletCulling::isVisible(const Meshlet &meshlet) const
+{
+    glm::vec3 center(_modelViewMatrix * glm::vec4(meshlet.center, 1.0f));
+    float radius = meshlet.radius * _scale;
+    if (!_frustum.intersectsSphere(center, radius))
+    {
+        return false;
+    }
+
+    // The camera is at the origin of the view space: all the triangles face
+    // away when the view direction is inside the cone widened by the sphere.
+    if (meshlet.coneCutoff < 1.0f)
+    {
+        glm::vec3 coneAxis = glm::normalize(glm::vec3(_modelViewMatrix * glm::vec4(meshlet.coneAxis, .0f)));
+        if (glm::dot(center, coneAxis) >= meshlet.coneCutoff * glm::length(center) + radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
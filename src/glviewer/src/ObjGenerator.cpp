@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "Duration.hpp"
+#include "ObjGenerator.hpp"
+
+namespace
+{
+
+// SplitMix64: small, fast and identical on every platform.
+class Random
+{
+public:
+    Random(std::uint64_t seed) : _state(seed)
+    {
+    }
+
+    std::uint64_t next()
+    {
+        std::uint64_t z = (_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // In [0, 1)
+    float nextFloat()
+    {
+        return static_cast<float>(next() >> 40) / static_cast<float>(1ull << 24);
+    }
+
+    std::size_t nextIndex(std::size_t size)
+    {
+        return static_cast<std::size_t>(next() % size);
+    }
+
+private:
+    std::uint64_t _state;
+};
+
+class Writer
+{
+public:
+    Writer(std::ostream &os) : _os(os)
+    {
+    }
+
+    template<typename... T>
+    void printf(const char *format, T... values)
+    {
+        int length = std::snprintf(_line, sizeof(_line), format, values...);
+        _os.write(_line, std::min<std::streamsize>(length, sizeof(_line) - 1));
+    }
+
+    void write(const char *text)
+    {
+        _os << text;
+    }
+
+private:
+    std::ostream &_os;
+    char _line[256];
+};
+
+struct Grid
+{
+    std::size_t width;
+    std::size_t height;
+};
+
+void writeMaterials(const vfm::GeneratorOptions &options, Random &random, std::ostream &mtl)
+{
+    Writer writer(mtl);
+    for (std::size_t i = 0; i < options.nbMaterials; ++i)
+    {
+        writer.printf("newmtl material%zu\n", i);
+        writer.printf("Ns %.6f\n", 10.0f + 90.0f * random.nextFloat());
+        writer.printf("Ka 0.000000 0.000000 0.000000\n");
+        writer.printf("Kd %.6f %.6f %.6f\n", random.nextFloat(), random.nextFloat(), random.nextFloat());
+        writer.printf("Ks 0.500000 0.500000 0.500000\n");
+        writer.printf("d 1.000000\n");
+        writer.printf("illum 2\n");
+        if (options.textureMaps)
+        {
+            writer.printf("map_Kd textures/material%zu_diffuse.png\n", i);
+            writer.printf("map_Bump textures/material%zu_normal.png\n", i);
+        }
+        writer.write("\n");
+    }
+}
+
+void writeVertices(const vfm::GeneratorOptions &options, const Grid &grid, Random &random, Writer &writer)
+{
+    float scale = 1.0f / static_cast<float>(std::max(grid.width, grid.height));
+    for (std::size_t i = 0; i < options.nbVertices; ++i)
+    {
+        float u = static_cast<float>(i % grid.width) * scale;
+        float v = static_cast<float>(i / grid.width) * scale;
+        float bump = 0.02f * random.nextFloat();
+        writer.printf("v %.6f %.6f %.6f\n", u, v, bump);
+        if (options.textureCoordinates)
+        {
+            writer.printf("vt %.6f %.6f\n", u, v);
+        }
+        if (options.normals)
+        {
+            float x = random.nextFloat() * 0.2f - 0.1f;
+            float y = random.nextFloat() * 0.2f - 0.1f;
+            float norm = std::sqrt(x * x + y * y + 1.0f);
+            writer.printf("vn %.6f %.6f %.6f\n", x / norm, y / norm, 1.0f / norm);
+        }
+    }
+}
+
+void writeVertexIndex(const vfm::GeneratorOptions &options, std::size_t index, Writer &writer)
+{
+    long long value = static_cast<long long>(index) + 1;
+    if (options.negativeIndices)
+    {
+        value -= static_cast<long long>(options.nbVertices) + 1;
+    }
+
+    if (options.textureCoordinates && options.normals)
+    {
+        writer.printf(" %lld/%lld/%lld", value, value, value);
+    }
+    else if (options.textureCoordinates)
+    {
+        writer.printf(" %lld/%lld", value, value);
+    }
+    else if (options.normals)
+    {
+        writer.printf(" %lld//%lld", value, value);
+    }
+    else
+    {
+        writer.printf(" %lld", value);
+    }
+}
+
+// The polygon vertices are taken on two consecutive grid rows: the first half
+// from left to right on the upper row, the other half backwards on the lower row.
+void writeFace(const vfm::GeneratorOptions &options, const Grid &grid, std::size_t face, Random &random, Writer &writer)
+{
+    std::size_t nbCellsPerRow = grid.width - 1;
+    std::size_t row = (face / nbCellsPerRow) % (grid.height - 1);
+    std::size_t polygonSize = 3 + random.nextIndex(options.maxPolygonSize - 2);
+    std::size_t nbUpper = (polygonSize + 1) / 2;
+    std::size_t nbLower = polygonSize / 2;
+    std::size_t column = std::min(face % nbCellsPerRow, grid.width - nbUpper);
+
+    writer.write("f");
+    for (std::size_t i = 0; i < nbUpper; ++i)
+    {
+        writeVertexIndex(options, row * grid.width + column + i, writer);
+    }
+    for (std::size_t i = nbLower; i > 0; --i)
+    {
+        writeVertexIndex(options, (row + 1) * grid.width + column + i - 1, writer);
+    }
+    writer.write("\n");
+}
+
+}
+
+vfm::ObjGeneration vfm::generate(const GeneratorOptions &options, std::ostream &obj, std::ostream &mtl)
+{
+    sys::Duration duration;
+    if (options.maxPolygonSize < 3)
+    {
+        return ObjGeneration::failed("Polygons must have at least 3 vertices!", duration.elapsed());
+    }
+
+    Grid grid;
+    grid.width = std::max<std::size_t>(2, static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(options.nbVertices)))));
+    grid.height = options.nbVertices / grid.width;
+    if (grid.height < 2 || (options.maxPolygonSize + 1) / 2 > grid.width)
+    {
+        return ObjGeneration::failed("Not enough vertices for the requested polygons!", duration.elapsed());
+    }
+    if (options.nbObjects == 0 || options.nbObjects > options.nbFaces)
+    {
+        return ObjGeneration::failed("Each object must have at least one face!", duration.elapsed());
+    }
+    if (options.nbMaterials == 0 && options.nbMaterialSwitches > 0)
+    {
+        return ObjGeneration::failed("Material switches need materials!", duration.elapsed());
+    }
+
+    Random random(options.seed);
+    Writer writer(obj);
+    writer.printf("# generated by objgen (seed %llu)\n", static_cast<unsigned long long>(options.seed));
+    if (options.nbMaterials > 0)
+    {
+        writer.printf("mtllib %s\n", options.materialLibrary.c_str());
+        writeMaterials(options, random, mtl);
+    }
+
+    writeVertices(options, grid, random, writer);
+
+    std::size_t nbSwitches = 0;
+    std::size_t nbObjects = 0;
+    for (std::size_t face = 0; face < options.nbFaces; ++face)
+    {
+        if (face * options.nbObjects / options.nbFaces >= nbObjects)
+        {
+            writer.printf("o object%zu\n", nbObjects++);
+        }
+        if (nbSwitches < options.nbMaterialSwitches && face * options.nbMaterialSwitches / options.nbFaces >= nbSwitches)
+        {
+            writer.printf("usemtl material%zu\n", random.nextIndex(options.nbMaterials));
+            ++nbSwitches;
+        }
+        writeFace(options, grid, face, random, writer);
+    }
+
+    if (!obj || !mtl)
+    {
+        return ObjGeneration::failed("Cannot write generated model!", duration.elapsed());
+    }
+    return ObjGeneration::succeeded(duration.elapsed());
+}
@@ -1,86 +1,56 @@
 #include <memory>
+#include <memory_resource>
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <limits>
 #include <sstream>
-#include <map>
+#include <vector>
 #include "glm/geometric.hpp"
+#include "Duration.hpp"
+#include "FloatParser.hpp"
+#include "GeometryKernels.hpp"
 #include "LineReader.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
 #include "ObjModel.hpp"
+#include "VertexIndexIndexer.hpp"
 
 namespace
 {
 
-class VertexIndexIndexer
-{
-public:
-
-    VertexIndexIndexer(vfm::Object *o) : _object{o}
-    {
-    }
+const std::size_t MIN_CHUNK_SIZE = 1024 * 1024;
+const unsigned int CHUNKS_PER_THREAD = 4;
 
-    VertexIndexIndexer& operator = (vfm::Object *o)
-    {
-        if (_object != o)
-        {
-            _vertexIndexMap.clear();
-            _object = o;
-        }
-        return *this;
-    }
-
-    std::size_t operator [](const vfm::VertexIndex &vi)
-    {
-        std::size_t mapSize = _vertexIndexMap.size();
-        std::size_t *index = &_vertexIndexMap[vi];
-        if (_vertexIndexMap.size() > mapSize)
-        {
-            *index = _object->vertexIndices.size();
-            _object->vertexIndices.push_back(vi);
-        }
-        return *index;
-    }
+using vfm::VertexIndexIndexer;
+using vfm::createTriangles;
 
-private:
-    struct VertexIndexComparator {
-        bool operator() (const vfm::VertexIndex &vi1, const vfm::VertexIndex &vi2) const
-        {
-          if (vi1.position == vi2.position)
-          {
-              if(vi1.normal == vi2.normal)
-              {
-                  return vi1.texture < vi2.texture;
-              }
-              return vi1.normal < vi2.normal;
-          }
-          return vi1.position < vi2.position;
-        }
-    };
-    typedef std::map<vfm::VertexIndex, std::size_t, VertexIndexComparator> VertexIndexMap;
-
-    vfm::Object *_object;
-    VertexIndexMap _vertexIndexMap;
-};
+inline bool startsWith(std::string_view line, std::string_view keyword)
+{
+    return line.compare(0, keyword.size(), keyword) == 0;
+}
 
-inline const char *nextToken(const char* l)
+inline std::string_view nextToken(std::string_view line, std::size_t position)
 {
-    const char *start = l;
-    for(; std::isspace(*start) && *start != 0; ++start);
-    return start;
+    const char *start = line.data() + position;
+    const char *end = line.data() + line.size();
+    for(; start != end && std::isspace(*start); ++start);
+    return std::string_view(start, static_cast<std::size_t>(end - start));
 }
 
-inline char* read(const char *line, glm::vec4 &vec4)
+inline const char* read(const char *token, const char *end, glm::vec4 &vec4)
 {
-    const char *token = line;
     vec4.x = vec4.y = vec4.z = 0;
     vec4.w = 1;
-    char *endToken = 0;
-    for (int i = 0; i < 4; ++i)
+    const char *endToken = token;
+    for (int i = 0; i < 4 && token != end; ++i)
     {
-        vec4[i] = static_cast<float>(strtod(token, &endToken));
+        endToken = sys::parseFloat(token, end, vec4[i]);
         token = endToken;
-        if(!std::isspace(*token))
+        if(token == end || !std::isspace(*token))
         {
             break;
         }
@@ -88,16 +58,15 @@ inline char* read(const char *line, glm::vec4 &vec4)
     return endToken;
 }
 
-inline char* read(const char *line, glm::vec3 &vec3)
+inline const char* read(const char *token, const char *end, glm::vec3 &vec3)
 {
-    const char *token = line;
     vec3.x = vec3.y = vec3.z = 0;
-    char *endToken = 0;
-    for (int i = 0; i < 3; ++i)
+    const char *endToken = token;
+    for (int i = 0; i < 3 && token != end; ++i)
     {
-        vec3[i] = static_cast<float>(strtod(token, &endToken));
+        endToken = sys::parseFloat(token, end, vec3[i]);
         token = endToken;
-        if(!std::isspace(*token))
+        if(token == end || !std::isspace(*token))
         {
             break;
         }
@@ -105,69 +74,65 @@ inline char* read(const char *line, glm::vec3 &vec3)
     return endToken;
 }
 
-inline void createTriangles(const vfm::IndexVector &polygons, vfm::IndexVector &triangles)
+inline const char* read(const char *token, const char *end, float &value)
 {
-    std::size_t nbIndices = polygons.size();
-    if (nbIndices < 3)
-    {
-        return;
-    }
+    return sys::parseFloat(token, end, value);
+}
 
-    std::size_t descIndex = nbIndices;
-    std::size_t ascIndex = 2;
+template<typename T>
+inline const char* read(std::string_view line, std::size_t position, T &vec)
+{
+    return read(line.data() + position, line.data() + line.size(), vec);
+}
 
-    std::size_t previous = polygons[0];
-    std::size_t current = polygons[1];
-    std::size_t next = polygons[2];
+struct RawVertexIndex
+{
+    long position;
+    long texture;
+    long normal;
+};
 
-    for(bool asc = false; ascIndex < descIndex; asc = !asc)
-    {
-        triangles.push_back(previous);
-        triangles.push_back(current);
-        triangles.push_back(next);
+typedef std::pmr::vector<RawVertexIndex> RawVertexIndexVector;
 
-        if (asc)
-        {
-            current = next;
-            next = polygons[++ascIndex];
-        }
-        else
-        {
-            current = previous;
-            previous = polygons[--descIndex];
-        }
+inline long readIndex(const char *token, const char *end, char **endToken)
+{
+    if (token == end)
+    {
+        *endToken = const_cast<char*>(token);
+        return 0;
     }
+    return std::strtol(token, endToken, 10);
 }
 
-inline std::size_t readIndex(const char *token, char **endToken, std::size_t nbElements)
+inline vfm::Index resolveIndex(long value, std::size_t nbElements)
 {
-    long value = std::strtol(token, endToken, 10);
-    std::size_t result = 0;
+    vfm::Index result = 0;
     if (value >= 0)
     {
-        result = static_cast<std::size_t>(value);
+        result = static_cast<vfm::Index>(value);
     }
     else
     {
         value += nbElements + 1;
         if (value > 0)
         {
-            result = static_cast<std::size_t>(value);
+            result = static_cast<vfm::Index>(value);
         }
     }
     return result;
 }
 
-void read (const char *line, const vfm::ObjModel &model, vfm::VertexIndexVector &face)
+void read (std::string_view line, std::size_t position, RawVertexIndexVector &face)
 {
-    const char *token = line;
+    const char *token = line.data() + position;
+    const char *end = line.data() + line.size();
     char* endToken = 0;
-    vfm::VertexIndex vertexIndex;
-    while(*token != 0 && std::isspace(*token))
+    RawVertexIndex vertexIndex;
+    while(token != end && std::isspace(*token))
     {
         vertexIndex.normal = vertexIndex.texture = 0;
 
-        vertexIndex.position = readIndex(token, &endToken, model.positions.size());
+        vertexIndex.position = readIndex(token, end, &endToken);
 
         if (token == endToken)
         {
@@ -175,14 +140,14 @@ void read (const char *line, const vfm::ObjModel &model, vfm::VertexIndexVector
         }
 
         token = endToken;
-        if (*endToken == '/')
+        if (token != end && *endToken == '/')
         {
-            vertexIndex.texture = readIndex(++token, &endToken, model.textures.size());
+            vertexIndex.texture = readIndex(++token, end, &endToken);
             token = endToken;
         }
-        if (*endToken == '/')
+        if (token != end && *endToken == '/')
         {
-            vertexIndex.normal = readIndex(++token, &endToken, model.normals.size());
+            vertexIndex.normal = readIndex(++token, end, &endToken);
             token = endToken;
         }
 
@@ -217,125 +182,893 @@ inline void endMaterialActivation(vfm::Object *object)
     }
 }
 
-}
+// Number of elements declared in an OBJ file, counted before parsing.
+struct ObjCapacities
+{
+    ObjCapacities() : nbPositions(0), nbTextures(0), nbNormals(0), objectTriangleVertices(1, 0) {}
 
-std::size_t vfm::ObjModel::nbTriangleVertices() const
+    std::size_t nbPositions;
+    std::size_t nbTextures;
+    std::size_t nbNormals;
+    // Triangle vertices declared after each object statement, the first
+    // element counting the ones declared before any object statement.
+    std::vector<std::size_t> objectTriangleVertices;
+};
+
+ObjCapacities count(const char *data, std::size_t size)
 {
-    std::size_t nb = 0;
-    for (const vfm::Object &o : this->objects)
+    ObjCapacities capacities;
+    sys::LineReader lineReader(data, size);
+    while(lineReader)
     {
-        nb += o.triangles.size();
+        std::string_view line = lineReader.readView();
+        if (startsWith(line, "v "))
+        {
+            ++capacities.nbPositions;
+        }
+        else if (startsWith(line, "vt "))
+        {
+            ++capacities.nbTextures;
+        }
+        else if (startsWith(line, "vn "))
+        {
+            ++capacities.nbNormals;
+        }
+        else if (startsWith(line, "f "))
+        {
+            std::size_t nbCorners = 0;
+            for (std::size_t i = 1; i < line.size(); ++i)
+            {
+                nbCorners += std::isspace(line[i-1]) && !std::isspace(line[i]);
+            }
+            if (nbCorners >= 3)
+            {
+                capacities.objectTriangleVertices.back() += 3 * (nbCorners - 2);
+            }
+        }
+        else if (startsWith(line, "o "))
+        {
+            capacities.objectTriangleVertices.push_back(0);
+        }
     }
-    return nb;
+    return capacities;
 }
 
-std::size_t vfm::ObjModel::nbVertexIndices() const
+class ObjModelBuilder
 {
-    std::size_t nb = 0;
-    for (const vfm::Object &o : this->objects)
+public:
+    ObjModelBuilder(vfm::ObjModel &model, std::pmr::memory_resource *scratch = std::pmr::get_default_resource())
+        : _model(model), _object(nullptr), _vertexIndexIndexer(nullptr, scratch), _currentMaterialIndex(0), _objectFirstPosition(0),
+          _capacities(nullptr), _objectStatement(0), _face(scratch), _polygons(scratch)
     {
-        nb += o.vertexIndices.size();
+        _model.objects.push_back(vfm::Object());
+        _object = &_model.objects.back();
+        _vertexIndexIndexer = _object;
     }
-    return nb;
-}
 
-vfm::VertexIndex::VertexIndex (std::size_t vertex, std::size_t normal, std::size_t texture)
-    : position(vertex), normal(normal), texture(texture)
-{
-}
+    inline std::size_t nbPositions() const
+    {
+        return _model.positions.size();
+    }
 
-bool vfm::VertexIndex::operator == (const VertexIndex &vi) const
-{
-    return this->position == vi.position && this->normal == vi.normal && this->texture == vi.texture;
-}
+    inline std::size_t nbTextures() const
+    {
+        return _model.textures.size();
+    }
 
-std::istream & vfm::operator >> (std::istream &is, ObjModel &model)
+    inline std::size_t nbNormals() const
+    {
+        return _model.normals.size();
+    }
+
+    void object(std::string_view name)
+    {
+        if (!_object->triangles.empty())
+        {
+            endMaterialActivation(_object);
+            _model.objects.push_back(vfm::Object());
+            _object = &_model.objects.back();
+            _vertexIndexIndexer = _object;
+
+            if (_currentMaterialIndex < _model.materialIds.size())
+            {
+                _object->materialActivations.push_back(vfm::MaterialActivation(_currentMaterialIndex));
+            }
+        }
+        _object->name = name;
+        _objectFirstPosition = nbPositions();
+        ++_objectStatement;
+    }
+
+    void position(const glm::vec4 &position)
+    {
+        if (position.w != 1.0f)
+        {
+            _model.positionWeights.push_back(vfm::PositionWeight{static_cast<vfm::Index>(nbPositions()), position.w});
+        }
+        _model.positions.push_back(glm::vec3(position));
+    }
+
+    void texture(const glm::vec3 &texture)
+    {
+        _model.textures.push_back(texture);
+    }
+
+    void normal(const glm::vec3 &normal)
+    {
+        _model.normals.push_back(normal);
+    }
+
+    void face(const RawVertexIndexVector &rawFace)
+    {
+        _face.clear();
+        for (const RawVertexIndex &rawVertexIndex : rawFace)
+        {
+            _face.push_back(vfm::VertexIndex(resolveIndex(rawVertexIndex.position, nbPositions()),
+                                             resolveIndex(rawVertexIndex.normal, nbNormals()),
+                                             resolveIndex(rawVertexIndex.texture, nbTextures())));
+        }
+        face(_face.data(), _face.size());
+    }
+
+    void face(const vfm::VertexIndex *vertexIndices, std::size_t nbVertexIndices)
+    {
+        if (_object->vertexIndices.empty())
+        {
+            // positions declared since the object start are a good estimate of its vertices
+            _vertexIndexIndexer.reserve(nbPositions() - _objectFirstPosition);
+            if (_capacities && _objectStatement < _capacities->objectTriangleVertices.size())
+            {
+                _object->triangles.reserve(_capacities->objectTriangleVertices[_objectStatement]);
+            }
+        }
+
+        _polygons.clear();
+        for(std::size_t i = 0; i < nbVertexIndices; ++i)
+        {
+            _polygons.push_back(_vertexIndexIndexer[vertexIndices[i]]);
+        }
+
+        createTriangles(_polygons.data(), _polygons.size(), _object->triangles);
+    }
+
+    void useMaterial(std::string_view name)
+    {
+        endMaterialActivation(_object);
+        _currentMaterialIndex = getMaterialIndex(_model, vfm::MaterialId(_materialLibrary, std::string(name)));
+        _object->materialActivations.push_back(vfm::MaterialActivation(_currentMaterialIndex, _object->triangles.size()));
+    }
+
+    void materialLibrary(std::string_view name)
+    {
+        _materialLibrary = name;
+    }
+
+    void reserve(const ObjCapacities &capacities)
+    {
+        _model.positions.reserve(_model.positions.size() + capacities.nbPositions);
+        _model.textures.reserve(_model.textures.size() + capacities.nbTextures);
+        _model.normals.reserve(_model.normals.size() + capacities.nbNormals);
+        _capacities = &capacities;
+    }
+
+    void end()
+    {
+        if (_object->triangles.empty()){
+            _model.objects.pop_back();
+        }
+        else
+        {
+            endMaterialActivation(_object);
+        }
+    }
+
+private:
+    vfm::ObjModel &_model;
+    vfm::Object *_object;
+    VertexIndexIndexer _vertexIndexIndexer;
+    vfm::MaterialIndex _currentMaterialIndex;
+    std::size_t _objectFirstPosition;
+    const ObjCapacities *_capacities;
+    std::size_t _objectStatement;
+    std::string _materialLibrary;
+    std::pmr::vector<vfm::VertexIndex> _face;
+    std::pmr::vector<vfm::Index> _polygons;
+};
+
+template<typename Consumer>
+void parse(sys::LineReader &lineReader, Consumer &consumer, std::pmr::memory_resource *scratch = std::pmr::get_default_resource())
 {
     glm::vec3 vec3;
     glm::vec4 vec4;
-    vfm::IndexVector polygons;
-    VertexIndexVector face(10);
-	vfm::MaterialIndex currentMaterialIndex = 0;
-    std::string mtllib;
-    sys::LineReader lineReader(is);
-
-    model.objects.push_back(Object());
-    Object *object = &model.objects.back();
-    VertexIndexIndexer vertexIndexIndexer(object);
+    RawVertexIndexVector face(scratch);
 
     while(lineReader)
     {
-        const char* line = lineReader.read();
+        std::string_view line = lineReader.readView();
 
-        if(!std::strncmp("o ", line, 2))
+        if(startsWith(line, "o "))
         {
-            if (!object->triangles.empty())
-            {
-                endMaterialActivation(object);
-                model.objects.push_back(Object());
-                object = &model.objects.back();
-                vertexIndexIndexer = object;
-
-                if (currentMaterialIndex < model.materialIds.size())
-                {
-                    object->materialActivations.push_back(MaterialActivation(currentMaterialIndex));
-                }
-            }
-            object->name = nextToken(line+2);
+            consumer.object(nextToken(line, 2));
         }
-        else if(!std::strncmp("v ", line, 2))
+        else if(startsWith(line, "v "))
         {
-            read(line+2, vec4);
-            model.positions.push_back(vec4);
+            read(line, 2, vec4);
+            consumer.position(vec4);
         }
-        else if(!std::strncmp("vt ", line, 3))
+        else if(startsWith(line, "vt "))
         {
-            read(line+3, vec3);
+            read(line, 3, vec3);
             // changing texture origin to lower left position
             vec3.y = 1 - vec3.y;
-            model.textures.push_back(vec3);
+            consumer.texture(vec3);
         }
-        else if(!std::strncmp("vn ", line, 3))
+        else if(startsWith(line, "vn "))
         {
-            read(line+3, vec3);
-            model.normals.push_back(vec3);
+            read(line, 3, vec3);
+            consumer.normal(vec3);
         }
-        else if (!std::strncmp("f ", line, 2))
+        else if (startsWith(line, "f "))
         {
             face.clear();
-            read(line+1, model, face);
+            read(line, 1, face);
+            consumer.face(face);
+        }
+        else if (startsWith(line, "usemtl "))
+        {
+            consumer.useMaterial(line.substr(7));
+        }
+        else if (startsWith(line, "mtllib "))
+        {
+            consumer.materialLibrary(nextToken(line, 7));
+        }
+    }
+}
+
+void parse(sys::LineReader &lineReader, vfm::ObjModel &model)
+{
+    ObjModelBuilder builder(model);
+    parse(lineReader, builder);
+    builder.end();
+}
+
+// Content of a line-aligned part of an OBJ file. Faces and other ordered
+// statements are recorded to be replayed once all chunks have been parsed.
+// Relative indices pointing before the chunk are fixed up during the merge.
+class ObjChunk
+{
+public:
+    enum RecordType : unsigned char
+    {
+        FACE,
+        OBJECT,
+        USE_MATERIAL,
+        MATERIAL_LIBRARY
+    };
+
+    struct Record
+    {
+        RecordType type;
+        std::uint32_t size;
+    };
+
+    struct RelativeIndex
+    {
+        std::size_t vertexIndex;
+        vfm::Index vfm::VertexIndex::*component;
+        long value;
+    };
+
+    ObjChunk(const char *begin, const char *end) : _begin(begin), _end(end)
+    {
+    }
 
-            polygons.clear();
-            for(vfm::VertexIndexVector::iterator it = face.begin(); it < face.end(); ++it)
+    void parse()
+    {
+        sys::LineReader lineReader(_begin, static_cast<std::size_t>(_end - _begin));
+        ::parse(lineReader, *this);
+    }
+
+    inline std::size_t nbPositions() const
+    {
+        return _positions.size();
+    }
+
+    inline std::size_t nbTextures() const
+    {
+        return _textures.size();
+    }
+
+    inline std::size_t nbNormals() const
+    {
+        return _normals.size();
+    }
+
+    void object(std::string_view name)
+    {
+        record(OBJECT, name);
+    }
+
+    void position(const glm::vec4 &position)
+    {
+        if (position.w != 1.0f)
+        {
+            _positionWeights.push_back(vfm::PositionWeight{static_cast<vfm::Index>(nbPositions()), position.w});
+        }
+        _positions.push_back(glm::vec3(position));
+    }
+
+    void texture(const glm::vec3 &texture)
+    {
+        _textures.push_back(texture);
+    }
+
+    void normal(const glm::vec3 &normal)
+    {
+        _normals.push_back(normal);
+    }
+
+    void face(const RawVertexIndexVector &rawFace)
+    {
+        for (const RawVertexIndex &rawVertexIndex : rawFace)
+        {
+            vfm::VertexIndex vertexIndex;
+            vertexIndex.position = resolve(rawVertexIndex.position, &vfm::VertexIndex::position, nbPositions());
+            vertexIndex.normal = resolve(rawVertexIndex.normal, &vfm::VertexIndex::normal, nbNormals());
+            vertexIndex.texture = resolve(rawVertexIndex.texture, &vfm::VertexIndex::texture, nbTextures());
+            _vertexIndices.push_back(vertexIndex);
+        }
+        _records.push_back(Record{FACE, static_cast<std::uint32_t>(rawFace.size())});
+    }
+
+    void useMaterial(std::string_view name)
+    {
+        record(USE_MATERIAL, name);
+    }
+
+    void materialLibrary(std::string_view name)
+    {
+        record(MATERIAL_LIBRARY, name);
+    }
+
+    void merge(vfm::ObjModel &model, std::size_t firstPosition, std::size_t firstTexture, std::size_t firstNormal)
+    {
+        std::copy(_positions.begin(), _positions.end(), model.positions.begin() + firstPosition);
+        std::copy(_textures.begin(), _textures.end(), model.textures.begin() + firstTexture);
+        std::copy(_normals.begin(), _normals.end(), model.normals.begin() + firstNormal);
+
+        for (const RelativeIndex &relativeIndex : _relativeIndices)
+        {
+            std::size_t first = relativeIndex.component == &vfm::VertexIndex::position ? firstPosition :
+                                relativeIndex.component == &vfm::VertexIndex::texture ? firstTexture : firstNormal;
+            long index = relativeIndex.value + static_cast<long>(first) + 1;
+            _vertexIndices[relativeIndex.vertexIndex].*relativeIndex.component = index > 0 ? static_cast<vfm::Index>(index) : 0;
+        }
+    }
+
+    // Position weights are sorted: chunks must be merged in order
+    void mergePositionWeights(vfm::ObjModel &model, std::size_t firstPosition) const
+    {
+        for (const vfm::PositionWeight &positionWeight : _positionWeights)
+        {
+            model.positionWeights.push_back(vfm::PositionWeight{static_cast<vfm::Index>(positionWeight.position + firstPosition), positionWeight.w});
+        }
+    }
+
+    template<typename Consumer>
+    void replay(Consumer &consumer) const
+    {
+        const vfm::VertexIndex *vertexIndex = _vertexIndices.data();
+        for (const Record &record : _records)
+        {
+            switch (record.type)
             {
-                polygons.push_back(vertexIndexIndexer[*it]);
+            case FACE:
+                consumer.face(vertexIndex, record.size);
+                vertexIndex += record.size;
+                break;
+            case OBJECT:
+                consumer.object(_names[record.size]);
+                break;
+            case USE_MATERIAL:
+                consumer.useMaterial(_names[record.size]);
+                break;
+            case MATERIAL_LIBRARY:
+                consumer.materialLibrary(_names[record.size]);
+                break;
             }
+        }
+    }
+
+private:
+    void record(RecordType type, std::string_view name)
+    {
+        _records.push_back(Record{type, static_cast<std::uint32_t>(_names.size())});
+        _names.push_back(std::string(name));
+    }
 
-            createTriangles(polygons, object->triangles);
+    vfm::Index resolve(long value, vfm::Index vfm::VertexIndex::*component, std::size_t nbElements)
+    {
+        if (value >= 0)
+        {
+            return static_cast<vfm::Index>(value);
         }
-        else if (!std::strncmp("usemtl ", line, 7))
+        // the number of elements before the chunk is not known yet
+        _relativeIndices.push_back(RelativeIndex{_vertexIndices.size(), component, value + static_cast<long>(nbElements)});
+        return 0;
+    }
+
+    const char *_begin;
+    const char *_end;
+    vfm::Vec3Vector _positions;
+    vfm::PositionWeightVector _positionWeights;
+    vfm::Vec3Vector _normals;
+    vfm::Vec3Vector _textures;
+    vfm::VertexIndexVector _vertexIndices;
+    std::vector<RelativeIndex> _relativeIndices;
+    std::vector<Record> _records;
+    std::vector<std::string> _names;
+};
+
+// Indexes the replayed faces of a chunk without triangulating them, so that
+// both phases can be timed separately.
+class PolygonIndexer
+{
+public:
+    PolygonIndexer(vfm::ObjModel &model) : _model(model), _vertexIndexIndexer(nullptr, std::pmr::get_default_resource())
+    {
+        newObject();
+    }
+
+    void object(std::string_view name)
+    {
+        if (!_model.objects.back().vertexIndices.empty())
         {
-            endMaterialActivation(object);
-            currentMaterialIndex = getMaterialIndex(model, MaterialId(mtllib, line + 7));
-            object->materialActivations.push_back(MaterialActivation(currentMaterialIndex, object->triangles.size()));
+            newObject();
         }
-        else if (!std::strncmp("mtllib ", line, 7))
+        _model.objects.back().name = name;
+    }
+
+    void face(const vfm::VertexIndex *vertexIndices, std::size_t nbVertexIndices)
+    {
+        for(std::size_t i = 0; i < nbVertexIndices; ++i)
         {
-            mtllib = nextToken(line + 7);
+            _polygons.push_back(_vertexIndexIndexer[vertexIndices[i]]);
         }
+        _polygonSizes.push_back(static_cast<vfm::Index>(nbVertexIndices));
     }
 
-    if (object->triangles.empty()){
-        model.objects.pop_back();
+    void useMaterial(std::string_view)
+    {
     }
-    else
+
+    void materialLibrary(std::string_view)
+    {
+    }
+
+    void triangulate()
+    {
+        _objectFirstPolygons.push_back(_polygonSizes.size());
+        const vfm::Index *polygon = _polygons.data();
+        for (std::size_t i = 0; i < _model.objects.size(); ++i)
+        {
+            vfm::Object &object = _model.objects[i];
+            for (std::size_t j = _objectFirstPolygons[i]; j < _objectFirstPolygons[i+1]; ++j)
+            {
+                createTriangles(polygon, _polygonSizes[j], object.triangles);
+                polygon += _polygonSizes[j];
+            }
+        }
+        if (_model.objects.back().triangles.empty())
+        {
+            _model.objects.pop_back();
+        }
+    }
+
+    inline std::size_t nbFaces() const
+    {
+        return _polygonSizes.size();
+    }
+
+private:
+    void newObject()
+    {
+        _model.objects.push_back(vfm::Object());
+        _vertexIndexIndexer = &_model.objects.back();
+        _objectFirstPolygons.push_back(_polygonSizes.size());
+    }
+
+    vfm::ObjModel &_model;
+    VertexIndexIndexer _vertexIndexIndexer;
+    vfm::IndexVector _polygons;
+    vfm::IndexVector _polygonSizes;
+    std::vector<std::size_t> _objectFirstPolygons;
+};
+
+void parse(const char *data, std::size_t size, vfm::ObjModel &model, const vfm::LoadOptions &options)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::memory_resource *scratch = options.scratchArena ? &arena : std::pmr::get_default_resource();
+
+    unsigned int nbThreads = sys::effectiveNbThreads(options.nbThreads);
+    std::size_t nbChunks = std::min<std::size_t>(nbThreads * CHUNKS_PER_THREAD, size / MIN_CHUNK_SIZE);
+    if (nbThreads == 1 || nbChunks <= 1)
+    {
+        ObjCapacities capacities;
+        ObjModelBuilder builder(model, scratch);
+        if (options.reserveCapacities)
+        {
+            capacities = count(data, size);
+            builder.reserve(capacities);
+        }
+        sys::LineReader lineReader(data, size);
+        parse(lineReader, builder, scratch);
+        builder.end();
+        return;
+    }
+
+    std::vector<ObjChunk> chunks;
+    chunks.reserve(nbChunks);
+    const char *end = data + size;
+    const char *chunkBegin = data;
+    for (std::size_t i = 1; i <= nbChunks && chunkBegin != end; ++i)
+    {
+        const char *chunkEnd = std::max(chunkBegin, data + size / nbChunks * i);
+        const char *newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', static_cast<std::size_t>(end - chunkEnd)));
+        chunkEnd = i == nbChunks || newline == nullptr ? end : newline + 1;
+        chunks.push_back(ObjChunk(chunkBegin, chunkEnd));
+        chunkBegin = chunkEnd;
+    }
+
+    sys::parallelFor(chunks.size(), nbThreads, [&chunks](std::size_t i)
+    {
+        chunks[i].parse();
+    });
+
+    std::vector<std::size_t> firstPositions(chunks.size());
+    std::vector<std::size_t> firstTextures(chunks.size());
+    std::vector<std::size_t> firstNormals(chunks.size());
+    std::size_t nbPositions = model.positions.size();
+    std::size_t nbTextures = model.textures.size();
+    std::size_t nbNormals = model.normals.size();
+    for (std::size_t i = 0; i < chunks.size(); ++i)
+    {
+        firstPositions[i] = nbPositions;
+        firstTextures[i] = nbTextures;
+        firstNormals[i] = nbNormals;
+        nbPositions += chunks[i].nbPositions();
+        nbTextures += chunks[i].nbTextures();
+        nbNormals += chunks[i].nbNormals();
+    }
+    model.positions.resize(nbPositions);
+    model.textures.resize(nbTextures);
+    model.normals.resize(nbNormals);
+
+    sys::parallelFor(chunks.size(), nbThreads, [&](std::size_t i)
+    {
+        chunks[i].merge(model, firstPositions[i], firstTextures[i], firstNormals[i]);
+    });
+    for (std::size_t i = 0; i < chunks.size(); ++i)
+    {
+        chunks[i].mergePositionWeights(model, firstPositions[i]);
+    }
+
+    // chunks already know the exact number of positions, textures and normals
+    ObjModelBuilder builder(model, scratch);
+    for (ObjChunk &chunk : chunks)
+    {
+        chunk.replay(builder);
+        chunk = ObjChunk(nullptr, nullptr);
+    }
+    builder.end();
+}
+
+
+const std::size_t MIN_TRIANGLES_PER_TASK = 64 * 1024;
+const std::size_t ELEMENTS_PER_BLOCK = 64 * 1024;
+
+void parallelForBlocks(std::size_t nbElements, unsigned int nbThreads, const std::function<void(std::size_t, std::size_t)> &block)
+{
+    std::size_t nbBlocks = (nbElements + ELEMENTS_PER_BLOCK - 1) / ELEMENTS_PER_BLOCK;
+    sys::parallelFor(nbBlocks, nbThreads, [nbElements, &block](std::size_t i)
+    {
+        block(i * ELEMENTS_PER_BLOCK, std::min(nbElements, (i + 1) * ELEMENTS_PER_BLOCK));
+    });
+}
+
+struct TangentSums
+{
+    glm::vec3 sdir;
+    glm::vec3 tdir;
+
+    TangentSums &operator += (const TangentSums &sums)
+    {
+        sdir += sums.sdir;
+        tdir += sums.tdir;
+        return *this;
+    }
+};
+
+// Sums of the values of a contiguous range of triangles, for the elements they reference.
+template<typename Value>
+struct PartialSums
+{
+    std::size_t first;
+    std::vector<Value> values;
+};
+
+// Triangles whose values are computed together by the geometry kernels.
+struct TriangleBatch
+{
+    const vfm::VertexIndex *vertexIndices[vfm::TRIANGLE_BATCH_SIZE][3];
+    std::size_t size;
+};
+
+inline void setLane(vfm::Vec3Batch &batch, std::size_t lane, const glm::vec3 &v)
+{
+    batch.x[lane] = v.x;
+    batch.y[lane] = v.y;
+    batch.z[lane] = v.z;
+}
+
+// Unused lanes repeat the first triangle so that the kernels only see initialized values.
+void gatherPositions(const vfm::ObjModel &model, const TriangleBatch &batch, vfm::Vec3Batch positions[3])
+{
+    for (std::size_t lane = 0; lane < vfm::TRIANGLE_BATCH_SIZE; ++lane)
+    {
+        const vfm::VertexIndex *const *vertexIndices = batch.vertexIndices[lane < batch.size ? lane : 0];
+        for (int i = 0; i < 3; ++i)
+        {
+            setLane(positions[i], lane, model.positions[vertexIndices[i]->position - 1]);
+        }
+    }
+}
+
+// Missing texture coordinates are gathered as zeros and the lane is not defined.
+void gatherTextures(const vfm::ObjModel &model, const TriangleBatch &batch, vfm::Vec2Batch textures[3], bool defined[])
+{
+    for (std::size_t lane = 0; lane < vfm::TRIANGLE_BATCH_SIZE; ++lane)
+    {
+        const vfm::VertexIndex *const *vertexIndices = batch.vertexIndices[lane < batch.size ? lane : 0];
+        defined[lane] = true;
+        for (int i = 0; i < 3; ++i)
+        {
+            vfm::Index texture = vertexIndices[i]->texture;
+            defined[lane] = defined[lane] && texture != 0;
+            textures[i].x[lane] = texture == 0 ? .0f : model.textures[texture - 1].s;
+            textures[i].y[lane] = texture == 0 ? .0f : model.textures[texture - 1].t;
+        }
+    }
+}
+
+// Adds the value computed for each triangle to the elements referenced by
+// the given vertex index component of its vertices, 0 meaning no element.
+// The values are computed by batches of triangles, batchValues telling which
+// triangles of the batch have a value.
+// Each task sums a contiguous range of triangles in its own partial sums,
+// which only cover the elements referenced by the range, then the partial
+// sums are added in order element block by element block.
+template<typename Value, typename BatchValues>
+void accumulatePerTriangle(vfm::ObjModel &model, vfm::Index vfm::VertexIndex::*component, unsigned int nbThreads, std::vector<Value> &sums, BatchValues batchValues)
+{
+    std::vector<std::size_t> firstTriangles(1, 0);
+    for (const vfm::Object &o : model.objects)
+    {
+        firstTriangles.push_back(firstTriangles.back() + o.triangles.size() / 3);
+    }
+    std::size_t nbTriangles = firstTriangles.back();
+
+    auto forEachTriangle = [&model, &firstTriangles](std::size_t begin, std::size_t end, auto f)
+    {
+        const vfm::VertexIndex *vertexIndices[3];
+        std::size_t object = static_cast<std::size_t>(std::upper_bound(firstTriangles.begin(), firstTriangles.end(), begin) - firstTriangles.begin()) - 1;
+        for (std::size_t triangle = begin; triangle < end; ++object)
+        {
+            const vfm::Object &o = model.objects[object];
+            std::size_t objectEnd = std::min(end, firstTriangles[object + 1]);
+            for (; triangle < objectEnd; ++triangle)
+            {
+                const vfm::Index *indices = &o.triangles[3 * (triangle - firstTriangles[object])];
+                vertexIndices[0] = &o.vertexIndices[indices[0]];
+                vertexIndices[1] = &o.vertexIndices[indices[1]];
+                vertexIndices[2] = &o.vertexIndices[indices[2]];
+                f(vertexIndices);
+            }
+        }
+    };
+
+    auto sum = [&forEachTriangle, component, &batchValues](std::size_t begin, std::size_t end, Value *values, std::size_t first)
+    {
+        TriangleBatch batch;
+        batch.size = 0;
+        Value triangleValues[vfm::TRIANGLE_BATCH_SIZE];
+        bool defined[vfm::TRIANGLE_BATCH_SIZE];
+        auto flush = [&]()
+        {
+            batchValues(batch, triangleValues, defined);
+            for (std::size_t triangle = 0; triangle < batch.size; ++triangle)
+            {
+                for (int i = 0; i < 3 && defined[triangle]; ++i)
+                {
+                    vfm::Index element = batch.vertexIndices[triangle][i]->*component;
+                    if (element != 0)
+                    {
+                        values[element - 1 - first] += triangleValues[triangle];
+                    }
+                }
+            }
+            batch.size = 0;
+        };
+        forEachTriangle(begin, end, [&batch, &flush](const vfm::VertexIndex *vertexIndices[3])
+        {
+            std::copy(vertexIndices, vertexIndices + 3, batch.vertexIndices[batch.size]);
+            if (++batch.size == vfm::TRIANGLE_BATCH_SIZE)
+            {
+                flush();
+            }
+        });
+        if (batch.size > 0)
+        {
+            flush();
+        }
+    };
+
+    std::size_t nbTasks = std::min<std::size_t>(sys::effectiveNbThreads(nbThreads), nbTriangles / MIN_TRIANGLES_PER_TASK);
+    if (nbTasks <= 1)
     {
-        endMaterialActivation(object);
+        sum(0, nbTriangles, sums.data(), 0);
+        return;
     }
 
+    std::vector<PartialSums<Value>> partialSums(nbTasks);
+    sys::parallelFor(nbTasks, nbThreads, [&](std::size_t task)
+    {
+        std::size_t begin = nbTriangles * task / nbTasks;
+        std::size_t end = nbTriangles * (task + 1) / nbTasks;
+        vfm::Index min = std::numeric_limits<vfm::Index>::max();
+        vfm::Index max = 0;
+        forEachTriangle(begin, end, [component, &min, &max](const vfm::VertexIndex *vertexIndices[3])
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                vfm::Index element = vertexIndices[i]->*component;
+                if (element != 0)
+                {
+                    min = std::min(min, element);
+                    max = std::max(max, element);
+                }
+            }
+        });
+
+        PartialSums<Value> &partial = partialSums[task];
+        partial.first = max == 0 ? 0 : min - 1;
+        partial.values.resize(max == 0 ? 0 : max - min + 1);
+        sum(begin, end, partial.values.data(), partial.first);
+    });
+
+    parallelForBlocks(sums.size(), nbThreads, [&partialSums, &sums](std::size_t begin, std::size_t end)
+    {
+        for (const PartialSums<Value> &partial : partialSums)
+        {
+            std::size_t first = std::max(begin, partial.first);
+            std::size_t last = std::min(end, partial.first + partial.values.size());
+            for (std::size_t i = first; i < last; ++i)
+            {
+                sums[i] += partial.values[i - partial.first];
+            }
+        }
+    });
+}
+
+}
+
+std::size_t vfm::ObjModel::nbTriangleVertices() const
+{
+    std::size_t nb = 0;
+    for (const vfm::Object &o : this->objects)
+    {
+        nb += o.triangles.size();
+    }
+    return nb;
+}
+
+std::size_t vfm::ObjModel::nbVertexIndices() const
+{
+    std::size_t nb = 0;
+    for (const vfm::Object &o : this->objects)
+    {
+        nb += o.vertexIndices.size();
+    }
+    return nb;
+}
+
+float vfm::ObjModel::positionWeight(std::size_t index) const
+{
+    auto it = std::lower_bound(positionWeights.begin(), positionWeights.end(), index, [](const PositionWeight &pw, std::size_t i)
+    {
+        return pw.position < i;
+    });
+    return it != positionWeights.end() && it->position == index ? it->w : 1.0f;
+}
+
+vfm::VertexIndex::VertexIndex (Index vertex, Index normal, Index texture)
+    : position(vertex), normal(normal), texture(texture)
+{
+}
+
+bool vfm::VertexIndex::operator == (const VertexIndex &vi) const
+{
+    return this->position == vi.position && this->normal == vi.normal && this->texture == vi.texture;
+}
+
+std::istream & vfm::operator >> (std::istream &is, ObjModel &model)
+{
+    sys::LineReader lineReader(is);
+    parse(lineReader, model);
     return is;
 }
 
+vfm::ObjModelLoading vfm::load(const char *filename, ObjModel &model, const LoadOptions &options)
+{
+    sys::Duration duration;
+    sys::MappedFile mappedFile(filename);
+    if (mappedFile)
+    {
+        parse(mappedFile.data(), mappedFile.size(), model, options);
+        return ObjModelLoading::succeeded(duration.elapsed());
+    }
+
+    std::ifstream is(filename);
+    if (!(is >> model))
+    {
+        return ObjModelLoading::failed("Cannot read file (maybe the path is wrong)!", duration.elapsed());
+    }
+    return ObjModelLoading::succeeded(duration.elapsed());
+}
+
+vfm::ObjModelLoading vfm::profile(const char *filename, ObjModel &model, LoadProfile &profile)
+{
+    sys::Duration duration;
+    sys::Duration phase;
+    sys::MappedFile mappedFile(filename);
+    if (!mappedFile)
+    {
+        return ObjModelLoading::failed("Cannot read file (maybe the path is wrong)!", duration.elapsed());
+    }
+    // touching every page brings the whole file in memory
+    unsigned char checksum = 0;
+    for (std::size_t i = 0; i < mappedFile.size(); i += 4096)
+    {
+        checksum ^= static_cast<unsigned char>(mappedFile.data()[i]);
+    }
+    volatile unsigned char sink = checksum;
+    (void) sink;
+    profile.nbBytes = mappedFile.size();
+    profile.read = phase.elapsedMicroseconds();
+
+    phase = sys::Duration();
+    ObjChunk chunk(mappedFile.data(), mappedFile.data() + mappedFile.size());
+    chunk.parse();
+    model.positions.resize(chunk.nbPositions());
+    model.textures.resize(chunk.nbTextures());
+    model.normals.resize(chunk.nbNormals());
+    chunk.merge(model, 0, 0, 0);
+    chunk.mergePositionWeights(model, 0);
+    profile.tokenize = phase.elapsedMicroseconds();
+
+    phase = sys::Duration();
+    PolygonIndexer indexer(model);
+    chunk.replay(indexer);
+    profile.nbFaces = indexer.nbFaces();
+    profile.index = phase.elapsedMicroseconds();
+
+    phase = sys::Duration();
+    indexer.triangulate();
+    profile.triangulate = phase.elapsedMicroseconds();
+
+    return ObjModelLoading::succeeded(duration.elapsed());
+}
+
 std::istream & vfm::operator >> (std::istream &is, vfm::MaterialMap &materialMap)
 {
     vfm::Material *material = 0;
@@ -343,73 +1076,75 @@ std::istream & vfm::operator >> (std::istream &is, vfm::MaterialMap &materialMap
 
     while(lineReader)
     {
-        const char* line = lineReader.read();
+        std::string_view line = lineReader.readView();
 
-        if (!std::strncmp(line, "newmtl ", 7))
+        if (startsWith(line, "newmtl "))
         {
-            material = &materialMap[std::string(nextToken(line+7))];
+            material = &materialMap[std::string(nextToken(line, 7))];
         }
         else if (material != 0)
         {
-            if (!std::strncmp(line, "Ka ", 3))
+            if (startsWith(line, "Ka "))
             {
-                read(line+3, material->color.ambient);
+                read(line, 3, material->color.ambient);
             }
-            else if (!std::strncmp(line, "Kd ", 3))
+            else if (startsWith(line, "Kd "))
             {
-                read(line+3, material->color.diffuse);
+                read(line, 3, material->color.diffuse);
             }
-            else if (!std::strncmp(line, "Ks ", 3))
+            else if (startsWith(line, "Ks "))
             {
-                read(line+3, material->color.specular);
+                read(line, 3, material->color.specular);
             }
-            else if (!std::strncmp(line, "d ", 2))
+            else if (startsWith(line, "d "))
             {
-                material->color.dissolve = static_cast<float>(std::atof(line+2));
+                read(line, 2, material->color.dissolve);
             }
-            else if (!std::strncmp(line, "Tr ", 3))
+            else if (startsWith(line, "Tr "))
             {
-                material->color.dissolve = static_cast<float>(std::atof(line+3));
+                read(line, 3, material->color.dissolve);
             }
-            else if (!std::strncmp(line, "Ns ", 3))
+            else if (startsWith(line, "Ns "))
             {
-                material->color.specularShininess = static_cast<float>(std::max(0.0, std::min(1000.0, std::atof(line+3))));
+                float shininess;
+                read(line, 3, shininess);
+                material->color.specularShininess = std::max(0.f, std::min(1000.f, shininess));
             }
-            else if (!std::strncmp(line, "map_Ka ", 7))
+            else if (startsWith(line, "map_Ka "))
             {
-                material->map.ambient = nextToken(line + 7);
+                material->map.ambient = nextToken(line, 7);
             }
-            else if (!std::strncmp(line, "map_Kd ", 7))
+            else if (startsWith(line, "map_Kd "))
             {
-                material->map.diffuse = nextToken(line + 7);
+                material->map.diffuse = nextToken(line, 7);
             }
-            else if (!std::strncmp(line, "map_Ks ", 7))
+            else if (startsWith(line, "map_Ks "))
             {
-                material->map.specular = nextToken(line + 7);
+                material->map.specular = nextToken(line, 7);
             }
-            else if (!std::strncmp(line, "map_Ns ", 7))
+            else if (startsWith(line, "map_Ns "))
             {
-                material->map.specularShininess = nextToken(line + 7);
+                material->map.specularShininess = nextToken(line, 7);
             }
-            else if (!std::strncmp(line, "map_d ", 6))
+            else if (startsWith(line, "map_d "))
             {
-                material->map.dissolve = nextToken(line + 6);
+                material->map.dissolve = nextToken(line, 6);
             }
-            else if (!std::strncmp(line, "map_Tr ", 7))
+            else if (startsWith(line, "map_Tr "))
             {
-                material->map.dissolve = nextToken(line + 7);
+                material->map.dissolve = nextToken(line, 7);
             }
-            else if (!std::strncmp(line, "bump ", 5))
+            else if (startsWith(line, "bump "))
             {
-                material->map.normalMapping = nextToken(line + 5);
+                material->map.normalMapping = nextToken(line, 5);
             }
-            else if (!std::strncmp(line, "map_Bump ", 9))
+            else if (startsWith(line, "map_Bump "))
             {
-                material->map.normalMapping = nextToken(line + 9);
+                material->map.normalMapping = nextToken(line, 9);
             }
-            else if (!std::strncmp(line, "disp ", 5))
+            else if (startsWith(line, "disp "))
             {
-                material->map.displacement = nextToken(line + 5);
+                material->map.displacement = nextToken(line, 5);
             }
         }
     }
@@ -418,42 +1153,45 @@ std::istream & vfm::operator >> (std::istream &is, vfm::MaterialMap &materialMap
 }
 
 
-void vfm::ObjModel::computeNormals(bool normalized)
+void vfm::ObjModel::computeNormals(bool normalized, unsigned int nbThreads)
 {
     this->normals.clear();
     this->normals.resize(this->positions.size());
-    VertexIndex *vertexIndices[3];
-    for(Object &o : this->objects)
+
+    accumulatePerTriangle(*this, &VertexIndex::position, nbThreads, this->normals, [this](const TriangleBatch &batch, glm::vec3 normals[], bool defined[])
     {
-        for(IndexVector::iterator it = o.triangles.begin(); it != o.triangles.end(); ++it)
+        Vec3Batch positions[3];
+        Vec3Batch faceNormals;
+        gatherPositions(*this, batch, positions);
+        computeFaceNormals(positions, faceNormals);
+        for (std::size_t i = 0; i < batch.size; ++i)
         {
-            vertexIndices[0] = &o.vertexIndices[*it++];
-            vertexIndices[1] = &o.vertexIndices[*it++];
-            vertexIndices[2] = &o.vertexIndices[*it];
-            glm::vec3 a(this->positions[vertexIndices[0]->position-1]);
-            glm::vec3 b(this->positions[vertexIndices[1]->position-1]);
-            glm::vec3 c(this->positions[vertexIndices[2]->position-1]);
+            normals[i] = glm::vec3(faceNormals.x[i], faceNormals.y[i], faceNormals.z[i]);
+            defined[i] = true;
+        }
+    });
 
-            glm::vec3 normal = glm::normalize(glm::cross(b-a, c-a));
-            for (int i = 0; i < 3; ++i)
-            {
-                std::size_t vertexIndex = vertexIndices[i]->position;
-                this->normals[vertexIndex - 1] += normal;
-                vertexIndices[i]->normal = vertexIndex;
-            }
+    sys::parallelFor(this->objects.size(), nbThreads, [this](std::size_t i)
+    {
+        for (VertexIndex &vertexIndex : this->objects[i].vertexIndices)
+        {
+            vertexIndex.normal = vertexIndex.position;
         }
-    }
+    });
 
     if(normalized)
     {
-        for(glm::vec3 &normal : this->normals)
+        parallelForBlocks(this->normals.size(), nbThreads, [this](std::size_t begin, std::size_t end)
         {
-            normal = glm::normalize(normal);
-        }
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                this->normals[i] = glm::normalize(this->normals[i]);
+            }
+        });
     }
 }
 
-void vfm::ObjModel::computeTangents()
+void vfm::ObjModel::computeTangents(unsigned int nbThreads)
 {
     this->tangents.clear();
     if (this->normals.empty() || this->textures.empty())
@@ -463,62 +1201,44 @@ void vfm::ObjModel::computeTangents()
 
     this->tangents.resize(this->normals.size());
 
-    auto tan1 = std::unique_ptr<glm::vec3[]>(new glm::vec3[this->normals.size()]);
-    auto tan2 = std::unique_ptr<glm::vec3[]>(new glm::vec3[this->normals.size()]);
-
-    VertexIndex *vertexIndices[3];
-    for(Object &o : this->objects)
+    std::vector<TangentSums> tangentSums(this->normals.size());
+    accumulatePerTriangle(*this, &VertexIndex::normal, nbThreads, tangentSums, [this](const TriangleBatch &batch, TangentSums sums[], bool defined[])
     {
-        for(auto it = o.triangles.begin(); it != o.triangles.end(); ++it)
+        Vec3Batch positions[3];
+        Vec2Batch textures[3];
+        Vec3Batch sdir;
+        Vec3Batch tdir;
+        gatherPositions(*this, batch, positions);
+        gatherTextures(*this, batch, textures, defined);
+        computeTangentDirections(positions, textures, sdir, tdir);
+        for (std::size_t i = 0; i < batch.size; ++i)
         {
-            vertexIndices[0] = &o.vertexIndices[*it++];
-            vertexIndices[1] = &o.vertexIndices[*it++];
-            vertexIndices[2] = &o.vertexIndices[*it];
-
-            glm::vec4 a = this->positions[vertexIndices[1]->position-1] - this->positions[vertexIndices[0]->position-1];
-            glm::vec4 b = this->positions[vertexIndices[2]->position-1] - this->positions[vertexIndices[0]->position-1];
-
-            auto textureIndex0 = vertexIndices[0]->texture;
-            auto textureIndex1 = vertexIndices[1]->texture;
-            auto textureIndex2 = vertexIndices[2]->texture;
+            sums[i].sdir = glm::vec3(sdir.x[i], sdir.y[i], sdir.z[i]);
+            sums[i].tdir = glm::vec3(tdir.x[i], tdir.y[i], tdir.z[i]);
+        }
+    });
 
-            if (textureIndex0 == 0 || textureIndex1 == 0 || textureIndex2 == 0)
+    parallelForBlocks(this->normals.size(), nbThreads, [this, &tangentSums](std::size_t begin, std::size_t end)
+    {
+        Vec3Batch normals;
+        Vec3Batch sdir;
+        Vec3Batch tdir;
+        Vec4Batch tangents;
+        for (std::size_t first = begin; first < end; first += TRIANGLE_BATCH_SIZE)
+        {
+            std::size_t size = std::min(TRIANGLE_BATCH_SIZE, end - first);
+            for (std::size_t i = 0; i < TRIANGLE_BATCH_SIZE; ++i)
             {
-                continue;
+                std::size_t element = first + (i < size ? i : 0);
+                setLane(normals, i, this->normals[element]);
+                setLane(sdir, i, tangentSums[element].sdir);
+                setLane(tdir, i, tangentSums[element].tdir);
             }
-
-            glm::vec3 u = this->textures[textureIndex1 -1] - this->textures[textureIndex0 -1];
-            glm::vec3 v = this->textures[textureIndex2 -1] - this->textures[textureIndex0 -1];
-
-            float r = 1.0f / (u.s * v.t - v.s * u.t);
-
-            glm::vec3 sdir{(v.t * a.x - u.t * b.x) * r, (v.t * a.y - u.t * b.y) * r, (v.t * a.z - u.t * b.z) * r};
-            glm::vec3 tdir{(u.s * b.x - v.s * a.x) * r, (u.s * b.y - v.s * a.y) * r, (u.s * b.z - v.s * a.z) * r};
-
-            for(std::size_t i = 0; i < 3; ++i)
+            orthogonalizeTangents(normals, sdir, tdir, tangents);
+            for (std::size_t i = 0; i < size; ++i)
             {
-                auto normalIndex = vertexIndices[i]->normal;
-                if (normalIndex == 0)
-                {
-                    continue;
-                }
-                tan1[normalIndex -1] += sdir;
-                tan2[normalIndex -1] += tdir;
+                this->tangents[first + i] = glm::vec4(tangents.x[i], tangents.y[i], tangents.z[i], tangents.w[i]);
             }
         }
-    }
-
-    for(std::size_t i = 0; i < this->normals.size(); ++i)
-    {
-        glm::vec3 &n = this->normals[i];
-        glm::vec3 &t = tan1[i];
-
-        glm::vec3 xyzTangent = glm::normalize(t - n * glm::dot(n, t));
-        glm::vec4 &tangent = this->tangents[i];
-
-        tangent.x = xyzTangent.x;
-        tangent.y = xyzTangent.y;
-        tangent.z = xyzTangent.z;
-        tangent.w = glm::dot(glm::cross(n, t), tan2[i]) < .0f ? -1.0f : 1.0f;
-    }
+    });
 }
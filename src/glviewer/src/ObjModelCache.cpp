@@ -0,0 +1,212 @@
+#include <cstdint>
+#include <cstring>
+#include "BinaryImage.hpp"
+#include "Duration.hpp"
+#include "FileStatus.hpp"
+#include "MappedFile.hpp"
+#include "ObjModelCache.hpp"
+
+namespace
+{
+
+const char CACHE_MAGIC[8] = {'V', 'F', 'M', 'C', 'A', 'C', 'H', 'E'};
+const std::uint32_t CACHE_VERSION = 1;
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 must be tightly packed");
+static_assert(sizeof(glm::vec4) == 4 * sizeof(float), "glm::vec4 must be tightly packed");
+static_assert(sizeof(vfm::VertexIndex) == 3 * sizeof(vfm::Index), "vfm::VertexIndex must be tightly packed");
+static_assert(sizeof(vfm::PositionWeight) == sizeof(vfm::Index) + sizeof(float), "vfm::PositionWeight must be tightly packed");
+
+struct CacheHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t sourceSize;
+    std::int64_t sourceModificationTime;
+    std::uint64_t nbPositions;
+    std::uint64_t nbPositionWeights;
+    std::uint64_t nbNormals;
+    std::uint64_t nbTextures;
+    std::uint64_t nbTangents;
+    std::uint64_t nbObjects;
+    std::uint64_t nbMaterialIds;
+};
+
+struct CacheObject
+{
+    std::uint64_t nameSize;
+    std::uint64_t nbVertexIndices;
+    std::uint64_t nbTriangles;
+    std::uint64_t nbMaterialActivations;
+};
+
+struct CacheMaterialActivation
+{
+    std::uint64_t materialIndex;
+    std::uint64_t start;
+    std::uint64_t end;
+};
+
+struct CacheMaterialId
+{
+    std::uint64_t librarySize;
+    std::uint64_t nameSize;
+};
+
+bool readObjects(sys::BinaryImageReader &reader, const CacheHeader &header, vfm::ObjModel &model)
+{
+    if (header.nbObjects > reader.remaining() / sizeof(CacheObject))
+    {
+        return false;
+    }
+    model.objects.resize(static_cast<std::size_t>(header.nbObjects));
+    std::vector<CacheMaterialActivation> materialActivations;
+    for (vfm::Object &object : model.objects)
+    {
+        CacheObject cacheObject;
+        if (!reader.read(cacheObject) ||
+            !reader.read(object.name, cacheObject.nameSize) ||
+            !reader.read(object.vertexIndices, cacheObject.nbVertexIndices) ||
+            !reader.read(object.triangles, cacheObject.nbTriangles) ||
+            !reader.read(materialActivations, cacheObject.nbMaterialActivations))
+        {
+            return false;
+        }
+        object.materialActivations.clear();
+        object.materialActivations.reserve(materialActivations.size());
+        for (const CacheMaterialActivation &ma : materialActivations)
+        {
+            object.materialActivations.push_back(vfm::MaterialActivation(static_cast<vfm::MaterialIndex>(ma.materialIndex),
+                                                                         static_cast<std::size_t>(ma.start),
+                                                                         static_cast<std::size_t>(ma.end)));
+        }
+    }
+    return true;
+}
+
+bool readMaterialIds(sys::BinaryImageReader &reader, const CacheHeader &header, vfm::ObjModel &model)
+{
+    for (std::uint64_t i = 0; i < header.nbMaterialIds; ++i)
+    {
+        CacheMaterialId cacheMaterialId;
+        vfm::MaterialId materialId;
+        if (!reader.read(cacheMaterialId) ||
+            !reader.read(materialId.library, cacheMaterialId.librarySize) ||
+            !reader.read(materialId.name, cacheMaterialId.nameSize))
+        {
+            return false;
+        }
+        model.materialIds.push_back(materialId);
+    }
+    return true;
+}
+
+}
+
+std::string vfm::cacheFilename(const char *objFilename)
+{
+    return std::string(objFilename) + ".vfmc";
+}
+
+vfm::ObjModelCaching vfm::saveCache(const char *cacheFilename, const char *sourceFilename, const ObjModel &model)
+{
+    sys::Duration duration;
+    sys::FileStatus sourceStatus(sourceFilename);
+    if (!sourceStatus)
+    {
+        return ObjModelCaching::failed("Cannot read source file status!", duration.elapsed());
+    }
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.byteOrder = sys::BinaryImage::BYTE_ORDER_MARK;
+    header.sourceSize = sourceStatus.size();
+    header.sourceModificationTime = sourceStatus.modificationTime();
+    header.nbPositions = model.positions.size();
+    header.nbPositionWeights = model.positionWeights.size();
+    header.nbNormals = model.normals.size();
+    header.nbTextures = model.textures.size();
+    header.nbTangents = model.tangents.size();
+    header.nbObjects = model.objects.size();
+    header.nbMaterialIds = model.materialIds.size();
+
+    sys::BinaryImageWriter writer(cacheFilename);
+    writer.write(header);
+    writer.write(model.positions);
+    writer.write(model.positionWeights);
+    writer.write(model.normals);
+    writer.write(model.textures);
+    writer.write(model.tangents);
+
+    std::vector<CacheMaterialActivation> materialActivations;
+    for (const Object &object : model.objects)
+    {
+        writer.write(CacheObject{object.name.size(), object.vertexIndices.size(), object.triangles.size(), object.materialActivations.size()});
+        writer.write(object.name);
+        writer.write(object.vertexIndices);
+        writer.write(object.triangles);
+        materialActivations.clear();
+        for (const MaterialActivation &ma : object.materialActivations)
+        {
+            materialActivations.push_back(CacheMaterialActivation{ma.materialIndex, ma.start, ma.end});
+        }
+        writer.write(materialActivations);
+    }
+
+    for (const MaterialId &materialId : model.materialIds)
+    {
+        writer.write(CacheMaterialId{materialId.library.size(), materialId.name.size()});
+        writer.write(materialId.library);
+        writer.write(materialId.name);
+    }
+
+    if (!writer)
+    {
+        return ObjModelCaching::failed("Cannot write cache file!", duration.elapsed());
+    }
+    return ObjModelCaching::succeeded(duration.elapsed());
+}
+
+vfm::ObjModelLoading vfm::loadCache(const char *cacheFilename, const char *sourceFilename, ObjModel &model)
+{
+    sys::Duration duration;
+    sys::MappedFile mappedFile(cacheFilename);
+    if (!mappedFile)
+    {
+        return ObjModelLoading::failed("Cannot read cache file!", duration.elapsed());
+    }
+
+    sys::BinaryImageReader reader(mappedFile.data(), mappedFile.size());
+    CacheHeader header;
+    if (!reader.read(header) || std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.byteOrder != sys::BinaryImage::BYTE_ORDER_MARK)
+    {
+        return ObjModelLoading::failed("Invalid cache file!", duration.elapsed());
+    }
+    if (header.version != CACHE_VERSION)
+    {
+        return ObjModelLoading::failed("Unsupported cache file version!", duration.elapsed());
+    }
+
+    sys::FileStatus sourceStatus(sourceFilename);
+    if (!sourceStatus || sourceStatus.size() != header.sourceSize || sourceStatus.modificationTime() != header.sourceModificationTime)
+    {
+        return ObjModelLoading::failed("Cache file is outdated!", duration.elapsed());
+    }
+
+    ObjModel cachedModel;
+    if (!reader.read(cachedModel.positions, header.nbPositions) ||
+        !reader.read(cachedModel.positionWeights, header.nbPositionWeights) ||
+        !reader.read(cachedModel.normals, header.nbNormals) ||
+        !reader.read(cachedModel.textures, header.nbTextures) ||
+        !reader.read(cachedModel.tangents, header.nbTangents) ||
+        !readObjects(reader, header, cachedModel) ||
+        !readMaterialIds(reader, header, cachedModel))
+    {
+        return ObjModelLoading::failed("Truncated cache file!", duration.elapsed());
+    }
+
+    model = std::move(cachedModel);
+    return ObjModelLoading::succeeded(duration.elapsed());
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include "OcclusionCulling.hpp"
+#include "Duration.hpp"
+#include "GlError.hpp"
+#include "Shader.hpp"
+#include "StateCache.hpp"
+
+namespace
+{
+
+const char boxVertexShader[] =
+        GLSL_VERSION_HEADER
+        "layout(location = 0) in vec3 corner;\n"
+        "uniform mat4 mvpMat;\n"
+        "uniform vec3 boxMin;\n"
+        "uniform vec3 boxSize;\n"
+        "void main(){\n"
+        "  gl_Position = mvpMat * vec4(boxMin + corner * boxSize, 1);\n"
+        "}\n";
+
+const char boxFragmentShader[] =
+        GLSL_VERSION_HEADER
+        "out vec4 color;\n"
+        "void main(){\n"
+        "  color = vec4(1);\n"
+        "}\n";
+
+const GLfloat BOX_CORNERS[] = {0, 0, 0,  1, 0, 0,  0, 1, 0,  1, 1, 0,
+                               0, 0, 1,  1, 0, 1,  0, 1, 1,  1, 1, 1};
+
+const GLubyte BOX_INDICES[] = {0, 2, 1,  1, 2, 3,   4, 5, 6,  5, 7, 6,
+                               0, 1, 4,  1, 5, 4,   2, 6, 3,  3, 6, 7,
+                               0, 4, 2,  2, 4, 6,   1, 3, 5,  3, 7, 5};
+
+const GLsizei NB_BOX_INDICES = static_cast<GLsizei>(sizeof(BOX_INDICES));
+
+// Margin added around the boxes, relative to their largest dimension.
+const float BOX_MARGIN = 0.01f;
+
+// Queries generated at once when the pool is empty.
+const GLsizei QUERY_CHUNK_SIZE = 64;
+
+}
+
+ogl::OcclusionQueryPool::~OcclusionQueryPool()
+{
+    if (!_queries.empty())
+    {
+        glDeleteQueries(static_cast<GLsizei>(_queries.size()), _queries.data());
+    }
+}
+
+GLuint ogl::OcclusionQueryPool::acquire()
+{
+    if (_freeQueries.empty())
+    {
+        _freeQueries.resize(QUERY_CHUNK_SIZE);
+        glGenQueries(QUERY_CHUNK_SIZE, _freeQueries.data());
+        _queries.insert(_queries.end(), _freeQueries.begin(), _freeQueries.end());
+    }
+    GLuint query = _freeQueries.back();
+    _freeQueries.pop_back();
+    return query;
+}
+
+void ogl::OcclusionQueryPool::release(GLuint query)
+{
+    _freeQueries.push_back(query);
+}
+
+ogl::OcclusionCulling::OcclusionCulling() : _vertexArray{0}, _queryTarget{GL_ANY_SAMPLES_PASSED}, _previousProgram{0},
+    _previousColorMask{true}, _previousDepthMask{GL_TRUE},
+    _previousDepthFunc{GL_LESS}, _previousCullFace{false}
+{
+}
+
+ogl::OcclusionCulling::~OcclusionCulling()
+{
+    clear();
+}
+
+void ogl::OcclusionCulling::clear()
+{
+    StateCache &stateCache = StateCache::current();
+    if (_vertexArray > 0)
+    {
+        stateCache.deleteVertexArrays(1, &_vertexArray);
+        _vertexArray = 0;
+    }
+    if (!_buffers.empty())
+    {
+        stateCache.deleteBuffers(static_cast<GLsizei>(_buffers.size()), &_buffers[0]);
+        _buffers.clear();
+    }
+}
+
+ogl::OcclusionCullingCreation ogl::OcclusionCulling::create()
+{
+    clear();
+    sys::Duration duration;
+
+    Shader vs(ShaderType::VERTEX_SHADER);
+    ShaderCompilation vsCompilation = vs.compile(boxVertexShader);
+    if (!vsCompilation)
+    {
+        return OcclusionCullingCreation::failed("Box vertex shader: " + vsCompilation.message(), duration.elapsed());
+    }
+    Shader fs(ShaderType::FRAGMENT_SHADER);
+    ShaderCompilation fsCompilation = fs.compile(boxFragmentShader);
+    if (!fsCompilation)
+    {
+        return OcclusionCullingCreation::failed("Box fragment shader: " + fsCompilation.message(), duration.elapsed());
+    }
+    _program.detachAllShaders();
+    _program.attach(vs);
+    _program.attach(fs);
+    ShaderLink link = _program.link();
+    if (!link)
+    {
+        return OcclusionCullingCreation::failed("Box program: " + link.message(), duration.elapsed());
+    }
+    _mvpMatrixUniform = _program.getActiveUniform("mvpMat");
+    _boxMinUniform = _program.getActiveUniform("boxMin");
+    _boxSizeUniform = _program.getActiveUniform("boxSize");
+
+    GlError glError;
+    StateCache &stateCache = StateCache::current();
+    glGenVertexArrays(1, &_vertexArray);
+    stateCache.bindVertexArray(_vertexArray);
+    _buffers.resize(2);
+    glGenBuffers(static_cast<GLsizei>(_buffers.size()), &_buffers[0]);
+    stateCache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffers[0]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(BOX_INDICES), BOX_INDICES, GL_STATIC_DRAW);
+    stateCache.bindBuffer(GL_ARRAY_BUFFER, _buffers[1]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(BOX_CORNERS), BOX_CORNERS, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray(0);
+    stateCache.bindVertexArray(0);
+    if (glError)
+    {
+        clear();
+        return OcclusionCullingCreation::failed(glError.toString("Error during box vertex array creation"), duration.elapsed());
+    }
+
+    // A conservative query may count samples of a hidden box, never the
+    // contrary, and is cheaper when the implementation supports it.
+    _queryTarget = GLAD_GL_ARB_ES3_compatibility ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+    return OcclusionCullingCreation::succeeded(_queryTarget == GL_ANY_SAMPLES_PASSED ? "Conservative queries not supported." : "",
+                                               duration.elapsed());
+}
+
+void ogl::OcclusionCulling::beginQueries(const glm::mat4 &modelViewProjectionMatrix)
+{
+    StateCache &stateCache = StateCache::current();
+    _previousProgram = stateCache.program();
+    _previousColorMask = stateCache.colorMask();
+    _previousDepthMask = stateCache.depthMask();
+    _previousDepthFunc = stateCache.depthFunc();
+    _previousCullFace = stateCache.isEnabled(GL_CULL_FACE);
+
+    _program.use();
+    *_mvpMatrixUniform = modelViewProjectionMatrix;
+    stateCache.bindVertexArray(_vertexArray);
+    stateCache.colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    stateCache.depthMask(GL_FALSE);
+    stateCache.depthFunc(GL_LEQUAL);
+    stateCache.disable(GL_CULL_FACE);
+}
+
+GLuint ogl::OcclusionCulling::queryBox(const glm::vec3 &min, const glm::vec3 &max)
+{
+    GLuint query = _queryPool.acquire();
+    glm::vec3 size = max - min;
+    glm::vec3 margin(BOX_MARGIN * std::max(size.x, std::max(size.y, size.z)));
+    *_boxMinUniform = min - margin;
+    *_boxSizeUniform = size + 2.0f * margin;
+    glBeginQuery(_queryTarget, query);
+    glDrawElements(GL_TRIANGLES, NB_BOX_INDICES, GL_UNSIGNED_BYTE, nullptr);
+    glEndQuery(_queryTarget);
+    return query;
+}
+
+void ogl::OcclusionCulling::endQueries()
+{
+    StateCache &stateCache = StateCache::current();
+    stateCache.colorMask(_previousColorMask.x, _previousColorMask.y, _previousColorMask.z, _previousColorMask.w);
+    stateCache.depthMask(_previousDepthMask);
+    stateCache.depthFunc(_previousDepthFunc);
+    stateCache.setEnabled(GL_CULL_FACE, _previousCullFace);
+    stateCache.useProgram(_previousProgram);
+}
+
+bool ogl::OcclusionCulling::readQuery(GLuint query, bool &anySamplesPassed)
+{
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE)
+    {
+        return false;
+    }
+    GLuint result = 0;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT, &result);
+    anySamplesPassed = result != 0;
+    _queryPool.release(query);
+    return true;
+}
+
+void ogl::OcclusionCulling::releaseQuery(GLuint query)
+{
+    _queryPool.release(query);
+}
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "VertexCacheOptimizer.hpp"
+
+namespace
+{
+
+const int CACHE_SIZE = 32;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float CACHE_DECAY_POWER = 1.5f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+const GLuint NO_VERTEX = std::numeric_limits<GLuint>::max();
+const std::size_t NO_TRIANGLE = std::numeric_limits<std::size_t>::max();
+
+const GLuint MAX_TABULATED_VALENCE = 32;
+
+// The vertices of the last triangle have a fixed score so that the next
+// triangle does not favour one of its edges, older vertices decay, and
+// vertices with few remaining triangles are boosted to avoid leaving them
+// alone.
+float computeVertexScore(int cachePosition, GLuint nbRemainingTriangles)
+{
+    if (nbRemainingTriangles == 0)
+    {
+        return -1.0f;
+    }
+
+    float score = .0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+        {
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            float scaler = 1.0f / static_cast<float>(CACHE_SIZE - 3);
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+    return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(nbRemainingTriangles), -VALENCE_BOOST_POWER);
+}
+
+// Scores are tabulated for the cache positions, -1 being out of the cache,
+// and the most common valences.
+struct VertexScores
+{
+    VertexScores()
+    {
+        for (int position = -1; position < CACHE_SIZE; ++position)
+        {
+            for (GLuint valence = 0; valence < MAX_TABULATED_VALENCE; ++valence)
+            {
+                scores[position + 1][valence] = computeVertexScore(position, valence);
+            }
+        }
+    }
+
+    float operator()(int cachePosition, GLuint nbRemainingTriangles) const
+    {
+        if (nbRemainingTriangles < MAX_TABULATED_VALENCE)
+        {
+            return scores[cachePosition + 1][nbRemainingTriangles];
+        }
+        return computeVertexScore(cachePosition, nbRemainingTriangles);
+    }
+
+    float scores[CACHE_SIZE + 1][MAX_TABULATED_VALENCE];
+};
+
+const VertexScores vertexScore;
+
+}
+
+
+float ogl::computeAcmr(const GLuint *indices, std::size_t nbIndices, std::size_t cacheSize)
+{
+    if (nbIndices < 3)
+    {
+        return .0f;
+    }
+
+    std::vector<GLuint> cache(cacheSize, NO_VERTEX);
+    std::size_t next = 0;
+    std::size_t nbMisses = 0;
+    for (std::size_t i = 0; i < nbIndices; ++i)
+    {
+        if (std::find(cache.begin(), cache.end(), indices[i]) == cache.end())
+        {
+            cache[next] = indices[i];
+            next = (next + 1) % cacheSize;
+            ++nbMisses;
+        }
+    }
+    return static_cast<float>(nbMisses) / static_cast<float>(nbIndices / 3);
+}
+
+std::vector<GLuint> ogl::reorderVerticesByFirstUse(GLuint *indices, std::size_t nbIndices, std::size_t nbVertices)
+{
+    std::vector<GLuint> newVertices(nbVertices, NO_VERTEX);
+    std::vector<GLuint> previousVertices;
+    for (std::size_t i = 0; i < nbIndices; ++i)
+    {
+        GLuint &newVertex = newVertices[indices[i]];
+        if (newVertex == NO_VERTEX)
+        {
+            newVertex = static_cast<GLuint>(previousVertices.size());
+            previousVertices.push_back(indices[i]);
+        }
+        indices[i] = newVertex;
+    }
+    return previousVertices;
+}
+
+void ogl::VertexCacheOptimizer::optimize(GLuint *indices, std::size_t nbIndices)
+{
+    std::size_t nbTriangles = nbIndices / 3;
+    if (nbTriangles < 2)
+    {
+        return;
+    }
+
+    // Vertices are renumbered in order of appearance so that the working
+    // buffers only cover the vertices of the range.
+    _globalVertices.clear();
+    _triangles.resize(3 * nbTriangles);
+    for (std::size_t i = 0; i < 3 * nbTriangles; ++i)
+    {
+        GLuint vertex = indices[i];
+        if (vertex >= _localVertices.size())
+        {
+            _localVertices.resize(vertex + 1, NO_VERTEX);
+        }
+        if (_localVertices[vertex] == NO_VERTEX)
+        {
+            _localVertices[vertex] = static_cast<GLuint>(_globalVertices.size());
+            _globalVertices.push_back(vertex);
+        }
+        _triangles[i] = _localVertices[vertex];
+    }
+    for (GLuint vertex : _globalVertices)
+    {
+        _localVertices[vertex] = NO_VERTEX;
+    }
+    std::size_t nbVertices = _globalVertices.size();
+
+    _nbRemainingTriangles.assign(nbVertices, 0);
+    for (GLuint vertex : _triangles)
+    {
+        ++_nbRemainingTriangles[vertex];
+    }
+    _firstAdjacentTriangles.assign(nbVertices + 1, 0);
+    for (std::size_t vertex = 0; vertex < nbVertices; ++vertex)
+    {
+        _firstAdjacentTriangles[vertex + 1] = _firstAdjacentTriangles[vertex] + _nbRemainingTriangles[vertex];
+    }
+    _adjacentTriangles.resize(3 * nbTriangles);
+    std::vector<std::size_t> &nextAdjacentTriangles = _firstAdjacentTriangles;
+    for (std::size_t i = 0; i < 3 * nbTriangles; ++i)
+    {
+        _adjacentTriangles[nextAdjacentTriangles[_triangles[i]]++] = static_cast<GLuint>(i / 3);
+    }
+    for (std::size_t vertex = 0; vertex < nbVertices; ++vertex)
+    {
+        nextAdjacentTriangles[vertex] -= _nbRemainingTriangles[vertex];
+    }
+
+    _vertexScores.resize(nbVertices);
+    for (std::size_t vertex = 0; vertex < nbVertices; ++vertex)
+    {
+        _vertexScores[vertex] = vertexScore(-1, _nbRemainingTriangles[vertex]);
+    }
+
+    std::size_t best = 0;
+    _triangleScores.resize(nbTriangles);
+    for (std::size_t triangle = 0; triangle < nbTriangles; ++triangle)
+    {
+        const GLuint *vertices = &_triangles[3 * triangle];
+        _triangleScores[triangle] = _vertexScores[vertices[0]] + _vertexScores[vertices[1]] + _vertexScores[vertices[2]];
+        if (_triangleScores[triangle] > _triangleScores[best])
+        {
+            best = triangle;
+        }
+    }
+
+    _emitted.assign(nbTriangles, false);
+    _cache.clear();
+    _output.clear();
+    _output.reserve(3 * nbTriangles);
+    std::size_t nextUnemitted = 0;
+    for (std::size_t nbEmitted = 0; nbEmitted < nbTriangles; ++nbEmitted)
+    {
+        if (best == NO_TRIANGLE)
+        {
+            // Dead end: no cached vertex has remaining triangles.
+            for (; _emitted[nextUnemitted]; ++nextUnemitted);
+            best = nextUnemitted;
+        }
+        emit(best);
+
+        // Only the triangles of the cached vertices have changed scores.
+        best = NO_TRIANGLE;
+        float bestScore = -1.0f;
+        for (GLuint vertex : _cache)
+        {
+            std::size_t first = _firstAdjacentTriangles[vertex];
+            for (std::size_t i = first; i < first + _nbRemainingTriangles[vertex]; ++i)
+            {
+                GLuint triangle = _adjacentTriangles[i];
+                const GLuint *vertices = &_triangles[3 * triangle];
+                float score = _vertexScores[vertices[0]] + _vertexScores[vertices[1]] + _vertexScores[vertices[2]];
+                _triangleScores[triangle] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = triangle;
+                }
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < _output.size(); ++i)
+    {
+        indices[i] = _globalVertices[_output[i]];
+    }
+}
+
+void ogl::VertexCacheOptimizer::emit(std::size_t triangle)
+{
+    _emitted[triangle] = true;
+    const GLuint *vertices = &_triangles[3 * triangle];
+    _output.insert(_output.end(), vertices, vertices + 3);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        GLuint vertex = vertices[i];
+        GLuint *first = &_adjacentTriangles[_firstAdjacentTriangles[vertex]];
+        GLuint *last = first + _nbRemainingTriangles[vertex] - 1;
+        std::iter_swap(std::find(first, last, static_cast<GLuint>(triangle)), last);
+        --_nbRemainingTriangles[vertex];
+    }
+
+    // The triangle vertices move to the front of the LRU cache, the vertices
+    // pushed beyond its size are evicted.
+    _previousCache.swap(_cache);
+    _cache.clear();
+    for (GLuint vertex : {vertices[0], vertices[1], vertices[2]})
+    {
+        if (std::find(_cache.begin(), _cache.end(), vertex) == _cache.end())
+        {
+            _cache.push_back(vertex);
+        }
+    }
+    for (GLuint vertex : _previousCache)
+    {
+        if (vertex != vertices[0] && vertex != vertices[1] && vertex != vertices[2])
+        {
+            _cache.push_back(vertex);
+        }
+    }
+    for (std::size_t position = 0; position < _cache.size(); ++position)
+    {
+        int cachePosition = position < static_cast<std::size_t>(CACHE_SIZE) ? static_cast<int>(position) : -1;
+        _vertexScores[_cache[position]] = vertexScore(cachePosition, _nbRemainingTriangles[_cache[position]]);
+    }
+    if (_cache.size() > static_cast<std::size_t>(CACHE_SIZE))
+    {
+        _cache.resize(CACHE_SIZE);
+    }
+}
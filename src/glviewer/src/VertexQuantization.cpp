@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "VertexQuantization.hpp"
+
+namespace
+{
+
+const float MAX_UNORM16 = 65535.0f;
+const float MAX_SNORM10 = 511.0f;
+
+// Rounding halves away from zero like std::round, which is not inlined.
+GLuint quantizeSnorm(float v, float max, GLuint mask)
+{
+    float scaled = std::min(std::max(v, -1.0f), 1.0f) * max;
+    return static_cast<GLuint>(static_cast<GLint>(scaled + (scaled < .0f ? -0.5f : 0.5f))) & mask;
+}
+
+// Rounds the bits shifted out to nearest even.
+std::uint32_t shiftRightRounded(std::uint32_t value, std::uint32_t shift)
+{
+    std::uint32_t rest = value & ((1u << shift) - 1u);
+    std::uint32_t half = 1u << (shift - 1u);
+    value >>= shift;
+    return rest > half || (rest == half && (value & 1u) != 0) ? value + 1u : value;
+}
+
+}
+
+GLushort ogl::quantizeUnorm16(float v)
+{
+    return static_cast<GLushort>(std::min(std::max(v, .0f), 1.0f) * MAX_UNORM16 + 0.5f);
+}
+
+GLuint ogl::packSnorm1010102(const glm::vec4 &v)
+{
+    return quantizeSnorm(v.x, MAX_SNORM10, 0x3FFu) | (quantizeSnorm(v.y, MAX_SNORM10, 0x3FFu) << 10) |
+           (quantizeSnorm(v.z, MAX_SNORM10, 0x3FFu) << 20) | (quantizeSnorm(v.w, 1.0f, 0x3u) << 30);
+}
+
+GLhalf ogl::toHalfFloat(float v)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    std::uint32_t sign = (bits >> 16) & 0x8000u;
+    std::uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+    if (magnitude > 0x7F800000u)
+    {
+        // NaN
+        return static_cast<GLhalf>(sign | 0x7E00u);
+    }
+    if (magnitude >= 0x47800000u)
+    {
+        // Infinity or beyond the largest half.
+        return static_cast<GLhalf>(sign | 0x7C00u);
+    }
+    if (magnitude < 0x38800000u)
+    {
+        // Subnormal half: the implicit mantissa bit is shifted with the mantissa.
+        std::uint32_t shift = 126u - (magnitude >> 23);
+        if (shift > 24u)
+        {
+            return static_cast<GLhalf>(sign);
+        }
+        return static_cast<GLhalf>(sign | shiftRightRounded((magnitude & 0x7FFFFFu) | 0x800000u, shift));
+    }
+    // Rebiased exponent, a rounding carry may give the next exponent or infinity.
+    return static_cast<GLhalf>(sign | shiftRightRounded(magnitude - 0x38000000u, 13u));
+}
@@ -1,6 +1,7 @@
 #define GLM_FORCE_RADIANS
 #include <functional>
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 #include <sstream>
@@ -16,13 +17,19 @@
 #include "Path.hpp"
 #include "Duration.hpp"
 #include "ShaderProgram.hpp"
+#include "StateCache.hpp"
 #include "GlMesh.hpp"
+#include "GlMeshCache.hpp"
+#include "ObjModelCache.hpp"
 #include "Camera.hpp"
 #include "CommandLineParser.hpp"
 #include "ConfigurationParser.hpp"
 
 const double PI = std::atan(1.0)*4;
 
+// Shader storage buffer binding of the material colors for the multi draw indirect.
+const GLuint MATERIALS_BINDING = 1;
+
 const char defaultMesh[] =
         "v -1 -1  0\n"
         "v  1 -1  0\n"
@@ -73,7 +80,7 @@ public:
     {
         std::vector<GLuint> texturesId;
         std::transform(_textureIdMap.begin(), _textureIdMap.end(), std::back_inserter(texturesId), getTextureId);
-		glDeleteTextures(static_cast<GLsizei>(texturesId.size()), &texturesId[0]);
+        ogl::StateCache::current().deleteTextures(static_cast<GLsizei>(texturesId.size()), texturesId.data());
     }
 
     GLuint load(const sys::Path &basepath, const std::string &filename)
@@ -87,6 +94,8 @@ public:
             }
             sys::Duration duration;
             textureId = SOIL_load_OGL_texture(filepath, SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID, SOIL_FLAG_NTSC_SAFE_RGB | SOIL_FLAG_COMPRESS_TO_DXT | SOIL_FLAG_TEXTURE_REPEATS);
+            // SOIL binds the texture behind the state cache.
+            ogl::StateCache::current().invalidate();
             if (textureId)
             {
                 _textureIdMap[filename] = textureId;
@@ -119,19 +128,153 @@ private:
     TextureIdMap _textureIdMap;
 };
 
+enum TextureSlot
+{
+    AMBIENT_TEXTURE,
+    DIFFUSE_TEXTURE,
+    SPECULAR_TEXTURE,
+    SPECULAR_SHININESS_TEXTURE,
+    DISSOLVE_TEXTURE,
+    NORMAL_MAPPING_TEXTURE,
+    DISPLACEMENT_TEXTURE,
+    NB_TEXTURE_SLOTS
+};
+
+const char *const TEXTURE_SLOT_NAMES[NB_TEXTURE_SLOTS] = {"ambient", "diffuse", "specular", "specularShininess", "dissolve", "normalMapping", "displacement"};
+
+const std::string &textureFilename(const vfm::TextureMap &map, std::size_t slot)
+{
+    switch (slot)
+    {
+    case AMBIENT_TEXTURE: return map.ambient;
+    case DIFFUSE_TEXTURE: return map.diffuse;
+    case SPECULAR_TEXTURE: return map.specular;
+    case SPECULAR_SHININESS_TEXTURE: return map.specularShininess;
+    case DISSOLVE_TEXTURE: return map.dissolve;
+    case NORMAL_MAPPING_TEXTURE: return map.normalMapping;
+    default: return map.displacement;
+    }
+}
+
+// Images of one texture slot packed as the layers of a GL_TEXTURE_2D_ARRAY,
+// bound once per frame. Only the images of the most common size fit, the
+// others are left to the TextureLoader.
+class TextureArray
+{
+public:
+
+    TextureArray() : _textureId(0) {}
+
+    ~TextureArray()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        if (_textureId != 0)
+        {
+            ogl::StateCache::current().deleteTextures(1, &_textureId);
+            _textureId = 0;
+        }
+        _layers.clear();
+    }
+
+    void create(const char *slotName, const std::vector<std::string> &filepaths)
+    {
+        clear();
+
+        struct Image
+        {
+            std::string filepath;
+            int width;
+            int height;
+            unsigned char *pixels;
+        };
+        std::vector<Image> images;
+        std::map<std::pair<int, int>, GLsizei> sizeCounts;
+        for (const std::string &filepath : filepaths)
+        {
+            sys::Duration duration;
+            Image image{filepath, 0, 0, nullptr};
+            int channels = 0;
+            image.pixels = SOIL_load_image(filepath.c_str(), &image.width, &image.height, &channels, SOIL_LOAD_RGBA);
+            if (image.pixels == nullptr)
+            {
+                LOG(WARNING) << "error while loading '" << filepath << "': " << SOIL_last_result();
+                continue;
+            }
+            LOG(INFO) << "loading '" << filepath << "' in " << duration.elapsed() << "ms.";
+            images.push_back(image);
+            ++sizeCounts[std::make_pair(image.width, image.height)];
+        }
+        if (images.empty())
+        {
+            return;
+        }
+
+        typedef std::map<std::pair<int, int>, GLsizei>::value_type SizeCount;
+        const SizeCount &size = *std::max_element(sizeCounts.begin(), sizeCounts.end(), [](const SizeCount &a, const SizeCount &b){
+            return a.second < b.second;
+        });
+        GLint maxLayers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        GLsizei nbLayers = std::min(size.second, static_cast<GLsizei>(maxLayers));
+
+        glGenTextures(1, &_textureId);
+        ogl::StateCache::current().bindTexture(0, GL_TEXTURE_2D_ARRAY, _textureId);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size.first.first, size.first.second, nbLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        for (const Image &image : images)
+        {
+            GLint layer = static_cast<GLint>(_layers.size());
+            if (image.width == size.first.first && image.height == size.first.second && layer < nbLayers)
+            {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, image.width, image.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+                _layers[image.filepath] = layer;
+            }
+            SOIL_free_image_data(image.pixels);
+        }
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        LOG(INFO) << slotName << " texture array of " << nbLayers << " layers of " << size.first.first << "x" << size.first.second
+                  << ", " << images.size() - _layers.size() << " images left as individual textures.";
+    }
+
+    // Layer of the image, -1 when it is not in the array.
+    GLint layer(const std::string &filepath) const
+    {
+        std::map<std::string, GLint>::const_iterator it = _layers.find(filepath);
+        return it != _layers.end() ? it->second : -1;
+    }
+
+    inline GLuint id() const
+    {
+        return _textureId;
+    }
+
+private:
+    TextureArray(const TextureArray&);
+    TextureArray & operator = (const TextureArray&);
+
+    GLuint _textureId;
+    std::map<std::string, GLint> _layers;
+};
+
 struct LoadedTexture{
 
-    LoadedTexture(): ambient(0), diffuse(0), specular(0), specularShininess(0), dissolve(0), normalMapping(0), displacement(0)
+    LoadedTexture()
     {
+        std::fill(textures, textures + NB_TEXTURE_SLOTS, 0u);
+        std::fill(layers, layers + NB_TEXTURE_SLOTS, -1);
     }
 
-    GLuint ambient;
-    GLuint diffuse;
-    GLuint specular;
-    GLuint specularShininess;
-    GLuint dissolve;
-    GLuint normalMapping;
-    GLuint displacement;
+    // Individual texture of each slot, or its layer in the texture array.
+    GLuint textures[NB_TEXTURE_SLOTS];
+    GLint layers[NB_TEXTURE_SLOTS];
 };
 
 struct LoadedMaterial
@@ -144,10 +287,21 @@ class MaterialHandler : public ogl::MaterialHandler
 {
 public:
 
+    MaterialHandler() : _currentMaterial(NO_MATERIAL_INDEX), _materialBuffer(0), _useTextureArrays(false) {}
+
+    ~MaterialHandler()
+    {
+        if (_materialBuffer != 0)
+        {
+            ogl::StateCache::current().deleteBuffers(1, &_materialBuffer);
+        }
+    }
+
     void loadUniforms(const ogl::ShaderProgram &shaderProgram)
     {
         _uniformColor.load(shaderProgram);
         _uniformTexture.load(shaderProgram);
+        _currentMaterial = NO_MATERIAL_INDEX;
     }
 
     void loadMaterials(TextureLoader &textureLoader, const char *objFilename,  const vfm::ObjModel &model)
@@ -156,8 +310,10 @@ public:
         sys::Path objFilepath(objFilename);
         sys::Path currentPath = objFilepath.dirpath();
         std::string defaultMaterialLibrary = std::string(objFilepath.withoutExtension()) + ".mtl";
+        std::vector<ArrayTexture> arrayTextures;
 
         _materials.clear();
+        _currentMaterial = NO_MATERIAL_INDEX;
 
         for(vfm::MaterialIdVector::const_iterator it = model.materialIds.begin(); it != model.materialIds.end(); ++it)
         {
@@ -198,23 +354,106 @@ public:
                     {
                         sys::Path basePath = sys::Path(currentPath, libraryName->c_str()).dirpath();
 
-                        loadedMaterial.texture.ambient = textureLoader.load(basePath, material.map.ambient);
-                        loadedMaterial.texture.diffuse = textureLoader.load(basePath, material.map.diffuse);
-                        loadedMaterial.texture.specular = textureLoader.load(basePath, material.map.specular);
-                        loadedMaterial.texture.specularShininess = textureLoader.load(basePath, material.map.specularShininess);
-                        loadedMaterial.texture.dissolve = textureLoader.load(basePath, material.map.dissolve);
-                        loadedMaterial.texture.normalMapping = textureLoader.load(basePath, material.map.normalMapping);
-                        loadedMaterial.texture.displacement = textureLoader.load(basePath, material.map.displacement);
+                        for (std::size_t slot = 0; slot < NB_TEXTURE_SLOTS; ++slot)
+                        {
+                            const std::string &filename = textureFilename(material.map, slot);
+                            if (_useTextureArrays && _uniformTexture.hasTextureArray(slot) && !filename.empty())
+                            {
+                                arrayTextures.push_back(ArrayTexture{_materials.size() - 1, slot, basePath, filename});
+                            }
+                            else
+                            {
+                                loadedMaterial.texture.textures[slot] = textureLoader.load(basePath, filename);
+                            }
+                        }
                     }
                 }
             }
         }
+
+        for (std::size_t slot = 0; slot < NB_TEXTURE_SLOTS; ++slot)
+        {
+            std::vector<std::string> filepaths;
+            for (const ArrayTexture &arrayTexture : arrayTextures)
+            {
+                if (arrayTexture.slot == slot)
+                {
+                    filepaths.push_back(arrayTexture.filepath());
+                }
+            }
+            std::sort(filepaths.begin(), filepaths.end());
+            filepaths.erase(std::unique(filepaths.begin(), filepaths.end()), filepaths.end());
+            if (filepaths.empty())
+            {
+                _textureArrays[slot].clear();
+            }
+            else
+            {
+                _textureArrays[slot].create(TEXTURE_SLOT_NAMES[slot], filepaths);
+            }
+        }
+        for (const ArrayTexture &arrayTexture : arrayTextures)
+        {
+            LoadedTexture &texture = _materials[arrayTexture.material].texture;
+            texture.layers[arrayTexture.slot] = _textureArrays[arrayTexture.slot].layer(arrayTexture.filepath());
+            if (texture.layers[arrayTexture.slot] < 0)
+            {
+                texture.textures[arrayTexture.slot] = textureLoader.load(arrayTexture.basePath, arrayTexture.filename);
+            }
+        }
+    }
+
+    // Packs the material textures in one texture array per slot, for the
+    // shaders declaring materialTextureArray (see phong_texture_array.conf).
+    // Must be set before loading the materials.
+    void setTextureArrays(bool textureArrays)
+    {
+        _useTextureArrays = textureArrays;
+    }
+
+    void bindTextureArrays()
+    {
+        _uniformTexture.bindArrays(_textureArrays);
+    }
+
+    // Colors of all the materials in a shader storage buffer, for the multi
+    // draw indirect. The textures are not available per draw.
+    void createMaterialBuffer()
+    {
+        std::vector<glm::vec4> colors;
+        for (const LoadedMaterial &material : _materials)
+        {
+            colors.push_back(glm::vec4(material.color.ambient, 1.0f));
+            colors.push_back(glm::vec4(material.color.diffuse, 1.0f));
+            colors.push_back(glm::vec4(material.color.specular, material.color.specularShininess));
+        }
+        if (colors.empty())
+        {
+            colors.resize(3, glm::vec4(1.0f));
+        }
+        if (_materialBuffer == 0)
+        {
+            glGenBuffers(1, &_materialBuffer);
+        }
+        ogl::StateCache::current().bindBuffer(GL_SHADER_STORAGE_BUFFER, _materialBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, colors.size() * sizeof(glm::vec4), colors.data(), GL_STATIC_DRAW);
+    }
+
+    void bindMaterialBuffer()
+    {
+        if (_materialBuffer != 0)
+        {
+            ogl::StateCache::current().bindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIALS_BINDING, _materialBuffer);
+        }
     }
 
+    // The uniforms keep the values of the current material until another
+    // one is used.
     virtual void use(ogl::MaterialIndex index)
     {
-        if (index != NO_MATERIAL_INDEX && index < _materials.size())
+        if (index != NO_MATERIAL_INDEX && index < _materials.size() && index != _currentMaterial)
         {
+            _currentMaterial = index;
             LoadedMaterial &material = _materials[index];
             _uniformColor.use(material.color);
             _uniformTexture.use(material.texture);
@@ -277,135 +516,126 @@ private:
 
         void load(const ogl::ShaderProgram &shaderProgram)
         {
-            _ambiantSampler = shaderProgram.getActiveUniform("materialTexture.ambient.sampler");
-            _diffuseSampler = shaderProgram.getActiveUniform("materialTexture.diffuse.sampler");
-            _specularSampler = shaderProgram.getActiveUniform("materialTexture.specular.sampler");
-            _specularShininessSampler = shaderProgram.getActiveUniform("materialTexture.specularShininess.sampler");
-            _dissolveSampler = shaderProgram.getActiveUniform("materialTexture.dissolve.sampler");
-            _normalMappingSampler = shaderProgram.getActiveUniform("materialTexture.normalMapping.sampler");
-            _displacementSampler = shaderProgram.getActiveUniform("materialTexture.displacement.sampler");
-
-            _ambiantEnable = shaderProgram.getActiveUniform("materialTexture.ambient.enable");
-            _diffuseEnable = shaderProgram.getActiveUniform("materialTexture.diffuse.enable");
-            _specularEnable = shaderProgram.getActiveUniform("materialTexture.specular.enable");
-            _specularShininessEnable = shaderProgram.getActiveUniform("materialTexture.specularShininess.enable");
-            _dissolveEnable = shaderProgram.getActiveUniform("materialTexture.dissolve.enable");
-            _normalMappingEnable = shaderProgram.getActiveUniform("materialTexture.normalMapping.enable");
-            _displacementEnable = shaderProgram.getActiveUniform("materialTexture.displacement.enable");
+            for (std::size_t slot = 0; slot < NB_TEXTURE_SLOTS; ++slot)
+            {
+                std::string name = std::string("materialTexture.") + TEXTURE_SLOT_NAMES[slot];
+                _samplers[slot] = shaderProgram.getActiveUniform((name + ".sampler").c_str());
+                _enables[slot] = shaderProgram.getActiveUniform((name + ".enable").c_str());
+                _layers[slot] = shaderProgram.getActiveUniform((name + ".layer").c_str());
+                _arraySamplers[slot] = shaderProgram.getActiveUniform((std::string("materialTextureArray.") + TEXTURE_SLOT_NAMES[slot]).c_str());
+
+                // Samplers of different types must not share a texture unit,
+                // the arrays take the units following the individual textures.
+                if (_samplers[slot])
+                {
+                    *_samplers[slot] = static_cast<GLint>(slot);
+                }
+                if (_arraySamplers[slot])
+                {
+                    *_arraySamplers[slot] = static_cast<GLint>(NB_TEXTURE_SLOTS + slot);
+                }
+                if (_layers[slot])
+                {
+                    *_layers[slot] = -1;
+                }
+            }
         }
 
         inline bool hasTexture() const
         {
-            return _ambiantSampler || _diffuseSampler || _specularSampler || _specularShininessSampler || _dissolveSampler || _normalMappingSampler || _displacementSampler;
-        }
-
-        void use(const LoadedTexture &loadedTexture)
-        {
-            if (_ambiantSampler && loadedTexture.ambient)
-            {
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, loadedTexture.ambient);
-                *_ambiantSampler = 0;
-                *_ambiantEnable = true;
-            }
-            else
-            {
-                *_ambiantEnable = false;
-            }
-
-            if (_diffuseSampler && loadedTexture.diffuse)
-            {
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, loadedTexture.diffuse);
-                *_diffuseSampler = 1;
-                *_diffuseEnable = true;
-            }
-            else
+            for (std::size_t slot = 0; slot < NB_TEXTURE_SLOTS; ++slot)
             {
-                *_diffuseEnable = false;
-            }
-
-            if (_specularSampler && loadedTexture.specular)
-            {
-                glActiveTexture(GL_TEXTURE2);
-                glBindTexture(GL_TEXTURE_2D, loadedTexture.specular);
-                *_specularSampler = 2;
-                *_specularEnable = true;
-            }
-            else
-            {
-                *_specularEnable = false;
+                if (_samplers[slot] || hasTextureArray(slot))
+                {
+                    return true;
+                }
             }
+            return false;
+        }
 
-            if (_specularShininessSampler && loadedTexture.specularShininess)
-            {
-                glActiveTexture(GL_TEXTURE3);
-                glBindTexture(GL_TEXTURE_2D, loadedTexture.specularShininess);
-                *_specularShininessSampler = 3;
-                *_specularShininessEnable = true;
-            }
-            else
-            {
-                *_specularShininessEnable = false;
-            }
+        inline bool hasTextureArray(std::size_t slot) const
+        {
+            return _arraySamplers[slot] && _layers[slot];
+        }
 
-            if (_dissolveSampler && loadedTexture.dissolve)
-            {
-                glActiveTexture(GL_TEXTURE4);
-                glBindTexture(GL_TEXTURE_2D, loadedTexture.dissolve);
-                *_dissolveSampler = 4;
-                *_dissolveEnable = true;
-            }
-            else
+        void bindArrays(const TextureArray *textureArrays)
+        {
+            for (std::size_t slot = 0; slot < NB_TEXTURE_SLOTS; ++slot)
             {
-                *_dissolveEnable = false;
+                if (_arraySamplers[slot] && textureArrays[slot].id() != 0)
+                {
+                    ogl::StateCache::current().bindTexture(static_cast<GLuint>(NB_TEXTURE_SLOTS + slot), GL_TEXTURE_2D_ARRAY, textureArrays[slot].id());
+                }
             }
+        }
 
-            if (_normalMappingSampler && loadedTexture.normalMapping)
-            {
-                glActiveTexture(GL_TEXTURE5);
-                glBindTexture(GL_TEXTURE_2D, loadedTexture.normalMapping);
-                *_normalMappingSampler = 5;
-                *_normalMappingEnable = true;
-            }
-            else
+        // The textures in the arrays only change the layer uniforms, the
+        // others are bound to their texture unit.
+        void use(const LoadedTexture &loadedTexture)
+        {
+            for (std::size_t slot = 0; slot < NB_TEXTURE_SLOTS; ++slot)
             {
-                *_normalMappingEnable = false;
-            }
+                if (_layers[slot])
+                {
+                    *_layers[slot] = loadedTexture.layers[slot];
+                }
 
-            if (_displacementSampler && loadedTexture.displacement)
-            {
-                glActiveTexture(GL_TEXTURE6);
-                glBindTexture(GL_TEXTURE_2D, loadedTexture.displacement);
-                *_displacementSampler = 6;
-                *_displacementEnable = true;
-            }
-            else
-            {
-                *_displacementEnable = false;
+                if (loadedTexture.layers[slot] >= 0)
+                {
+                    *_enables[slot] = true;
+                }
+                else if (_samplers[slot] && loadedTexture.textures[slot])
+                {
+                    ogl::StateCache::current().bindTexture(static_cast<GLuint>(slot), GL_TEXTURE_2D, loadedTexture.textures[slot]);
+                    *_enables[slot] = true;
+                }
+                else
+                {
+                    *_enables[slot] = false;
+                }
             }
         }
 
     private:
-        ogl::UniformDeclaration _ambiantSampler;
-        ogl::UniformDeclaration _diffuseSampler;
-        ogl::UniformDeclaration _specularSampler;
-        ogl::UniformDeclaration _specularShininessSampler;
-        ogl::UniformDeclaration _dissolveSampler;
-        ogl::UniformDeclaration _normalMappingSampler;
-        ogl::UniformDeclaration _displacementSampler;
-
-        ogl::UniformDeclaration _ambiantEnable;
-        ogl::UniformDeclaration _diffuseEnable;
-        ogl::UniformDeclaration _specularEnable;
-        ogl::UniformDeclaration _specularShininessEnable;
-        ogl::UniformDeclaration _dissolveEnable;
-        ogl::UniformDeclaration _normalMappingEnable;
-        ogl::UniformDeclaration _displacementEnable;
+        ogl::UniformDeclaration _samplers[NB_TEXTURE_SLOTS];
+        ogl::UniformDeclaration _enables[NB_TEXTURE_SLOTS];
+        ogl::UniformDeclaration _layers[NB_TEXTURE_SLOTS];
+        ogl::UniformDeclaration _arraySamplers[NB_TEXTURE_SLOTS];
     } _uniformTexture;
 
 
+    // Texture of a material waiting for its slot texture array.
+    struct ArrayTexture
+    {
+        std::string filepath() const
+        {
+            return std::string(sys::Path(basePath, filename.c_str()));
+        }
+
+        std::size_t material;
+        std::size_t slot;
+        sys::Path basePath;
+        std::string filename;
+    };
+
     std::vector<LoadedMaterial> _materials;
+    ogl::MaterialIndex _currentMaterial;
+    GLuint _materialBuffer;
+    bool _useTextureArrays;
+    TextureArray _textureArrays[NB_TEXTURE_SLOTS];
+};
+
+struct RenderOptions
+{
+    RenderOptions() : occlusionCulling(false), multiDrawIndirect(false), textureArrays(false), nbInstances(0), separateInstances(false) {}
+
+    bool occlusionCulling;
+    bool multiDrawIndirect;
+    bool textureArrays;
+    // Copies of the model scattered on a grid, drawn with instanced draws
+    // or with one render per copy when separateInstances is set.
+    unsigned int nbInstances;
+    bool separateInstances;
 };
 
 class GlslViewer
@@ -414,10 +644,38 @@ public:
 
     using LoadFile = sys::OperationResult;
 
-    GlslViewer(const std::string &vertexShader, const std::string &fragmentShader, const sys::Path &objFilename) : failure(false)
+    GlslViewer(const std::string &vertexShader, const std::string &fragmentShader, const sys::Path &objFilename, const vfm::LoadOptions &loadOptions, const ogl::GlMeshOptions &meshOptions, bool meshCache, const RenderOptions &renderOptions)
+        : failure(false), separateInstances(renderOptions.separateInstances), nbFrames(0)
     {
+        materialHandler.setTextureArrays(renderOptions.textureArrays);
         if (good()) createProgram(vertexShader, fragmentShader);
-        if (good()) createMesh(objFilename);
+        if (good()) createMesh(objFilename, loadOptions, meshOptions, meshCache);
+        sceneBoundingBox = mesh.getBoundingBox();
+        if (good() && renderOptions.nbInstances > 0)
+        {
+            scatterInstances(renderOptions.nbInstances);
+        }
+        if (good() && renderOptions.multiDrawIndirect)
+        {
+            if (mesh.setMultiDrawIndirect(true))
+            {
+                materialHandler.createMaterialBuffer();
+            }
+            else
+            {
+                LOG(WARNING) << "multi draw indirect not supported by the OpenGL context, the materials are drawn one by one";
+            }
+        }
+        // The occlusion queries of the mesh are those of a single copy, the
+        // copies rendered one by one would use the results of the others.
+        if (good() && renderOptions.occlusionCulling && renderOptions.nbInstances > 0 && renderOptions.separateInstances)
+        {
+            LOG(WARNING) << "occlusion culling not supported with separate instances, the copies are drawn without it";
+        }
+        else if (good() && renderOptions.occlusionCulling && check(occlusionCulling.create(), "creating occlusion culling"))
+        {
+            mesh.setOcclusionCulling(&occlusionCulling);
+        }
     }
 
     LoadFile readFile(const char *filename, std::string &content)
@@ -438,19 +696,43 @@ public:
         return LoadFile::succeeded(duration.elapsed());
     }
 
-    void createMesh(const char *objFilename)
+    void createMesh(const char *objFilename, const vfm::LoadOptions &loadOptions, const ogl::GlMeshOptions &meshOptions, bool meshCache)
     {
         vfm::ObjModel model;
-        if(objFilename && *objFilename != 0)
+        bool hasObjFile = objFilename && *objFilename != 0;
+        std::string meshCacheFilename;
+        if (hasObjFile && meshCache)
         {
-            sys::Duration loadfileDuration;
-            std::ifstream is(objFilename);
-            if(! (is >> model))
+            const ogl::VertexAttributeDeclarationVector &vads = this->program.getVertexAttributeDeclarations();
+            meshCacheFilename = ogl::meshCacheFilename(objFilename, vads, meshOptions);
+            ogl::GlMeshData data;
+            ogl::GlMeshGeneration meshCacheLoading = ogl::loadMeshCache(meshCacheFilename.c_str(), objFilename, vads, meshOptions, data, model.materialIds);
+            if (meshCacheLoading)
             {
-                check(LoadFile::failed("Cannot read file (maybe the path is wrong)!", 0), std::string("loading '") + objFilename + "'");
+                check(meshCacheLoading, std::string("loading mesh cache '") + meshCacheFilename + "'");
+                materialHandler.loadMaterials(textureLoader, objFilename, model);
+                check(mesh.upload(data, vads), "uploading mesh");
                 return;
             }
-            check(LoadFile::succeeded(loadfileDuration.elapsed()), std::string("loading '") + objFilename + "'");
+            LOG(INFO) << "mesh cache '" << meshCacheFilename << "' not used: " << meshCacheLoading.message();
+        }
+
+        if(hasObjFile)
+        {
+            std::string cacheFilename = vfm::cacheFilename(objFilename);
+            vfm::ObjModelLoading cacheLoading = vfm::loadCache(cacheFilename.c_str(), objFilename, model);
+            if (cacheLoading)
+            {
+                check(cacheLoading, std::string("loading cache '") + cacheFilename + "'");
+            }
+            else
+            {
+                LOG(INFO) << "cache '" << cacheFilename << "' not used: " << cacheLoading.message();
+                if(!check(vfm::load(objFilename, model, loadOptions), std::string("loading '") + objFilename + "'"))
+                {
+                    return;
+                }
+            }
         }
         else
         {
@@ -460,7 +742,20 @@ public:
 
         materialHandler.loadMaterials(textureLoader, objFilename, model);
 
-        check(mesh.generate(model, this->program.getVertexAttributeDeclarations()), "generating mesh");
+        const ogl::VertexAttributeDeclarationVector &vads = this->program.getVertexAttributeDeclarations();
+        if (meshCacheFilename.empty())
+        {
+            check(mesh.generate(model, vads, meshOptions), "generating mesh");
+            return;
+        }
+
+        ogl::GlMeshData data;
+        if (check(ogl::GlMesh::prepare(model, vads, data, meshOptions), "preparing mesh"))
+        {
+            ogl::GlMeshCaching meshCaching = ogl::saveMeshCache(meshCacheFilename.c_str(), objFilename, vads, meshOptions, data, model.materialIds);
+            LOG(INFO) << "saving mesh cache '" << meshCacheFilename << "' in " << meshCaching.duration() << "ms. " << meshCaching.message();
+            check(mesh.upload(data, vads), "uploading mesh");
+        }
     }
 
     void createProgram(const std::string &vertexShader, const std::string &fragmentShader)
@@ -496,6 +791,34 @@ public:
         }
     }
 
+    // Copies of the model on a cubic grid, each one turned around its center
+    // and colored differently.
+    void scatterInstances(unsigned int nbInstances)
+    {
+        const ogl::BoundingBox &boundingBox = mesh.getBoundingBox();
+        float diagonal = glm::distance(boundingBox.min, boundingBox.max);
+        float spacing = diagonal > .0f ? diagonal * 1.2f : 1.0f;
+        unsigned int side = static_cast<unsigned int>(std::ceil(std::cbrt(static_cast<double>(nbInstances))));
+        float halfExtent = static_cast<float>(side - 1) * spacing * 0.5f;
+
+        std::vector<glm::mat4> modelMatrices;
+        std::vector<glm::vec4> colors;
+        for (unsigned int i = 0; i < nbInstances; ++i)
+        {
+            glm::vec3 position(static_cast<float>(i % side), static_cast<float>(i / side % side), static_cast<float>(i / (side * side)));
+            float angle = static_cast<float>(i) * 2.39996f;
+            modelMatrices.push_back(glm::translate(position * spacing - halfExtent) * glm::rotate(angle, glm::vec3(0,1,0)) * glm::translate(-boundingBox.center()));
+            colors.push_back(glm::vec4(0.6f + 0.4f * std::sin(angle), 0.6f + 0.4f * std::sin(angle + 2.1f), 0.6f + 0.4f * std::sin(angle + 4.2f), 1.0f));
+        }
+        instanceMatrices = modelMatrices;
+        if (check(instances.upload(modelMatrices, colors), "uploading " + std::to_string(nbInstances) + " instances"))
+        {
+            sceneBoundingBox = ogl::BoundingBox();
+            sceneBoundingBox.accept(-halfExtent - diagonal * 0.5f, -halfExtent - diagonal * 0.5f, -halfExtent - diagonal * 0.5f);
+            sceneBoundingBox.accept(halfExtent + diagonal * 0.5f, halfExtent + diagonal * 0.5f, halfExtent + diagonal * 0.5f);
+        }
+    }
+
     void update(ogl::GlWindowContext& glf)
     {
         program.use();
@@ -511,7 +834,7 @@ public:
             *mouseUniform = cursorPosition;
         }
 
-        const ogl::BoundingBox &boundingBox = mesh.getBoundingBox();
+        const ogl::BoundingBox &boundingBox = sceneBoundingBox;
         glm::mat4x4 modelMatrix = glm::mat4x4(1.0f);
 
         glm::vec3 eyePosition {0,0,glm::distance(boundingBox.min, boundingBox.max) * 0.75f};
@@ -527,11 +850,6 @@ public:
             *resolutionUniform = static_cast<glm::vec2>(_camera.viewport());
         }
 
-        if(modelMatrixUniform)
-        {
-            *modelMatrixUniform = modelMatrix;
-        }
-
         if(viewMatrixUniform)
         {
             *viewMatrixUniform = viewMatrix;
@@ -542,21 +860,81 @@ public:
             *projectionMatrixUniform = projectionMatrix;
         }
 
-        if(mvMatrixUniform)
+        auto useModelMatrix = [&](const glm::mat4x4 &objectMatrix)
         {
-            *mvMatrixUniform = viewMatrix * modelMatrix;
-        }
+            // Quantized positions are mapped back to the model space by the matrices transforming the vertices.
+            glm::mat4x4 vertexModelMatrix = objectMatrix * mesh.dequantizationMatrix();
 
-        if(mvpMatrixUniform)
+            if(modelMatrixUniform)
+            {
+                *modelMatrixUniform = vertexModelMatrix;
+            }
+
+            if(mvMatrixUniform)
+            {
+                *mvMatrixUniform = viewMatrix * vertexModelMatrix;
+            }
+
+            if(mvpMatrixUniform)
+            {
+                *mvpMatrixUniform = projectionMatrix * viewMatrix * vertexModelMatrix;
+            }
+
+            if(normalMatrixUniform)
+            {
+                *normalMatrixUniform = glm::transpose(glm::inverse(glm::mat3(viewMatrix * objectMatrix)));
+            }
+        };
+
+        materialHandler.bindMaterialBuffer();
+        materialHandler.bindTextureArrays();
+        ogl::RenderStatistics statistics;
+        if (instances.size() == 0)
         {
-            *mvpMatrixUniform = projectionMatrix * viewMatrix * modelMatrix;
+            useModelMatrix(modelMatrix);
+            mesh.selectLevelOfDetail(_camera, viewMatrix * modelMatrix);
+            mesh.cullMeshlets(_camera, viewMatrix * modelMatrix);
+            mesh.cullMaterialGroups(projectionMatrix * viewMatrix * modelMatrix);
+            statistics = mesh.render(&materialHandler);
         }
+        else if (separateInstances)
+        {
+            for (const glm::mat4x4 &instanceMatrix : instanceMatrices)
+            {
+                glm::mat4x4 instanceModelMatrix = instanceMatrix * modelMatrix;
+                useModelMatrix(instanceModelMatrix);
+                mesh.cullMaterialGroups(projectionMatrix * viewMatrix * instanceModelMatrix);
+                ogl::RenderStatistics instanceStatistics = mesh.render(&materialHandler);
+                statistics.nbDrawnMaterialGroups += instanceStatistics.nbDrawnMaterialGroups;
+                statistics.nbCulledMaterialGroups += instanceStatistics.nbCulledMaterialGroups;
+                statistics.nbOccludedMaterialGroups += instanceStatistics.nbOccludedMaterialGroups;
+                statistics.nbOcclusionQueries += instanceStatistics.nbOcclusionQueries;
+                statistics.nbDrawCalls += instanceStatistics.nbDrawCalls;
+            }
+        }
+        else
+        {
+            useModelMatrix(modelMatrix);
+            statistics = mesh.renderInstanced(instances, &materialHandler);
+        }
+        if (statistics.nbCulledMaterialGroups != renderStatistics.nbCulledMaterialGroups || statistics.nbOccludedMaterialGroups != renderStatistics.nbOccludedMaterialGroups
+                || statistics.nbDrawCalls != renderStatistics.nbDrawCalls)
+        {
+            LOG(DEBUG) << statistics.nbDrawnMaterialGroups << " material groups drawn, " << statistics.nbCulledMaterialGroups << " culled, "
+                       << statistics.nbOccludedMaterialGroups << " occluded, in " << statistics.nbDrawCalls << " draw calls";
+        }
+        renderStatistics = statistics;
 
-        if(normalMatrixUniform)
+        ++nbFrames;
+        if (frameRateDuration.elapsed() >= 1000)
         {
-            *normalMatrixUniform = glm::transpose(glm::inverse(glm::mat3(viewMatrix * modelMatrix)));
+            ogl::StateCache &stateCache = ogl::StateCache::current();
+            LOG(DEBUG) << nbFrames * 1000 / frameRateDuration.elapsed() << " frames per second, "
+                       << stateCache.counters().issued << " state changes issued, " << stateCache.counters().elided << " elided";
+            stateCache.resetCounters();
+            frameRateDuration = sys::Duration();
+            nbFrames = 0;
         }
-        mesh.render(&materialHandler);
     }
 
     inline bool good() const
@@ -594,7 +972,16 @@ private:
     ogl::UniformDeclaration mvMatrixUniform;
     ogl::UniformDeclaration mvpMatrixUniform;
     ogl::UniformDeclaration normalMatrixUniform;
+    // Before the mesh, which releases its queries to the pool when destroyed.
+    ogl::OcclusionCulling occlusionCulling;
     ogl::GlMesh mesh;
+    ogl::BoundingBox sceneBoundingBox;
+    ogl::InstanceBuffer instances;
+    std::vector<glm::mat4> instanceMatrices;
+    bool separateInstances;
+    ogl::RenderStatistics renderStatistics;
+    sys::Duration frameRateDuration;
+    unsigned long nbFrames;
     MaterialHandler materialHandler;
     TextureLoader textureLoader;
     ogl::PerspectiveCamera _camera;
@@ -609,6 +996,18 @@ struct CommandLine
     sys::UShortArg height;
     sys::UShortArg width;
     sys::BoolArg fullscreen;
+    sys::UIntArg threads;
+    sys::BoolArg meshCache;
+    sys::BoolArg optimizeVertexCache;
+    sys::BoolArg optimizeVertexFetch;
+    sys::BoolArg levelsOfDetail;
+    sys::BoolArg meshlets;
+    sys::BoolArg quantizeVertexAttributes;
+    sys::BoolArg occlusionCulling;
+    sys::BoolArg multiDrawIndirect;
+    sys::BoolArg textureArrays;
+    sys::UIntArg instances;
+    sys::BoolArg separateInstances;
     sys::BoolArg help;
 
     CommandLine(sys::CommandLineParser &clp);
@@ -650,6 +1049,66 @@ CommandLine::CommandLine(sys::CommandLineParser &clp)
             .name("fullscreen")
             .description("Display in fullscreen mode. If specified, width and height define the resolution.");
 
+    clp.option(threads)
+            .shortName("j")
+            .name("threads")
+            .description("Number of threads used to load the model (0 for all available cores).");
+
+    clp.option(meshCache)
+            .shortName("mc")
+            .name("meshCache")
+            .description("Load the mesh from a cache of the OpenGL buffers next to the model file, created on first use.");
+
+    clp.option(optimizeVertexCache)
+            .shortName("ovc")
+            .name("optimizeVertexCache")
+            .description("Reorder the triangles of each material for the post-transform vertex cache.");
+
+    clp.option(optimizeVertexFetch)
+            .shortName("ovf")
+            .name("optimizeVertexFetch")
+            .description("Order the vertices by first use in the triangles for the vertex fetch.");
+
+    clp.option(levelsOfDetail)
+            .shortName("lod")
+            .name("levelsOfDetail")
+            .description("Simplify the model to 50%, 25%, 10% and 2% of its triangles and draw the level matching its size on screen.");
+
+    clp.option(meshlets)
+            .shortName("ml")
+            .name("meshlets")
+            .description("Split the triangles into meshlets and skip the ones outside the view or facing away.");
+
+    clp.option(quantizeVertexAttributes)
+            .shortName("qva")
+            .name("quantizeVertexAttributes")
+            .description("Store the positions as 16 bits, the normals and tangents as 10 bits and the texture coordinates as half floats.");
+
+    clp.option(occlusionCulling)
+            .shortName("oc")
+            .name("occlusionCulling")
+            .description("Skip the materials hidden behind the others with occlusion queries of their bounding boxes.");
+
+    clp.option(multiDrawIndirect)
+            .shortName("mdi")
+            .name("multiDrawIndirect")
+            .description("Draw all the materials with a single call, the shaders reading the material colors by draw (see phong_indirect.conf).");
+
+    clp.option(textureArrays)
+            .shortName("ta")
+            .name("textureArrays")
+            .description("Pack the material textures of the same size in one texture array per map, bound once per frame (see phong_texture_array.conf).");
+
+    clp.option(instances)
+            .shortName("n")
+            .name("instances")
+            .description("Number of copies of the model scattered on a grid, drawn with instanced draws (see phong_instanced.conf).");
+
+    clp.option(separateInstances)
+            .shortName("si")
+            .name("separateInstances")
+            .description("Draw the copies of the model with one render each instead of instanced draws, to compare the frame rates.");
+
     clp.option(help)
             .name("help")
             .description("Display this help message.");
@@ -665,6 +1124,18 @@ CommandLine::CommandLine(sys::CommandLineParser &clp)
     confFile.parser().property(width).name("width");
     confFile.parser().property(height).name("height");
     confFile.parser().property(fullscreen).name("fullscreen");
+    confFile.parser().property(threads).name("threads");
+    confFile.parser().property(meshCache).name("meshCache");
+    confFile.parser().property(optimizeVertexCache).name("optimizeVertexCache");
+    confFile.parser().property(optimizeVertexFetch).name("optimizeVertexFetch");
+    confFile.parser().property(levelsOfDetail).name("levelsOfDetail");
+    confFile.parser().property(meshlets).name("meshlets");
+    confFile.parser().property(quantizeVertexAttributes).name("quantizeVertexAttributes");
+    confFile.parser().property(occlusionCulling).name("occlusionCulling");
+    confFile.parser().property(multiDrawIndirect).name("multiDrawIndirect");
+    confFile.parser().property(textureArrays).name("textureArrays");
+    confFile.parser().property(instances).name("instances");
+    confFile.parser().property(separateInstances).name("separateInstances");
 
     clp.validator([this, &clp](){
         if (help)
@@ -750,7 +1221,34 @@ int main(int argc, const char **argv)
     LOG(INFO) << "OpenGL version " << glGetString(GL_VERSION);
     LOG(INFO) << "OpenGLSL version " << glGetString(GL_SHADING_LANGUAGE_VERSION);
     {
-        GlslViewer viewer(vertexShader, fragmentShader, cmdLine.objFilePath.value());
+        vfm::LoadOptions loadOptions;
+        if (cmdLine.threads)
+        {
+            loadOptions.nbThreads = cmdLine.threads.value();
+        }
+
+        ogl::GlMeshOptions meshOptions;
+        meshOptions.nbThreads = loadOptions.nbThreads;
+        meshOptions.optimizeVertexCache = cmdLine.optimizeVertexCache.value();
+        meshOptions.optimizeVertexFetch = cmdLine.optimizeVertexFetch.value();
+        meshOptions.buildMeshlets = cmdLine.meshlets.value();
+        meshOptions.quantizeVertexAttributes = cmdLine.quantizeVertexAttributes.value();
+        if (cmdLine.levelsOfDetail.value())
+        {
+            meshOptions.levelsOfDetail = {0.5f, 0.25f, 0.1f, 0.02f};
+        }
+
+        RenderOptions renderOptions;
+        renderOptions.occlusionCulling = cmdLine.occlusionCulling.value();
+        renderOptions.multiDrawIndirect = cmdLine.multiDrawIndirect.value();
+        renderOptions.textureArrays = cmdLine.textureArrays.value();
+        if (cmdLine.instances)
+        {
+            renderOptions.nbInstances = cmdLine.instances.value();
+        }
+        renderOptions.separateInstances = cmdLine.separateInstances.value();
+
+        GlslViewer viewer(vertexShader, fragmentShader, cmdLine.objFilePath.value(), loadOptions, meshOptions, cmdLine.meshCache.value(), renderOptions);
 
         if (viewer.good())
         {
@@ -758,9 +1256,10 @@ int main(int argc, const char **argv)
             glwc.setWindowSizeCallback(setViewport);
 
             glClearColor(0.5f,0.5f,0.5f,1.0f);
-            glEnable(GL_DEPTH_TEST);
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_BACK);
+            ogl::StateCache &stateCache = ogl::StateCache::current();
+            stateCache.enable(GL_DEPTH_TEST);
+            stateCache.enable(GL_CULL_FACE);
+            stateCache.cullFace(GL_BACK);
             /* Loop until the user closes the window */
             while (glwc.shouldContinue())
             {
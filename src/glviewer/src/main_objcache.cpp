@@ -0,0 +1,72 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "ObjModel.hpp"
+#include "ObjModelCache.hpp"
+#include "CommandLineParser.hpp"
+
+struct CommandLine
+{
+    sys::CharSeqArg filename;
+    sys::CharSeqArg output;
+    sys::UIntArg threads;
+    sys::BoolArg help;
+
+    CommandLine(int argc, const char **argv);
+};
+
+CommandLine::CommandLine(int argc, const char **argv)
+{
+    sys::CommandLineParser clp;
+    clp.parameter(filename).placeholder("FILE").description("The OBJ filename to convert.");
+    clp.option(help).name("help").shortName("h").description("Display this help message.");
+    clp.option(output).name("output").shortName("o").description("The cache filename (FILE.vfmc by default).");
+    clp.option(threads).name("threads").shortName("j").description("Number of threads used to parse the file (0 for all available cores).");
+    clp.validator([this](){
+        if(help) return sys::OperationResult::succeeded();
+        return sys::OperationResult::test(filename, "Missing OBJ filename!");
+    });
+
+    sys::OperationResult result = clp.parse(argc, argv);
+    if (!result)
+    {
+        std::cerr << result.message() << std::endl << std::endl;
+    }
+
+    if (!result || help)
+    {
+        std::cerr << "Usage: " << argv[0] << " [OPTIONS] FILE" << std::endl;
+        std::cerr << clp;
+        std::exit(1);
+    }
+}
+
+int main (int argc, const char **argv)
+{
+    CommandLine cmdLine(argc, argv);
+
+    vfm::LoadOptions loadOptions;
+    if (cmdLine.threads)
+    {
+        loadOptions.nbThreads = cmdLine.threads.value();
+    }
+
+    vfm::ObjModel model;
+    vfm::ObjModelLoading loading = vfm::load(cmdLine.filename.value(), model, loadOptions);
+    if (!loading)
+    {
+        std::clog << "Cannot open file " << cmdLine.filename.value() << ": " << loading.message() << std::endl;
+        return 1;
+    }
+
+    std::string cacheFilename = cmdLine.output ? std::string(cmdLine.output.value()) : vfm::cacheFilename(cmdLine.filename.value());
+    vfm::ObjModelCaching caching = vfm::saveCache(cacheFilename.c_str(), cmdLine.filename.value(), model);
+    if (!caching)
+    {
+        std::clog << "Cannot write cache " << cacheFilename << ": " << caching.message() << std::endl;
+        return 1;
+    }
+
+    std::clog << "Cache " << cacheFilename << " written in " << caching.duration() << " ms (parsing in " << loading.duration() << " ms)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "ObjGenerator.hpp"
+#include "CommandLineParser.hpp"
+#include "Path.hpp"
+
+struct CommandLine
+{
+    sys::CharSeqArg filename;
+    sys::ULongLongArg seed;
+    sys::ULongLongArg vertices;
+    sys::ULongLongArg faces;
+    sys::UIntArg polygonSize;
+    sys::ULongLongArg objects;
+    sys::ULongLongArg materials;
+    sys::ULongLongArg materialSwitches;
+    sys::BoolArg negativeIndices;
+    sys::BoolArg textureCoordinates;
+    sys::BoolArg normals;
+    sys::BoolArg textureMaps;
+    sys::BoolArg help;
+
+    CommandLine(int argc, const char **argv);
+};
+
+CommandLine::CommandLine(int argc, const char **argv)
+{
+    sys::CommandLineParser clp;
+    clp.parameter(filename).placeholder("FILE").description("The OBJ filename to write (the MTL file is written next to it).");
+    clp.option(help).name("help").shortName("h").description("Display this help message.");
+    clp.option(seed).name("seed").shortName("s").description("Seed of the pseudo random generator (1 by default).");
+    clp.option(vertices).name("vertices").shortName("v").description("Number of vertices (1024 by default).");
+    clp.option(faces).name("faces").shortName("f").description("Number of faces (1024 by default).");
+    clp.option(polygonSize).name("polygon").shortName("p").description("Maximum number of vertices per face, from 3 (4 by default).");
+    clp.option(objects).name("objects").shortName("o").description("Number of objects (1 by default).");
+    clp.option(materials).name("materials").shortName("m").description("Number of materials (none by default).");
+    clp.option(materialSwitches).name("switches").shortName("u").description("Number of usemtl statements (none by default).");
+    clp.option(negativeIndices).name("negative").shortName("n").description("Use negative (relative) indices in faces.");
+    clp.option(textureCoordinates).name("textures").shortName("t").description("Generate texture coordinates.");
+    clp.option(normals).name("normals").shortName("N").description("Generate normals.");
+    clp.option(textureMaps).name("maps").description("Reference texture files in materials.");
+    clp.validator([this](){
+        if(help) return sys::OperationResult::succeeded();
+        return sys::OperationResult::test(filename, "Missing OBJ filename!");
+    });
+
+    sys::OperationResult result = clp.parse(argc, argv);
+    if (!result)
+    {
+        std::cerr << result.message() << std::endl << std::endl;
+    }
+
+    if (!result || help)
+    {
+        std::cerr << "Usage: " << argv[0] << " [OPTIONS] FILE" << std::endl;
+        std::cerr << clp;
+        std::exit(1);
+    }
+}
+
+int main (int argc, const char **argv)
+{
+    CommandLine cmdLine(argc, argv);
+
+    vfm::GeneratorOptions options;
+    if (cmdLine.seed) options.seed = cmdLine.seed.value();
+    if (cmdLine.vertices) options.nbVertices = cmdLine.vertices.value();
+    if (cmdLine.faces) options.nbFaces = cmdLine.faces.value();
+    if (cmdLine.polygonSize) options.maxPolygonSize = cmdLine.polygonSize.value();
+    if (cmdLine.objects) options.nbObjects = cmdLine.objects.value();
+    if (cmdLine.materials) options.nbMaterials = cmdLine.materials.value();
+    if (cmdLine.materialSwitches) options.nbMaterialSwitches = cmdLine.materialSwitches.value();
+    options.negativeIndices = cmdLine.negativeIndices.value();
+    options.textureCoordinates = cmdLine.textureCoordinates.value();
+    options.normals = cmdLine.normals.value();
+    options.textureMaps = cmdLine.textureMaps.value();
+
+    sys::Path objPath(cmdLine.filename.value());
+    std::string mtlFilename = std::string(objPath.withoutExtension()) + ".mtl";
+    options.materialLibrary = sys::Path(mtlFilename.c_str()).basename();
+
+    std::ofstream obj(cmdLine.filename.value(), std::ios::binary);
+    std::ofstream mtl;
+    if (options.nbMaterials > 0)
+    {
+        mtl.open(mtlFilename, std::ios::binary);
+    }
+    if (!obj || !mtl)
+    {
+        std::clog << "Cannot open file " << (obj ? mtlFilename.c_str() : cmdLine.filename.value()) << std::endl;
+        return 1;
+    }
+
+    vfm::ObjGeneration generation = vfm::generate(options, obj, mtl);
+    if (!generation)
+    {
+        std::clog << "Cannot generate " << cmdLine.filename.value() << ": " << generation.message() << std::endl;
+        return 1;
+    }
+
+    std::clog << "Model " << cmdLine.filename.value() << " generated in " << generation.duration() << " ms" << std::endl;
+    return 0;
+}
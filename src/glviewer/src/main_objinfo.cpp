@@ -1,14 +1,67 @@
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <iomanip>
-#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
 #include "ObjModel.hpp"
 #include "CommandLineParser.hpp"
+#include "Duration.hpp"
+#include "MemoryUsage.hpp"
+
+namespace
+{
+
+std::atomic<std::size_t> nbAllocations{0};
+std::atomic<std::size_t> nbAllocatedBytes{0};
+
+}
+
+// Allocations are counted for the benchmark mode.
+void *operator new(std::size_t size)
+{
+    nbAllocations.fetch_add(1, std::memory_order_relaxed);
+    nbAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        std::abort();
+    }
+    return p;
+}
+
+// The pointers given to the replaced operator delete come from the malloc
+// of the replaced operator new, which GCC cannot see.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
 
 struct CommandLine
 {
     sys::CharSeqArg filename;
     sys::BoolArg verbose;
+    sys::UIntArg threads;
+    sys::BoolArg reserve;
+    sys::BoolArg arena;
+    sys::UIntArg bench;
+    sys::BoolArg json;
     sys::BoolArg help;
 
     CommandLine(int argc, const char **argv);
@@ -20,6 +73,11 @@ CommandLine::CommandLine(int argc, const char **argv)
     clp.parameter(filename).placeholder("FILE").description("The filename to load and parse.");
     clp.option(help).name("help").shortName("h").description("Display this help message.");
     clp.option(verbose).name("verbose").shortName("v").description("Display information by objects.");
+    clp.option(threads).name("threads").shortName("j").description("Number of threads used to parse the file (0 for all available cores).");
+    clp.option(reserve).name("reserve").shortName("r").description("Count elements before parsing to reserve memory.");
+    clp.option(arena).name("arena").description("Allocate temporary parsing data in an arena.");
+    clp.option(bench).name("bench").shortName("b").description("Load the file N times and report statistics about each loading phase.");
+    clp.option(json).name("json").description("Report benchmark statistics in JSON format on the standard output.");
     clp.validator([this](){
         if(help) return sys::OperationResult::succeeded();
         return sys::OperationResult::test(filename, "Missing OBJ filename!");
@@ -39,21 +97,186 @@ CommandLine::CommandLine(int argc, const char **argv)
     }
 }
 
+namespace
+{
+
+struct Allocations
+{
+    std::size_t count;
+    std::size_t bytes;
+};
+
+struct Phase
+{
+    Phase(const char *name) : name(name), allocations{0, 0}, hasAllocations(false) {}
+
+    const char *name;
+    std::vector<unsigned long long> durations;
+    Allocations allocations;
+    bool hasAllocations;
+
+    // In milliseconds
+    double percentile(unsigned int p) const
+    {
+        std::vector<unsigned long long> sorted(durations);
+        std::sort(sorted.begin(), sorted.end());
+        std::size_t rank = (sorted.size() * p + 99) / 100;
+        return sorted[std::max<std::size_t>(rank, 1) - 1] / 1000.0;
+    }
+};
+
+class AllocationCounter
+{
+public:
+    AllocationCounter() : _count(nbAllocations.load()), _bytes(nbAllocatedBytes.load())
+    {
+    }
+
+    Allocations allocations() const
+    {
+        return Allocations{nbAllocations.load() - _count, nbAllocatedBytes.load() - _bytes};
+    }
+
+private:
+    std::size_t _count;
+    std::size_t _bytes;
+};
+
+template<typename Function>
+void measure(Phase &phase, Function function)
+{
+    AllocationCounter allocationCounter;
+    sys::Duration duration;
+    function();
+    phase.durations.push_back(duration.elapsedMicroseconds());
+    phase.allocations = allocationCounter.allocations();
+    phase.hasAllocations = true;
+}
+
+std::string jsonString(const char *value)
+{
+    std::string json("\"");
+    for (; *value != 0; ++value)
+    {
+        if (*value == '"' || *value == '\\')
+        {
+            json += '\\';
+        }
+        json += *value;
+    }
+    return json + "\"";
+}
+
+int benchmark(const CommandLine &cmdLine, const vfm::LoadOptions &loadOptions)
+{
+    std::vector<Phase> phases{"read", "tokenize", "index", "triangulate", "load", "computeNormals", "computeTangents"};
+    vfm::LoadProfile profile;
+    for (unsigned int i = 0; i < cmdLine.bench.value(); ++i)
+    {
+        {
+            vfm::ObjModel model;
+            vfm::ObjModelLoading loading = vfm::profile(cmdLine.filename.value(), model, profile);
+            if (!loading)
+            {
+                std::clog << "Cannot open file " << cmdLine.filename.value() << ": " << loading.message() << std::endl;
+                return 1;
+            }
+            phases[0].durations.push_back(profile.read);
+            phases[1].durations.push_back(profile.tokenize);
+            phases[2].durations.push_back(profile.index);
+            phases[3].durations.push_back(profile.triangulate);
+        }
+
+        vfm::ObjModel model;
+        measure(phases[4], [&]() { vfm::load(cmdLine.filename.value(), model, loadOptions); });
+        measure(phases[5], [&]() { model.computeNormals(false, loadOptions.nbThreads); });
+        measure(phases[6], [&]() { model.computeTangents(loadOptions.nbThreads); });
+    }
+
+    double loadSeconds = std::max(phases[4].percentile(50), 0.001) / 1000.0;
+    double bytesPerSecond = profile.nbBytes / loadSeconds;
+    double facesPerSecond = profile.nbFaces / loadSeconds;
+    std::size_t peakMemory = sys::peakMemoryUsage();
+
+    if (cmdLine.json.value())
+    {
+        std::cout << "{" << std::endl;
+        std::cout << "  \"file\": " << jsonString(cmdLine.filename.value()) << "," << std::endl;
+        std::cout << "  \"runs\": " << cmdLine.bench.value() << "," << std::endl;
+        std::cout << "  \"threads\": " << loadOptions.nbThreads << "," << std::endl;
+        std::cout << "  \"bytes\": " << profile.nbBytes << "," << std::endl;
+        std::cout << "  \"faces\": " << profile.nbFaces << "," << std::endl;
+        std::cout << "  \"phases\": {" << std::endl;
+        for (std::size_t i = 0; i < phases.size(); ++i)
+        {
+            const Phase &phase = phases[i];
+            std::cout << "    \"" << phase.name << "\": {\"minMs\": " << phase.percentile(0) << ", \"medianMs\": " << phase.percentile(50) << ", \"p95Ms\": " << phase.percentile(95);
+            if (phase.hasAllocations)
+            {
+                std::cout << ", \"allocations\": " << phase.allocations.count << ", \"allocatedBytes\": " << phase.allocations.bytes;
+            }
+            std::cout << "}" << (i + 1 < phases.size() ? "," : "") << std::endl;
+        }
+        std::cout << "  }," << std::endl;
+        std::cout << "  \"bytesPerSecond\": " << bytesPerSecond << "," << std::endl;
+        std::cout << "  \"facesPerSecond\": " << facesPerSecond << "," << std::endl;
+        std::cout << "  \"peakRssBytes\": " << peakMemory << std::endl;
+        std::cout << "}" << std::endl;
+        return 0;
+    }
+
+    std::clog << "Benchmark of " << cmdLine.filename.value() << ": " << cmdLine.bench.value() << " runs, "
+              << profile.nbBytes << " bytes, " << profile.nbFaces << " faces" << std::endl;
+    std::clog << std::setw(16) << "phase" << std::setw(12) << "min ms" << std::setw(12) << "median ms" << std::setw(12) << "p95 ms" << std::setw(14) << "allocations" << std::setw(14) << "KiB" << std::endl;
+    std::clog << std::fixed << std::setprecision(3);
+    for (const Phase &phase : phases)
+    {
+        std::clog << std::setw(16) << phase.name << std::setw(12) << phase.percentile(0) << std::setw(12) << phase.percentile(50) << std::setw(12) << phase.percentile(95);
+        if (phase.hasAllocations)
+        {
+            std::clog << std::setw(14) << phase.allocations.count << std::setw(14) << phase.allocations.bytes / 1024;
+        }
+        std::clog << std::endl;
+    }
+    std::clog << std::setprecision(1);
+    std::clog << std::setw(12) << "Load: " << bytesPerSecond / (1024 * 1024) << " MiB/s, " << facesPerSecond << " faces/s" << std::endl;
+    std::clog << std::setw(12) << "Peak RSS: " << peakMemory / 1024 << " KiB" << std::endl;
+    return 0;
+}
+
+}
+
 int main (int argc, const char **argv)
 {
     CommandLine cmdLine(argc, argv);
 
-    std::ifstream ifs(cmdLine.filename.value());
-    if (!ifs.is_open())
+    vfm::LoadOptions loadOptions;
+    if (cmdLine.threads)
     {
-        std::clog << "Cannot open file " << cmdLine.filename.value() << std::endl;
-        return 1;
+        loadOptions.nbThreads = cmdLine.threads.value();
+    }
+    loadOptions.reserveCapacities = cmdLine.reserve.value();
+    loadOptions.scratchArena = cmdLine.arena.value();
+
+    if (cmdLine.bench.value() > 0)
+    {
+        return benchmark(cmdLine, loadOptions);
     }
 
+    std::size_t peakMemoryBefore = sys::peakMemoryUsage();
+
     vfm::ObjModel model;
-    ifs >> model;
-    ifs.close();
+    vfm::ObjModelLoading loading = vfm::load(cmdLine.filename.value(), model, loadOptions);
+    if (!loading)
+    {
+        std::clog << "Cannot open file " << cmdLine.filename.value() << ": " << loading.message() << std::endl;
+        return 1;
+    }
+
+    std::size_t peakMemoryAfter = sys::peakMemoryUsage();
 
+    std::clog << std::setw(12) << "Loading: " << loading.duration() << " ms" << std::endl;
+    std::clog << std::setw(12) << "Peak RSS: " << peakMemoryBefore / 1024 << " KiB before loading, " << peakMemoryAfter / 1024 << " KiB after" << std::endl;
     std::clog << std::setw(12) << "Vertices: " << model.positions.size() << std::endl;
     std::clog << std::setw(12) << "Normals: " << model.normals.size() << std::endl;
     std::clog << std::setw(12) << "Textures: " << model.textures.size() << std::endl;
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include "Camera.hpp"
+#include "FrustumCulling.hpp"
+
+namespace
+{
+
+// Unit cubes along the x axis at 5 units in front of the camera.
+ogl::BoundingBoxArrays createBoxes(std::size_t nbBoxes)
+{
+    ogl::BoundingBoxArrays boxes;
+    for (std::size_t i = 0; i < nbBoxes; ++i)
+    {
+        float x = 2.0f * static_cast<float>(i) - static_cast<float>(nbBoxes);
+        boxes.push_back(glm::vec3(x - 0.5f, -0.5f, -5.5f), glm::vec3(x + 0.5f, 0.5f, -4.5f));
+    }
+    return boxes;
+}
+
+}
+
+TEST(FrustumCulling, canTestSpheresAndBoxes)
+{
+    ogl::PerspectiveCamera camera;
+    ogl::Frustum frustum(camera.projectionMatrix());
+
+    ASSERT_TRUE(frustum.intersectsSphere(glm::vec3(.0f, .0f, -5.0f), 1.0f));
+    ASSERT_FALSE(frustum.intersectsSphere(glm::vec3(.0f, .0f, 5.0f), 1.0f));
+    ASSERT_TRUE(frustum.intersectsSphere(glm::vec3(.0f, .0f, 0.5f), 1.0f));
+    ASSERT_FALSE(frustum.intersectsSphere(glm::vec3(100.0f, .0f, -5.0f), 1.0f));
+
+    ASSERT_TRUE(frustum.intersectsBox(glm::vec3(-1.0f, -1.0f, -6.0f), glm::vec3(1.0f, 1.0f, -4.0f)));
+    ASSERT_FALSE(frustum.intersectsBox(glm::vec3(-1.0f, -1.0f, 4.0f), glm::vec3(1.0f, 1.0f, 6.0f)));
+    ASSERT_FALSE(frustum.intersectsBox(glm::vec3(99.0f, -1.0f, -6.0f), glm::vec3(101.0f, 1.0f, -4.0f)));
+    // Box containing the camera.
+    ASSERT_TRUE(frustum.intersectsBox(glm::vec3(-100.0f), glm::vec3(100.0f)));
+}
+
+TEST(FrustumCulling, detectsBoxesCrossingTheNearPlane)
+{
+    ogl::PerspectiveCamera camera;
+    ogl::Frustum frustum(camera.projectionMatrix());
+
+    ASSERT_FALSE(frustum.crossesNearPlane(glm::vec3(-1.0f, -1.0f, -6.0f), glm::vec3(1.0f, 1.0f, -4.0f)));
+    ASSERT_TRUE(frustum.crossesNearPlane(glm::vec3(-1.0f, -1.0f, -6.0f), glm::vec3(1.0f, 1.0f, -0.4f)));
+    ASSERT_TRUE(frustum.crossesNearPlane(glm::vec3(-100.0f), glm::vec3(100.0f)));
+}
+
+TEST(FrustumCulling, cullsBoxesWithAllInstructionSets)
+{
+    ogl::PerspectiveCamera camera;
+    camera.viewport().set(1000, 1000);
+    ogl::Frustum frustum(camera.projectionMatrix());
+    ogl::BoundingBoxArrays boxes = createBoxes(37);
+
+    std::vector<unsigned char> expected;
+    for (std::size_t i = 0; i < boxes.size(); ++i)
+    {
+        expected.push_back(frustum.intersectsBox(glm::vec3(boxes.minX[i], boxes.minY[i], boxes.minZ[i]), glm::vec3(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i])) ? 1 : 0);
+    }
+    // At 5 units with a 70 degrees field of view, the visible half width is 3.5.
+    ASSERT_EQ(0u, expected.front());
+    ASSERT_EQ(1u, expected[boxes.size() / 2]);
+    ASSERT_EQ(0u, expected.back());
+
+    for (vfm::InstructionSet instructionSet : {vfm::InstructionSet::SCALAR, vfm::InstructionSet::SSE2, vfm::InstructionSet::AVX})
+    {
+        if (instructionSet > vfm::widestInstructionSet())
+        {
+            continue;
+        }
+        std::vector<unsigned char> visible;
+        ogl::cullBoundingBoxes(frustum, boxes, visible, instructionSet);
+        ASSERT_EQ(expected, visible) << static_cast<int>(instructionSet);
+    }
+}
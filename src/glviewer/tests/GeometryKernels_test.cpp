@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include "glm/geometric.hpp"
+#include "GeometryKernels.hpp"
+
+namespace
+{
+
+const std::size_t N = vfm::TRIANGLE_BATCH_SIZE;
+
+float nextFloat(std::uint32_t &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / static_cast<float>(1u << 24) * 2.0f - 1.0f;
+}
+
+template<typename Batch>
+void fill(Batch &batch, std::uint32_t &state)
+{
+    float *values = reinterpret_cast<float*>(&batch);
+    for (std::size_t i = 0; i < sizeof(Batch) / sizeof(float); ++i)
+    {
+        values[i] = nextFloat(state);
+    }
+}
+
+glm::vec3 lane(const vfm::Vec3Batch &batch, std::size_t i)
+{
+    return glm::vec3(batch.x[i], batch.y[i], batch.z[i]);
+}
+
+std::vector<vfm::InstructionSet> supportedInstructionSets()
+{
+    std::vector<vfm::InstructionSet> instructionSets;
+    for (int i = 0; i <= static_cast<int>(vfm::widestInstructionSet()); ++i)
+    {
+        instructionSets.push_back(static_cast<vfm::InstructionSet>(i));
+    }
+    return instructionSets;
+}
+
+}
+
+TEST(GeometryKernels, canComputeFaceNormals)
+{
+    std::uint32_t state = 1;
+    vfm::Vec3Batch positions[3];
+    for (vfm::Vec3Batch &p : positions)
+    {
+        fill(p, state);
+    }
+
+    for (vfm::InstructionSet instructionSet : supportedInstructionSets())
+    {
+        vfm::Vec3Batch normals;
+        vfm::computeFaceNormals(positions, normals, instructionSet);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            glm::vec3 a = lane(positions[0], i);
+            glm::vec3 expected = glm::normalize(glm::cross(lane(positions[1], i) - a, lane(positions[2], i) - a));
+            EXPECT_NEAR(expected.x, normals.x[i], 1e-5f) << static_cast<int>(instructionSet);
+            EXPECT_NEAR(expected.y, normals.y[i], 1e-5f) << static_cast<int>(instructionSet);
+            EXPECT_NEAR(expected.z, normals.z[i], 1e-5f) << static_cast<int>(instructionSet);
+        }
+    }
+}
+
+TEST(GeometryKernels, canComputeTangentDirections)
+{
+    std::uint32_t state = 2;
+    vfm::Vec3Batch positions[3];
+    vfm::Vec2Batch textures[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        fill(positions[i], state);
+        fill(textures[i], state);
+    }
+
+    vfm::Vec3Batch expectedSdir;
+    vfm::Vec3Batch expectedTdir;
+    vfm::computeTangentDirections(positions, textures, expectedSdir, expectedTdir, vfm::InstructionSet::SCALAR);
+    for (vfm::InstructionSet instructionSet : supportedInstructionSets())
+    {
+        vfm::Vec3Batch sdir;
+        vfm::Vec3Batch tdir;
+        vfm::computeTangentDirections(positions, textures, sdir, tdir, instructionSet);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            float tolerance = 1e-5f * (1.0f + glm::length(lane(expectedSdir, i)) + glm::length(lane(expectedTdir, i)));
+            EXPECT_NEAR(expectedSdir.x[i], sdir.x[i], tolerance) << static_cast<int>(instructionSet);
+            EXPECT_NEAR(expectedSdir.y[i], sdir.y[i], tolerance) << static_cast<int>(instructionSet);
+            EXPECT_NEAR(expectedSdir.z[i], sdir.z[i], tolerance) << static_cast<int>(instructionSet);
+            EXPECT_NEAR(expectedTdir.x[i], tdir.x[i], tolerance) << static_cast<int>(instructionSet);
+            EXPECT_NEAR(expectedTdir.y[i], tdir.y[i], tolerance) << static_cast<int>(instructionSet);
+            EXPECT_NEAR(expectedTdir.z[i], tdir.z[i], tolerance) << static_cast<int>(instructionSet);
+        }
+    }
+}
+
+TEST(GeometryKernels, canOrthogonalizeTangents)
+{
+    std::uint32_t state = 3;
+    vfm::Vec3Batch normals;
+    vfm::Vec3Batch sdir;
+    vfm::Vec3Batch tdir;
+    fill(normals, state);
+    fill(sdir, state);
+    fill(tdir, state);
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        glm::vec3 n = glm::normalize(lane(normals, i));
+        normals.x[i] = n.x;
+        normals.y[i] = n.y;
+        normals.z[i] = n.z;
+    }
+
+    for (vfm::InstructionSet instructionSet : supportedInstructionSets())
+    {
+        vfm::Vec4Batch tangents;
+        vfm::orthogonalizeTangents(normals, sdir, tdir, tangents, instructionSet);
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            glm::vec3 n = lane(normals, i);
+            glm::vec3 t = lane(sdir, i);
+            glm::vec3 expected = glm::normalize(t - n * glm::dot(n, t));
+            float w = glm::dot(glm::cross(n, t), lane(tdir, i)) < .0f ? -1.0f : 1.0f;
+            EXPECT_NEAR(expected.x, tangents.x[i], 1e-5f) << static_cast<int>(instructionSet);
+            EXPECT_NEAR(expected.y, tangents.y[i], 1e-5f) << static_cast<int>(instructionSet);
+            EXPECT_NEAR(expected.z, tangents.z[i], 1e-5f) << static_cast<int>(instructionSet);
+            EXPECT_EQ(w, tangents.w[i]) << static_cast<int>(instructionSet);
+        }
+    }
+}
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include "GlMeshCache.hpp"
+
+namespace
+{
+
+const char *OBJ_FILENAME = "glmeshcache.test.obj";
+const char *CACHE_FILENAME = "glmeshcache.test.obj.vfmb";
+
+void writeObjFile(const char *content)
+{
+    std::ofstream ofs(OBJ_FILENAME, std::ios::binary);
+    ofs << content;
+}
+
+ogl::GlMeshData createMeshData()
+{
+    ogl::GlMeshData data;
+    data.indexFormat = GL_UNSIGNED_BYTE;
+    data.quantizedVertexAttributes = true;
+    data.vertexAttributes = {0, 1, 2, 3, 4, 5, 6};
+    data.indices = {0, 1, 2};
+    data.materialGroups.push_back(ogl::MaterialGroup(1, 3));
+    data.materialGroups[0].boundingBox.accept(-1.0f, 2.0f, 3.0f);
+    ogl::LevelOfDetail levelOfDetail;
+    levelOfDetail.error = 0.25f;
+    levelOfDetail.firstIndex = 3;
+    levelOfDetail.materialGroups.push_back(ogl::MaterialGroup(1, 0));
+    data.levelsOfDetail.push_back(levelOfDetail);
+    ogl::Meshlet meshlet;
+    meshlet.nbIndices = 3;
+    meshlet.center = glm::vec3(1.0f, 2.0f, 3.0f);
+    meshlet.radius = 4.0f;
+    meshlet.coneAxis = glm::vec3(.0f, 1.0f, .0f);
+    meshlet.coneCutoff = 0.5f;
+    data.meshlets.push_back(meshlet);
+    data.boundingBox.accept(-1.0f, 2.0f, 3.0f);
+    data.boundingBox.accept(1.0f, -2.0f, 4.0f);
+    return data;
+}
+
+}
+
+TEST(GlMeshCache, hasCacheFilenameNextToObjFile)
+{
+    std::string filename = ogl::meshCacheFilename(OBJ_FILENAME, ogl::VertexAttributeDeclarationVector(), ogl::GlMeshOptions());
+
+    ASSERT_EQ(0u, filename.find(std::string(OBJ_FILENAME) + "."));
+    ASSERT_EQ(std::string(OBJ_FILENAME).size() + 22, filename.size());
+}
+
+TEST(GlMeshCache, canSaveAndLoadCache)
+{
+    writeObjFile("v 0 0 0\n");
+    ogl::VertexAttributeDeclarationVector vads;
+    ogl::GlMeshOptions options;
+    options.levelsOfDetail = {0.5f};
+    options.buildMeshlets = true;
+    options.quantizeVertexAttributes = true;
+    ogl::GlMeshData data = createMeshData();
+    vfm::MaterialIdVector materialIds(1);
+    materialIds[0].library = "materials.mtl";
+    materialIds[0].name = "red";
+
+    ASSERT_TRUE(ogl::saveMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, data, materialIds));
+    ogl::GlMeshData cachedData;
+    vfm::MaterialIdVector cachedMaterialIds;
+    ogl::GlMeshGeneration loading = ogl::loadMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, cachedData, cachedMaterialIds);
+    std::remove(CACHE_FILENAME);
+    std::remove(OBJ_FILENAME);
+
+    ASSERT_TRUE(loading) << loading.message();
+    ASSERT_EQ(data.indexFormat, cachedData.indexFormat);
+    ASSERT_TRUE(cachedData.quantizedVertexAttributes);
+    ASSERT_EQ(data.vertexAttributes, cachedData.vertexAttributes);
+    ASSERT_EQ(data.indices, cachedData.indices);
+    ASSERT_EQ(1u, cachedData.materialGroups.size());
+    ASSERT_EQ(1u, cachedData.materialGroups[0].index);
+    ASSERT_EQ(3u, cachedData.materialGroups[0].size);
+    ASSERT_EQ(data.materialGroups[0].boundingBox.min, cachedData.materialGroups[0].boundingBox.min);
+    ASSERT_EQ(data.materialGroups[0].boundingBox.max, cachedData.materialGroups[0].boundingBox.max);
+    ASSERT_EQ(1u, cachedData.levelsOfDetail.size());
+    ASSERT_EQ(0.25f, cachedData.levelsOfDetail[0].error);
+    ASSERT_EQ(3u, cachedData.levelsOfDetail[0].firstIndex);
+    ASSERT_EQ(1u, cachedData.levelsOfDetail[0].materialGroups.size());
+    ASSERT_EQ(0u, cachedData.levelsOfDetail[0].materialGroups[0].size);
+    ASSERT_EQ(1u, cachedData.meshlets.size());
+    ASSERT_EQ(0u, cachedData.meshlets[0].firstIndex);
+    ASSERT_EQ(3u, cachedData.meshlets[0].nbIndices);
+    ASSERT_EQ(glm::vec3(1.0f, 2.0f, 3.0f), cachedData.meshlets[0].center);
+    ASSERT_EQ(4.0f, cachedData.meshlets[0].radius);
+    ASSERT_EQ(glm::vec3(.0f, 1.0f, .0f), cachedData.meshlets[0].coneAxis);
+    ASSERT_EQ(0.5f, cachedData.meshlets[0].coneCutoff);
+    ASSERT_EQ(data.boundingBox.min, cachedData.boundingBox.min);
+    ASSERT_EQ(data.boundingBox.max, cachedData.boundingBox.max);
+    ASSERT_EQ(1u, cachedMaterialIds.size());
+    ASSERT_EQ("materials.mtl", cachedMaterialIds[0].library);
+    ASSERT_EQ("red", cachedMaterialIds[0].name);
+}
+
+TEST(GlMeshCache, cannotLoadOutdatedCache)
+{
+    writeObjFile("v 0 0 0\n");
+    ogl::VertexAttributeDeclarationVector vads;
+    ogl::GlMeshOptions options;
+    options.quantizeVertexAttributes = true;
+    ASSERT_TRUE(ogl::saveMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, createMeshData(), vfm::MaterialIdVector()));
+    writeObjFile("v 0 0 0\nv 1 1 1\n");
+
+    ogl::GlMeshData cachedData;
+    vfm::MaterialIdVector cachedMaterialIds;
+    ogl::GlMeshGeneration loading = ogl::loadMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, cachedData, cachedMaterialIds);
+    std::remove(CACHE_FILENAME);
+    std::remove(OBJ_FILENAME);
+
+    ASSERT_FALSE(loading);
+    ASSERT_EQ("Mesh cache file is outdated!", loading.message());
+}
+
+TEST(GlMeshCache, hasCacheFilenameByMeshOptions)
+{
+    ogl::VertexAttributeDeclarationVector vads;
+    ogl::GlMeshOptions options;
+    std::string filename = ogl::meshCacheFilename(OBJ_FILENAME, vads, options);
+    options.nbThreads = 4;
+    ASSERT_EQ(filename, ogl::meshCacheFilename(OBJ_FILENAME, vads, options));
+
+    ogl::GlMeshOptions levelsOfDetail;
+    levelsOfDetail.levelsOfDetail = {0.5f};
+    ogl::GlMeshOptions otherLevelsOfDetail;
+    otherLevelsOfDetail.levelsOfDetail = {0.25f};
+    ogl::GlMeshOptions vertexCache;
+    vertexCache.optimizeVertexCache = true;
+    ogl::GlMeshOptions vertexFetch;
+    vertexFetch.optimizeVertexFetch = true;
+    ogl::GlMeshOptions meshlets;
+    meshlets.buildMeshlets = true;
+    ogl::GlMeshOptions quantization;
+    quantization.quantizeVertexAttributes = true;
+    for (const ogl::GlMeshOptions *otherOptions : {&levelsOfDetail, &otherLevelsOfDetail, &vertexCache, &vertexFetch, &meshlets, &quantization})
+    {
+        ASSERT_NE(filename, ogl::meshCacheFilename(OBJ_FILENAME, vads, *otherOptions));
+    }
+    ASSERT_NE(ogl::meshCacheFilename(OBJ_FILENAME, vads, levelsOfDetail), ogl::meshCacheFilename(OBJ_FILENAME, vads, otherLevelsOfDetail));
+}
+
+TEST(GlMeshCache, cannotLoadCacheOfOtherMeshOptions)
+{
+    writeObjFile("v 0 0 0\n");
+    ogl::VertexAttributeDeclarationVector vads;
+    ogl::GlMeshOptions options;
+    ASSERT_TRUE(ogl::saveMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, createMeshData(), vfm::MaterialIdVector()));
+    options.levelsOfDetail = {0.5f};
+
+    ogl::GlMeshData cachedData;
+    vfm::MaterialIdVector cachedMaterialIds;
+    ogl::GlMeshGeneration loading = ogl::loadMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, cachedData, cachedMaterialIds);
+    std::remove(CACHE_FILENAME);
+    std::remove(OBJ_FILENAME);
+
+    ASSERT_FALSE(loading);
+    ASSERT_EQ("Mesh cache file does not match the vertex attributes and the mesh options!", loading.message());
+}
+
+TEST(GlMeshCache, cannotLoadCacheWithoutMeshletsWhenBuildingThem)
+{
+    writeObjFile("v 0 0 0\n");
+    ogl::VertexAttributeDeclarationVector vads;
+    ogl::GlMeshOptions options;
+    ogl::GlMeshData data = createMeshData();
+    data.meshlets.clear();
+    ASSERT_TRUE(ogl::saveMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, data, vfm::MaterialIdVector()));
+    options.buildMeshlets = true;
+
+    ogl::GlMeshData cachedData;
+    vfm::MaterialIdVector cachedMaterialIds;
+    ogl::GlMeshGeneration loading = ogl::loadMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, cachedData, cachedMaterialIds);
+    std::remove(CACHE_FILENAME);
+    std::remove(OBJ_FILENAME);
+
+    ASSERT_FALSE(loading);
+}
+
+TEST(GlMeshCache, cannotLoadCacheOfOtherVertexAttributeFormat)
+{
+    writeObjFile("v 0 0 0\n");
+    ogl::VertexAttributeDeclarationVector vads;
+    ogl::GlMeshOptions options;
+    ogl::GlMeshData data = createMeshData();
+    data.quantizedVertexAttributes = false;
+    ASSERT_TRUE(ogl::saveMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, data, vfm::MaterialIdVector()));
+    options.quantizeVertexAttributes = true;
+
+    ogl::GlMeshData cachedData;
+    vfm::MaterialIdVector cachedMaterialIds;
+    ogl::GlMeshGeneration loading = ogl::loadMeshCache(CACHE_FILENAME, OBJ_FILENAME, vads, options, cachedData, cachedMaterialIds);
+    std::remove(CACHE_FILENAME);
+    std::remove(OBJ_FILENAME);
+
+    ASSERT_FALSE(loading);
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <sstream>
+#include "GlMesh.hpp"
+
+TEST(GlMesh, fillsDrawCommandsOfDrawCalls)
+{
+    ogl::DrawCallVector drawCalls = {ogl::DrawCall{1, 0, 96}, ogl::DrawCall{2, 192, 48}, ogl::DrawCall{ogl::MaterialHandler::NO_MATERIAL_INDEX, 600, 3}};
+
+    ogl::DrawElementsIndirectCommandVector commands;
+    std::vector<GLuint> materialIndices;
+    ogl::GlMesh::fillDrawCommands(drawCalls, commands, materialIndices);
+
+    ASSERT_EQ(drawCalls.size(), commands.size());
+    ASSERT_EQ(drawCalls.size(), materialIndices.size());
+    for (std::size_t i = 0; i < drawCalls.size(); ++i)
+    {
+        ASSERT_EQ(drawCalls[i].nbIndices, commands[i].count);
+        ASSERT_EQ(1u, commands[i].instanceCount);
+        ASSERT_EQ(drawCalls[i].firstIndex, commands[i].firstIndex);
+        ASSERT_EQ(0, commands[i].baseVertex);
+        ASSERT_EQ(0u, commands[i].baseInstance);
+    }
+    ASSERT_EQ(1u, materialIndices[0]);
+    ASSERT_EQ(2u, materialIndices[1]);
+    ASSERT_EQ(std::numeric_limits<GLuint>::max(), materialIndices[2]);
+    ASSERT_EQ(20u, sizeof(ogl::DrawElementsIndirectCommand));
+}
+
+TEST(GlMesh, clearsPreviousDrawCommands)
+{
+    ogl::DrawElementsIndirectCommandVector commands(2);
+    std::vector<GLuint> materialIndices(2);
+    ogl::GlMesh::fillDrawCommands(ogl::DrawCallVector{ogl::DrawCall{3, 6, 9}}, commands, materialIndices);
+
+    ASSERT_EQ(1u, commands.size());
+    ASSERT_EQ(9u, commands[0].count);
+    ASSERT_EQ(6u, commands[0].firstIndex);
+    ASSERT_EQ(std::vector<GLuint>{3}, materialIndices);
+}
+
+TEST(GlMesh, preparesVertexAttributesWithoutInstanceAttributes)
+{
+    std::istringstream modelStream("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n");
+    vfm::ObjModel model;
+    modelStream >> model;
+    ogl::VertexAttributeDeclarationVector vads;
+    vads.push_back(ogl::VertexAttributeDeclaration(0, 1, GL_FLOAT_VEC3, "vertexPosition"));
+    vads.push_back(ogl::VertexAttributeDeclaration(1, 1, GL_FLOAT_VEC3, "vertexNormal"));
+    vads.push_back(ogl::VertexAttributeDeclaration(2, 1, GL_FLOAT_MAT4, "instanceModelMat"));
+    vads.push_back(ogl::VertexAttributeDeclaration(6, 1, GL_FLOAT_VEC4, "instanceColor"));
+
+    ogl::GlMeshData data;
+    ogl::GlMeshGeneration preparation = ogl::GlMesh::prepare(model, vads, data);
+
+    ASSERT_TRUE(preparation) << preparation.message();
+    ASSERT_EQ(3u, data.indices.size());
+    ASSERT_EQ(3u * 6u * sizeof(GLfloat), data.vertexAttributes.size());
+}
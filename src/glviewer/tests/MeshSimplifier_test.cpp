@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "GlMesh.hpp"
+#include "MeshSimplifier.hpp"
+
+namespace
+{
+
+const GLuint SIZE = 16;
+
+// Triangles of a grid of SIZE x SIZE quads, on a bump when height is not 0.
+std::vector<GLuint> createGrid(std::vector<glm::vec3> &positions, float height = .0f)
+{
+    for (GLuint y = 0; y <= SIZE; ++y)
+    {
+        for (GLuint x = 0; x <= SIZE; ++x)
+        {
+            float u = static_cast<float>(x) / SIZE - 0.5f;
+            float v = static_cast<float>(y) / SIZE - 0.5f;
+            positions.push_back(glm::vec3(u, v, height * std::exp(-8.0f * (u * u + v * v))));
+        }
+    }
+    std::vector<GLuint> indices;
+    for (GLuint y = 0; y < SIZE; ++y)
+    {
+        for (GLuint x = 0; x < SIZE; ++x)
+        {
+            GLuint v = y * (SIZE + 1) + x;
+            indices.insert(indices.end(), {v, v + 1, v + SIZE + 2, v, v + SIZE + 2, v + SIZE + 1});
+        }
+    }
+    return indices;
+}
+
+// OBJ model of the grid triangles.
+void createGridModel(vfm::ObjModel &model, float height)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<GLuint> indices = createGrid(positions, height);
+    std::ostringstream obj;
+    for (const glm::vec3 &position : positions)
+    {
+        obj << "v " << position.x << " " << position.y << " " << position.z << "\n";
+    }
+    for (std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        obj << "f " << indices[i] + 1 << " " << indices[i + 1] + 1 << " " << indices[i + 2] + 1 << "\n";
+    }
+    std::istringstream modelStream(obj.str());
+    modelStream >> model;
+}
+
+bool isBorder(GLuint vertex)
+{
+    GLuint x = vertex % (SIZE + 1);
+    GLuint y = vertex / (SIZE + 1);
+    return x == 0 || y == 0 || x == SIZE || y == SIZE;
+}
+
+}
+
+TEST(MeshSimplifier, canSimplifyPlaneWithoutError)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<GLuint> indices = createGrid(positions);
+
+    float error;
+    std::vector<GLuint> simplified = ogl::simplify(indices.data(), indices.size(), indices.size() / 4, positions, std::vector<bool>(positions.size()), error);
+
+    ASSERT_LE(simplified.size(), indices.size() / 4);
+    ASSERT_EQ(0u, simplified.size() % 3);
+    ASSERT_NEAR(.0f, error, 1e-5f);
+}
+
+TEST(MeshSimplifier, keepsBorderAndLockedVertices)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<GLuint> indices = createGrid(positions, 0.5f);
+    std::vector<bool> locked(positions.size());
+    GLuint center = (SIZE / 2) * (SIZE + 1) + SIZE / 2;
+    locked[center] = true;
+
+    float error;
+    std::vector<GLuint> simplified = ogl::simplify(indices.data(), indices.size(), 0, positions, locked, error);
+
+    ASSERT_LT(simplified.size(), indices.size() / 2);
+    ASSERT_GT(error, .0f);
+    ASSERT_NE(simplified.end(), std::find(simplified.begin(), simplified.end(), center));
+    for (GLuint vertex = 0; vertex < positions.size(); ++vertex)
+    {
+        if (isBorder(vertex))
+        {
+            ASSERT_NE(simplified.end(), std::find(simplified.begin(), simplified.end(), vertex)) << vertex;
+        }
+    }
+}
+
+TEST(MeshSimplifier, selectsLevelOfDetailFromProjectedSize)
+{
+    ogl::BoundingBox boundingBox;
+    boundingBox.accept(-1.0f, -1.0f, -1.0f);
+    boundingBox.accept(1.0f, 1.0f, 1.0f);
+    ogl::LevelOfDetailVector levelsOfDetail(3);
+    levelsOfDetail[0].error = 0.001f;
+    levelsOfDetail[1].error = 0.01f;
+    levelsOfDetail[2].error = 0.1f;
+    // 90 degrees field of view: the bounding box diagonal covers 1732 / distance pixels.
+    ogl::PerspectiveCamera camera(2.0f * std::atan(1.0f));
+    camera.viewport().set(1000, 1000);
+
+    auto levelAt = [&](float distance)
+    {
+        glm::mat4 modelView(1.0f);
+        modelView[3] = glm::vec4(.0f, .0f, -distance, 1.0f);
+        return ogl::GlMesh::selectLevelOfDetail(levelsOfDetail, boundingBox, camera, modelView);
+    };
+
+    ASSERT_EQ(0u, levelAt(1.0f));
+    ASSERT_EQ(0u, levelAt(1.5f));
+    ASSERT_EQ(1u, levelAt(10.0f));
+    ASSERT_EQ(2u, levelAt(100.0f));
+    ASSERT_EQ(3u, levelAt(1000.0f));
+    ASSERT_EQ(0u, ogl::GlMesh::selectLevelOfDetail(ogl::LevelOfDetailVector(), boundingBox, camera, glm::mat4(1.0f)));
+}
+
+TEST(MeshSimplifier, accumulatesErrorOfSuccessiveLevelsOfDetail)
+{
+    vfm::ObjModel model;
+    createGridModel(model, 0.5f);
+    ogl::GlMeshOptions options;
+    options.levelsOfDetail = {0.25f, 0.2f, 0.18f};
+
+    ogl::VertexAttributeDeclarationVector vads;
+    vads.push_back(ogl::VertexAttributeDeclaration(0, 1, GL_FLOAT_VEC4, "vertexPosition"));
+
+    ogl::GlMeshData data;
+    ogl::GlMeshGeneration preparation = ogl::GlMesh::prepare(model, vads, data, options);
+    ASSERT_TRUE(preparation) << preparation.message();
+
+    ASSERT_EQ(3u, data.levelsOfDetail.size());
+    ASSERT_GT(data.levelsOfDetail[0].error, .0f);
+    for (std::size_t level = 1; level < data.levelsOfDetail.size(); ++level)
+    {
+        ASSERT_GE(data.levelsOfDetail[level].error, data.levelsOfDetail[level - 1].error) << level;
+    }
+    ASSERT_GT(data.levelsOfDetail[2].error, data.levelsOfDetail[0].error);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include "GlMesh.hpp"
+#include "MeshletBuilder.hpp"
+
+namespace
+{
+
+const GLuint SIZE = 32;
+
+// Triangles of a grid of SIZE x SIZE quads in the z = 0 plane, facing +z.
+std::vector<GLuint> createGrid(std::vector<glm::vec3> &positions)
+{
+    for (GLuint y = 0; y <= SIZE; ++y)
+    {
+        for (GLuint x = 0; x <= SIZE; ++x)
+        {
+            positions.push_back(glm::vec3(static_cast<float>(x) / SIZE - 0.5f, static_cast<float>(y) / SIZE - 0.5f, .0f));
+        }
+    }
+    std::vector<GLuint> indices;
+    for (GLuint y = 0; y < SIZE; ++y)
+    {
+        for (GLuint x = 0; x < SIZE; ++x)
+        {
+            GLuint v = y * (SIZE + 1) + x;
+            indices.insert(indices.end(), {v, v + 1, v + SIZE + 2, v, v + SIZE + 2, v + SIZE + 1});
+        }
+    }
+    return indices;
+}
+
+std::vector<std::vector<GLuint>> sortedTriangles(const std::vector<GLuint> &indices)
+{
+    std::vector<std::vector<GLuint>> triangles;
+    for (std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        std::vector<GLuint> triangle(&indices[i], &indices[i] + 3);
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+glm::mat4 translation(float x, float y, float z)
+{
+    glm::mat4 matrix(1.0f);
+    matrix[3] = glm::vec4(x, y, z, 1.0f);
+    return matrix;
+}
+
+}
+
+TEST(MeshletBuilder, canSplitTrianglesIntoMeshlets)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<GLuint> indices = createGrid(positions);
+    std::vector<GLuint> meshletIndices = indices;
+
+    ogl::MeshletVector meshlets;
+    ogl::MeshletBuilder().build(meshletIndices.data(), meshletIndices.size(), 6, positions, meshlets);
+
+    ASSERT_EQ(sortedTriangles(indices), sortedTriangles(meshletIndices));
+    ASSERT_LT(meshlets.size(), 2 * indices.size() / (3 * ogl::MAX_MESHLET_TRIANGLES));
+    std::size_t firstIndex = 6;
+    for (const ogl::Meshlet &meshlet : meshlets)
+    {
+        ASSERT_EQ(firstIndex, meshlet.firstIndex);
+        ASSERT_LE(meshlet.nbIndices, 3 * ogl::MAX_MESHLET_TRIANGLES);
+        std::vector<GLuint> vertices(&meshletIndices[meshlet.firstIndex - 6], &meshletIndices[meshlet.firstIndex - 6] + meshlet.nbIndices);
+        std::sort(vertices.begin(), vertices.end());
+        ASSERT_LE(static_cast<std::size_t>(std::unique(vertices.begin(), vertices.end()) - vertices.begin()), ogl::MAX_MESHLET_VERTICES);
+        for (GLuint vertex : vertices)
+        {
+            ASSERT_LE(glm::length(positions[vertex] - meshlet.center), meshlet.radius + 1e-5f);
+        }
+        ASSERT_NEAR(1.0f, meshlet.coneAxis.z, 1e-5f);
+        ASSERT_NEAR(.0f, meshlet.coneCutoff, 1e-3f);
+        firstIndex += meshlet.nbIndices;
+    }
+    ASSERT_EQ(6 + indices.size(), firstIndex);
+}
+
+TEST(MeshletBuilder, cullsMeshletsOutsideFrustumOrFacingAway)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<GLuint> indices = createGrid(positions);
+    ogl::MeshletVector meshlets;
+    ogl::MeshletBuilder().build(indices.data(), indices.size(), 0, positions, meshlets);
+    ogl::MaterialGroupVector materialGroups = {ogl::MaterialGroup(1, indices.size())};
+    ogl::PerspectiveCamera camera;
+
+    // Looking at the grid from the front, then from behind by turning it around y.
+    ogl::DrawCallVector drawCalls = ogl::GlMesh::cullMeshlets(meshlets, materialGroups, camera, translation(.0f, .0f, -2.0f));
+    ASSERT_EQ(1u, drawCalls.size());
+    ASSERT_EQ(1u, drawCalls[0].materialIndex);
+    ASSERT_EQ(0u, drawCalls[0].firstIndex);
+    ASSERT_EQ(indices.size(), drawCalls[0].nbIndices);
+
+    glm::mat4 behind = translation(.0f, .0f, -2.0f);
+    behind[0] = glm::vec4(-1.0f, .0f, .0f, .0f);
+    behind[2] = glm::vec4(.0f, .0f, -1.0f, .0f);
+    ASSERT_TRUE(ogl::GlMesh::cullMeshlets(meshlets, materialGroups, camera, behind).empty());
+
+    ASSERT_TRUE(ogl::GlMesh::cullMeshlets(meshlets, materialGroups, camera, translation(10.0f, .0f, -2.0f)).empty());
+
+    // Half of the grid is on the left of the view.
+    drawCalls = ogl::GlMesh::cullMeshlets(meshlets, materialGroups, camera, translation(-2.0f * std::tan(camera.fovy() / 2.0f) * camera.viewport().aspectRatio(), .0f, -2.0f));
+    std::size_t nbIndices = 0;
+    for (const ogl::DrawCall &drawCall : drawCalls)
+    {
+        nbIndices += drawCall.nbIndices;
+    }
+    ASSERT_GT(nbIndices, 0u);
+    ASSERT_LT(nbIndices, indices.size());
+}
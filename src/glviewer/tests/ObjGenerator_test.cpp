@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include "ObjGenerator.hpp"
+#include "ObjModel.hpp"
+
+namespace
+{
+
+std::string generate(const vfm::GeneratorOptions &options, std::string *materials = nullptr)
+{
+    std::ostringstream obj;
+    std::ostringstream mtl;
+    vfm::ObjGeneration generation = vfm::generate(options, obj, mtl);
+    EXPECT_TRUE(generation) << generation.message();
+    if (materials)
+    {
+        *materials = mtl.str();
+    }
+    return obj.str();
+}
+
+vfm::ObjModel parse(const std::string &content)
+{
+    std::istringstream is(content);
+    vfm::ObjModel model;
+    is >> model;
+    return model;
+}
+
+}
+
+TEST(ObjGenerator, isReproducibleFromSeed)
+{
+    vfm::GeneratorOptions options;
+    options.maxPolygonSize = 8;
+    options.nbMaterials = 4;
+    options.nbMaterialSwitches = 16;
+
+    std::string first = generate(options);
+    ASSERT_EQ(first, generate(options));
+
+    options.seed = 2;
+    ASSERT_NE(first, generate(options));
+}
+
+TEST(ObjGenerator, generatesRequestedElements)
+{
+    vfm::GeneratorOptions options;
+    options.nbVertices = 100;
+    options.nbFaces = 50;
+    options.maxPolygonSize = 3;
+    options.nbObjects = 5;
+    options.nbMaterials = 3;
+    options.nbMaterialSwitches = 10;
+    options.textureCoordinates = true;
+    options.normals = true;
+    options.textureMaps = true;
+
+    std::string materials;
+    vfm::ObjModel model = parse(generate(options, &materials));
+
+    ASSERT_EQ(100u, model.positions.size());
+    ASSERT_EQ(100u, model.textures.size());
+    ASSERT_EQ(100u, model.normals.size());
+    ASSERT_EQ(5u, model.objects.size());
+    ASSERT_EQ(150u, model.nbTriangleVertices());
+    ASSERT_LE(model.materialIds.size(), 3u);
+
+    std::istringstream is(materials);
+    vfm::MaterialMap materialMap;
+    is >> materialMap;
+    ASSERT_EQ(3u, materialMap.size());
+    ASSERT_EQ("textures/material0_diffuse.png", materialMap["material0"].map.diffuse);
+}
+
+TEST(ObjGenerator, negativeIndicesGiveSameModel)
+{
+    vfm::GeneratorOptions options;
+    options.maxPolygonSize = 6;
+    options.normals = true;
+    vfm::ObjModel expected = parse(generate(options));
+
+    options.negativeIndices = true;
+    vfm::ObjModel actual = parse(generate(options));
+
+    ASSERT_EQ(expected.objects.size(), actual.objects.size());
+    ASSERT_EQ(expected.objects[0].vertexIndices, actual.objects[0].vertexIndices);
+    ASSERT_EQ(expected.objects[0].triangles, actual.objects[0].triangles);
+}
+
+TEST(ObjGenerator, cannotGenerateTooLargePolygons)
+{
+    vfm::GeneratorOptions options;
+    options.nbVertices = 9;
+    options.maxPolygonSize = 8;
+    std::ostringstream obj;
+    std::ostringstream mtl;
+
+    ASSERT_FALSE(vfm::generate(options, obj, mtl));
+}
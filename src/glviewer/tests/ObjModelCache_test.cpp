@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "ObjModelCache.hpp"
+
+namespace
+{
+
+const char *OBJ_FILENAME = "objmodelcache.test.obj";
+const char *CACHE_FILENAME = "objmodelcache.test.obj.vfmc";
+
+void writeObjFile(const char *content)
+{
+    std::ofstream ofs(OBJ_FILENAME, std::ios::binary);
+    ofs << content;
+}
+
+}
+
+TEST(ObjModelCache, hasCacheFilenameNextToObjFile)
+{
+    ASSERT_EQ(CACHE_FILENAME, vfm::cacheFilename(OBJ_FILENAME));
+}
+
+TEST(ObjModelCache, cannotLoadUnknownCache)
+{
+    vfm::ObjModel model;
+
+    ASSERT_FALSE(vfm::loadCache("unknown.vfmc", OBJ_FILENAME, model));
+}
+
+TEST(ObjModelCache, canSaveAndLoadCache)
+{
+    writeObjFile(
+        "mtllib materials.mtl\n"
+        "v 0 0 0\n"
+        "v 1 0 0 0.5\n"
+        "v 1 1 0\n"
+        "v 0 1 0\n"
+        "vt 0 0\n"
+        "vn 0 0 1\n"
+        "o square\n"
+        "usemtl red\n"
+        "f 1/1/1 2/1/1 3/1/1 4/1/1\n"
+        "o triangle\n"
+        "f 1 2 3\n"
+    );
+    vfm::ObjModel model;
+    ASSERT_TRUE(vfm::load(OBJ_FILENAME, model));
+    model.computeTangents();
+
+    ASSERT_TRUE(vfm::saveCache(CACHE_FILENAME, OBJ_FILENAME, model));
+    vfm::ObjModel cachedModel;
+    vfm::ObjModelLoading loading = vfm::loadCache(CACHE_FILENAME, OBJ_FILENAME, cachedModel);
+    std::remove(CACHE_FILENAME);
+    std::remove(OBJ_FILENAME);
+
+    ASSERT_TRUE(loading) << loading.message();
+    ASSERT_TRUE(model.positions == cachedModel.positions);
+    ASSERT_TRUE(model.positionWeights == cachedModel.positionWeights);
+    ASSERT_TRUE(model.normals == cachedModel.normals);
+    ASSERT_TRUE(model.textures == cachedModel.textures);
+    // degenerated tangents are NaN: bytes are compared
+    ASSERT_EQ(model.tangents.size(), cachedModel.tangents.size());
+    ASSERT_EQ(0, std::memcmp(model.tangents.data(), cachedModel.tangents.data(), model.tangents.size() * sizeof(glm::vec4)));
+    ASSERT_EQ(model.materialIds.size(), cachedModel.materialIds.size());
+    ASSERT_EQ(model.materialIds[0], cachedModel.materialIds[0]);
+    ASSERT_EQ(2u, cachedModel.objects.size());
+    for (std::size_t i = 0; i < model.objects.size(); ++i)
+    {
+        ASSERT_EQ(model.objects[i].name, cachedModel.objects[i].name);
+        ASSERT_TRUE(model.objects[i].vertexIndices == cachedModel.objects[i].vertexIndices);
+        ASSERT_TRUE(model.objects[i].triangles == cachedModel.objects[i].triangles);
+        ASSERT_EQ(model.objects[i].materialActivations.size(), cachedModel.objects[i].materialActivations.size());
+    }
+    ASSERT_EQ(model.objects[0].materialActivations[0].end, cachedModel.objects[0].materialActivations[0].end);
+}
+
+TEST(ObjModelCache, cannotLoadOutdatedCache)
+{
+    writeObjFile("v 0 0 0\nf 1 1 1\n");
+    vfm::ObjModel model;
+    ASSERT_TRUE(vfm::load(OBJ_FILENAME, model));
+    ASSERT_TRUE(vfm::saveCache(CACHE_FILENAME, OBJ_FILENAME, model));
+
+    writeObjFile("v 0 0 0\nv 1 1 1\nf 1 2 1\n");
+    vfm::ObjModel cachedModel;
+    vfm::ObjModelLoading loading = vfm::loadCache(CACHE_FILENAME, OBJ_FILENAME, cachedModel);
+    std::remove(CACHE_FILENAME);
+    std::remove(OBJ_FILENAME);
+
+    ASSERT_FALSE(loading);
+    ASSERT_EQ("Cache file is outdated!", loading.message());
+}
+
+TEST(ObjModelCache, cannotLoadTruncatedCache)
+{
+    writeObjFile("v 0 0 0\nf 1 1 1\n");
+    vfm::ObjModel model;
+    ASSERT_TRUE(vfm::load(OBJ_FILENAME, model));
+    ASSERT_TRUE(vfm::saveCache(CACHE_FILENAME, OBJ_FILENAME, model));
+    std::string content;
+    {
+        std::ifstream ifs(CACHE_FILENAME, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream ofs(CACHE_FILENAME, std::ios::binary);
+        ofs.write(content.data(), static_cast<std::streamsize>(content.size() - 8));
+    }
+
+    vfm::ObjModel cachedModel;
+    vfm::ObjModelLoading loading = vfm::loadCache(CACHE_FILENAME, OBJ_FILENAME, cachedModel);
+    std::remove(CACHE_FILENAME);
+    std::remove(OBJ_FILENAME);
+
+    ASSERT_FALSE(loading);
+    ASSERT_EQ("Truncated cache file!", loading.message());
+}
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <sstream>
+#include "ObjGenerator.hpp"
 #include "ObjModel.hpp"
 
 TEST(ObjModel, canLoadEmptyModel)
@@ -32,9 +36,11 @@ TEST(ObjModel, canLoadVertices)
     stream >> model;
 
     ASSERT_EQ(3u, model.positions.size());
-    ASSERT_EQ(glm::vec4(0,0,0,1), model.positions[0]);
-    ASSERT_EQ(glm::vec4(0.4,0.5,0.6,1), model.positions[1]);
-    ASSERT_EQ(glm::vec4(1,1,1,0.5), model.positions[2]);
+    ASSERT_EQ(glm::vec4(0,0,0,1), model.position(0));
+    ASSERT_EQ(glm::vec4(0.4,0.5,0.6,1), model.position(1));
+    ASSERT_EQ(glm::vec4(1,1,1,0.5), model.position(2));
+    ASSERT_EQ(glm::vec3(1,1,1), model.positions[2]);
+    ASSERT_EQ(1u, model.positionWeights.size());
 }
 
 TEST(ObjModel, canLoadNormals)
@@ -163,6 +169,34 @@ TEST(ObjModel, canRemoveDuplicates)
     ASSERT_EQ(vfm::VertexIndex(7, 700, 70), vertexIndices[3]);
 }
 
+TEST(ObjModel, canRemoveDuplicatesInLargeObjects)
+{
+    vfm::ObjModel model;
+
+    std::ostringstream content;
+    const std::size_t nbTriangles = 10000;
+    for (const char *name : {"object1", "object2"})
+    {
+        content << "o " << name << "\n";
+        for (std::size_t i = 1; i <= nbTriangles; ++i)
+        {
+            content << "f " << i << "/" << i << "/" << i << " " << i + 1 << "/" << i + 1 << "/" << i + 1 << " 1/1/1\n";
+        }
+    }
+    std::istringstream stream(content.str());
+
+    stream >> model;
+
+    ASSERT_EQ(2u, model.objects.size());
+    for (const vfm::Object &object : model.objects)
+    {
+        ASSERT_EQ(nbTriangles + 1, object.vertexIndices.size());
+        ASSERT_EQ(vfm::VertexIndex(1, 1, 1), object.vertexIndices[0]);
+        ASSERT_EQ(vfm::VertexIndex(nbTriangles + 1, nbTriangles + 1, nbTriangles + 1), object.vertexIndices.back());
+        ASSERT_EQ(3 * nbTriangles, object.triangles.size());
+    }
+}
+
 TEST(ObjModel, canTriangulate)
 {
     vfm::ObjModel model;
@@ -366,3 +400,213 @@ TEST(ObjModel, canLoadMapMaterialLibrary)
     vfm::Material &material2 = materialMap["test2"];
     ASSERT_EQ("Tr texture file", material2.map.dissolve);
 }
+
+TEST(ObjModel, cannotLoadUnknownFile)
+{
+    vfm::ObjModel model;
+
+    vfm::ObjModelLoading loading = vfm::load("unknown.obj", model);
+
+    ASSERT_FALSE(loading);
+    ASSERT_EQ(0u, model.objects.size());
+}
+
+TEST(ObjModel, canLoadFile)
+{
+    const char *filename = "objmodel.test.obj";
+    {
+        std::ofstream ofs(filename, std::ios::binary);
+        ofs << "v 1 0 0\n"
+               "v 0 1 0 # comment\n"
+               "v 0 0 1 0.5\r\n"
+               "vt 0.5 0.5\n"
+               "o object\n"
+               "f 1/1 2/1 -1/1";
+    }
+
+    vfm::ObjModel model;
+    vfm::ObjModelLoading loading = vfm::load(filename, model);
+    std::remove(filename);
+
+    ASSERT_TRUE(loading);
+    ASSERT_EQ(3u, model.positions.size());
+    ASSERT_EQ(glm::vec4(0,0,1,0.5), model.position(2));
+    ASSERT_EQ(1u, model.textures.size());
+    ASSERT_EQ(1u, model.objects.size());
+    ASSERT_EQ("object", model.objects[0].name);
+    ASSERT_EQ(3u, model.objects[0].triangles.size());
+    ASSERT_EQ(vfm::VertexIndex(3, 0, 1), model.objects[0].vertexIndices[2]);
+}
+
+namespace
+{
+
+void writeGeneratedModel(const char *filename)
+{
+    std::ofstream ofs(filename, std::ios::binary);
+    ofs << "mtllib materials.mtl\n";
+    for (int i = 0; i < 40000; ++i)
+    {
+        ofs << "v " << i << " " << i * 0.5 << " " << -i << (i % 1000 == 0 ? " 0.5\n" : "\n");
+        ofs << "vt 0." << i % 10 << " 0." << i % 7 << "\n";
+        ofs << "vn 0 " << i % 2 << " 1\n";
+        if (i % 997 == 0)
+        {
+            ofs << "o object" << i << "\n";
+        }
+        if (i % 89 == 0)
+        {
+            ofs << "usemtl material" << i % 5 << "\n";
+        }
+        if (i > 3)
+        {
+            ofs << "f -1/-1/-1 -2/-2/-2 -3/-3/-3 -4/-4/-4\n";
+            ofs << "f " << i << "//" << i << " " << i - 1 << "//" << i - 1 << " -300//-300\n";
+        }
+    }
+}
+
+void assertSameModel(const vfm::ObjModel &expected, const vfm::ObjModel &actual)
+{
+    ASSERT_TRUE(expected.positions == actual.positions);
+    ASSERT_TRUE(expected.positionWeights == actual.positionWeights);
+    ASSERT_TRUE(expected.textures == actual.textures);
+    ASSERT_TRUE(expected.normals == actual.normals);
+    ASSERT_EQ(expected.materialIds.size(), actual.materialIds.size());
+    for (std::size_t i = 0; i < expected.materialIds.size(); ++i)
+    {
+        ASSERT_EQ(expected.materialIds[i], actual.materialIds[i]);
+    }
+    ASSERT_EQ(expected.objects.size(), actual.objects.size());
+    for (std::size_t i = 0; i < expected.objects.size(); ++i)
+    {
+        const vfm::Object &expectedObject = expected.objects[i];
+        const vfm::Object &actualObject = actual.objects[i];
+        ASSERT_EQ(expectedObject.name, actualObject.name);
+        ASSERT_TRUE(expectedObject.vertexIndices == actualObject.vertexIndices);
+        ASSERT_TRUE(expectedObject.triangles == actualObject.triangles);
+        ASSERT_EQ(expectedObject.materialActivations.size(), actualObject.materialActivations.size());
+        for (std::size_t j = 0; j < expectedObject.materialActivations.size(); ++j)
+        {
+            ASSERT_EQ(expectedObject.materialActivations[j].materialIndex, actualObject.materialActivations[j].materialIndex);
+            ASSERT_EQ(expectedObject.materialActivations[j].start, actualObject.materialActivations[j].start);
+            ASSERT_EQ(expectedObject.materialActivations[j].end, actualObject.materialActivations[j].end);
+        }
+    }
+}
+
+}
+
+TEST(ObjModel, canLoadFileWithMultipleThreads)
+{
+    const char *filename = "objmodel.parallel.test.obj";
+    writeGeneratedModel(filename);
+
+    vfm::ObjModel serialModel;
+    ASSERT_TRUE(vfm::load(filename, serialModel));
+
+    vfm::LoadOptions options;
+    options.nbThreads = 4;
+    vfm::ObjModel parallelModel;
+    ASSERT_TRUE(vfm::load(filename, parallelModel, options));
+    std::remove(filename);
+
+    assertSameModel(serialModel, parallelModel);
+}
+
+TEST(ObjModel, canLoadFileWithReservedCapacitiesAndArena)
+{
+    const char *filename = "objmodel.reserve.test.obj";
+    writeGeneratedModel(filename);
+
+    vfm::ObjModel model;
+    ASSERT_TRUE(vfm::load(filename, model));
+
+    vfm::LoadOptions options;
+    options.reserveCapacities = true;
+    options.scratchArena = true;
+    vfm::ObjModel reservedModel;
+    ASSERT_TRUE(vfm::load(filename, reservedModel, options));
+    std::remove(filename);
+
+    assertSameModel(model, reservedModel);
+    ASSERT_EQ(reservedModel.positions.size(), reservedModel.positions.capacity());
+    ASSERT_EQ(reservedModel.textures.size(), reservedModel.textures.capacity());
+    ASSERT_EQ(reservedModel.normals.size(), reservedModel.normals.capacity());
+    for (const vfm::Object &object : reservedModel.objects)
+    {
+        ASSERT_EQ(object.triangles.size(), object.triangles.capacity());
+    }
+}
+
+TEST(ObjModel, canComputeNormalsAndTangentsWithThreads)
+{
+    vfm::GeneratorOptions options;
+    options.nbVertices = 100000;
+    options.nbFaces = 200000;
+    options.nbObjects = 3;
+    options.textureCoordinates = true;
+    std::ostringstream obj;
+    std::ostringstream mtl;
+    ASSERT_TRUE(vfm::generate(options, obj, mtl));
+    std::istringstream is(obj.str());
+    vfm::ObjModel model;
+    is >> model;
+
+    vfm::ObjModel parallelModel = model;
+    model.computeNormals(true);
+    model.computeTangents();
+    parallelModel.computeNormals(true, 4);
+    parallelModel.computeTangents(4);
+
+    // positions not used by any face have NaN normals and tangents
+    auto near = [](float expected, float actual, float tolerance)
+    {
+        return (std::isnan(expected) && std::isnan(actual)) || std::fabs(expected - actual) <= tolerance;
+    };
+    ASSERT_EQ(model.normals.size(), parallelModel.normals.size());
+    for (std::size_t i = 0; i < model.normals.size(); ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            ASSERT_TRUE(near(model.normals[i][j], parallelModel.normals[i][j], 1e-5f)) << "normal " << i;
+        }
+    }
+    ASSERT_EQ(model.tangents.size(), parallelModel.tangents.size());
+    for (std::size_t i = 0; i < model.tangents.size(); ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            ASSERT_TRUE(near(model.tangents[i][j], parallelModel.tangents[i][j], 1e-4f)) << "tangent " << i;
+        }
+        ASSERT_EQ(model.tangents[i].w, parallelModel.tangents[i].w);
+    }
+    for (std::size_t i = 0; i < model.objects.size(); ++i)
+    {
+        ASSERT_TRUE(model.objects[i].vertexIndices == parallelModel.objects[i].vertexIndices);
+    }
+}
+
+TEST(ObjModel, canProfileLoadingPhases)
+{
+    const char *filename = "objmodel.profile.test.obj";
+    writeGeneratedModel(filename);
+
+    vfm::ObjModel model;
+    ASSERT_TRUE(vfm::load(filename, model));
+
+    vfm::ObjModel profiledModel;
+    vfm::LoadProfile profile;
+    ASSERT_TRUE(vfm::profile(filename, profiledModel, profile));
+    std::remove(filename);
+
+    // materials are ignored by the profiling
+    model.materialIds.clear();
+    for (vfm::Object &object : model.objects)
+    {
+        object.materialActivations.clear();
+    }
+    assertSameModel(model, profiledModel);
+    ASSERT_EQ(2u * 39996u, profile.nbFaces);
+    ASSERT_LT(0u, profile.nbBytes);
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include "glm/mat4x4.hpp"
+#include "GlError.hpp"
+#include "OcclusionCulling.hpp"
+#include "Shader.hpp"
+#include "ShaderProgram.hpp"
+#include "StateCache.hpp"
+
+namespace
+{
+
+const GLsizei FRAMEBUFFER_SIZE = 16;
+
+// Quad covering the left half of the viewport at the middle depth.
+const char occluderVertexShader[] =
+        GLSL_VERSION_HEADER
+        "void main(){\n"
+        "  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+        "  gl_Position = vec4(corner.x - 1, corner.y * 2 - 1, 0, 1);\n"
+        "}\n";
+
+const char occluderFragmentShader[] =
+        GLSL_VERSION_HEADER
+        "out vec4 color;\n"
+        "void main(){\n"
+        "  color = vec4(1);\n"
+        "}\n";
+
+// Renders in an offscreen framebuffer, the boxes being given in normalized
+// device coordinates.
+class OcclusionCullingTest : public ::testing::Test
+{
+protected:
+    OcclusionCullingTest() : stateCache(ogl::StateCache::current()), framebuffer(0), renderbuffers{0, 0}, vertexArray(0)
+    {
+        stateCache.invalidate();
+        glGenRenderbuffers(2, renderbuffers);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, FRAMEBUFFER_SIZE, FRAMEBUFFER_SIZE);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, FRAMEBUFFER_SIZE, FRAMEBUFFER_SIZE);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        glViewport(0, 0, FRAMEBUFFER_SIZE, FRAMEBUFFER_SIZE);
+        glGenVertexArrays(1, &vertexArray);
+    }
+
+    ~OcclusionCullingTest()
+    {
+        stateCache.disable(GL_DEPTH_TEST);
+        stateCache.deleteVertexArrays(1, &vertexArray);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(2, renderbuffers);
+    }
+
+    void drawOccluder()
+    {
+        ogl::Shader vs(ogl::ShaderType::VERTEX_SHADER);
+        ASSERT_TRUE(vs.compile(occluderVertexShader));
+        ogl::Shader fs(ogl::ShaderType::FRAGMENT_SHADER);
+        ASSERT_TRUE(fs.compile(occluderFragmentShader));
+        ogl::ShaderProgram program;
+        program.attach(vs);
+        program.attach(fs);
+        ASSERT_TRUE(program.link());
+
+        glClearDepth(1.0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        stateCache.enable(GL_DEPTH_TEST);
+        stateCache.depthFunc(GL_LESS);
+        stateCache.depthMask(GL_TRUE);
+        program.use();
+        stateCache.bindVertexArray(vertexArray);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        stateCache.bindVertexArray(0);
+        stateCache.useProgram(0);
+    }
+
+    ogl::StateCache &stateCache;
+    GLuint framebuffer;
+    GLuint renderbuffers[2];
+    GLuint vertexArray;
+};
+
+}
+
+TEST_F(OcclusionCullingTest, reusesReleasedQueries)
+{
+    ogl::OcclusionQueryPool pool;
+    GLuint query = pool.acquire();
+    std::size_t size = pool.size();
+
+    ASSERT_NE(0u, query);
+    ASSERT_LT(0u, size);
+
+    pool.release(query);
+
+    ASSERT_EQ(query, pool.acquire());
+    ASSERT_EQ(size, pool.size());
+}
+
+TEST_F(OcclusionCullingTest, readsHiddenAndVisibleBoxesTheNextFrame)
+{
+    ogl::OcclusionCulling occlusionCulling;
+    ogl::OcclusionCullingCreation creation = occlusionCulling.create();
+    ASSERT_TRUE(creation) << creation.message();
+    ASSERT_TRUE(occlusionCulling.created());
+    drawOccluder();
+    ASSERT_FALSE(HasFatalFailure());
+
+    occlusionCulling.beginQueries(glm::mat4(1.0f));
+    GLuint hiddenQuery = occlusionCulling.queryBox(glm::vec3(-0.9f, -0.5f, 0.5f), glm::vec3(-0.1f, 0.5f, 0.9f));
+    GLuint visibleQuery = occlusionCulling.queryBox(glm::vec3(0.1f, -0.5f, 0.5f), glm::vec3(0.9f, 0.5f, 0.9f));
+    occlusionCulling.endQueries();
+    ogl::GlError glError;
+    ASSERT_FALSE(glError) << glError.toString("Occlusion queries");
+
+    // The results of a frame are read once the commands of the frame are
+    // completed, without waiting for them in readQuery.
+    glFinish();
+    bool hiddenSamplesPassed = true;
+    ASSERT_TRUE(occlusionCulling.readQuery(hiddenQuery, hiddenSamplesPassed));
+    bool visibleSamplesPassed = false;
+    ASSERT_TRUE(occlusionCulling.readQuery(visibleQuery, visibleSamplesPassed));
+
+    ASSERT_FALSE(hiddenSamplesPassed);
+    ASSERT_TRUE(visibleSamplesPassed);
+}
+
+TEST_F(OcclusionCullingTest, doesNotHideBoxesByTheirOwnFaces)
+{
+    ogl::OcclusionCulling occlusionCulling;
+    ASSERT_TRUE(occlusionCulling.create());
+    drawOccluder();
+    ASSERT_FALSE(HasFatalFailure());
+
+    occlusionCulling.beginQueries(glm::mat4(1.0f));
+    GLuint boxQuery = occlusionCulling.queryBox(glm::vec3(-0.9f, -0.5f, .0f), glm::vec3(-0.1f, 0.5f, 0.5f));
+    GLuint flatBoxQuery = occlusionCulling.queryBox(glm::vec3(-0.9f, -0.5f, .0f), glm::vec3(-0.1f, 0.5f, .0f));
+    occlusionCulling.endQueries();
+    glFinish();
+
+    bool boxSamplesPassed = false;
+    ASSERT_TRUE(occlusionCulling.readQuery(boxQuery, boxSamplesPassed));
+    bool flatBoxSamplesPassed = false;
+    ASSERT_TRUE(occlusionCulling.readQuery(flatBoxQuery, flatBoxSamplesPassed));
+
+    ASSERT_TRUE(boxSamplesPassed);
+    ASSERT_TRUE(flatBoxSamplesPassed);
+}
+
+TEST_F(OcclusionCullingTest, reusesTheQueriesOfTheReadResults)
+{
+    ogl::OcclusionCulling occlusionCulling;
+    ASSERT_TRUE(occlusionCulling.create());
+    drawOccluder();
+    ASSERT_FALSE(HasFatalFailure());
+
+    occlusionCulling.beginQueries(glm::mat4(1.0f));
+    GLuint query = occlusionCulling.queryBox(glm::vec3(0.1f, -0.5f, 0.5f), glm::vec3(0.9f, 0.5f, 0.9f));
+    occlusionCulling.endQueries();
+    glFinish();
+    bool anySamplesPassed = false;
+    ASSERT_TRUE(occlusionCulling.readQuery(query, anySamplesPassed));
+
+    occlusionCulling.beginQueries(glm::mat4(1.0f));
+    GLuint nextQuery = occlusionCulling.queryBox(glm::vec3(-0.9f, -0.5f, 0.5f), glm::vec3(-0.1f, 0.5f, 0.9f));
+    occlusionCulling.endQueries();
+    glFinish();
+
+    ASSERT_EQ(query, nextQuery);
+    ASSERT_TRUE(occlusionCulling.readQuery(nextQuery, anySamplesPassed));
+    ASSERT_FALSE(anySamplesPassed);
+}
+
+TEST_F(OcclusionCullingTest, restoresTheStateOfTheFrame)
+{
+    ogl::OcclusionCulling occlusionCulling;
+    ASSERT_TRUE(occlusionCulling.create());
+    stateCache.colorMask(GL_TRUE, GL_FALSE, GL_TRUE, GL_TRUE);
+    stateCache.depthMask(GL_TRUE);
+    stateCache.depthFunc(GL_LESS);
+    stateCache.enable(GL_CULL_FACE);
+
+    occlusionCulling.beginQueries(glm::mat4(1.0f));
+    occlusionCulling.releaseQuery(occlusionCulling.queryBox(glm::vec3(-0.5f), glm::vec3(0.5f)));
+    occlusionCulling.endQueries();
+
+    GLboolean colorMask[4] = {GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE};
+    glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+    ASSERT_EQ(GL_TRUE, colorMask[0]);
+    ASSERT_EQ(GL_FALSE, colorMask[1]);
+    ASSERT_EQ(GL_TRUE, colorMask[2]);
+    ASSERT_EQ(GL_TRUE, colorMask[3]);
+    GLboolean depthMask = GL_FALSE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+    ASSERT_EQ(GL_TRUE, depthMask);
+    GLint depthFunc = 0;
+    glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+    ASSERT_EQ(GL_LESS, depthFunc);
+    ASSERT_EQ(GL_TRUE, glIsEnabled(GL_CULL_FACE));
+
+    stateCache.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    stateCache.disable(GL_CULL_FACE);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include "GlMesh.hpp"
+#include "VertexCacheOptimizer.hpp"
+
+namespace
+{
+
+// Triangles of a grid of size x size quads, in a scrambled order.
+std::vector<GLuint> createScrambledGrid(GLuint size)
+{
+    std::vector<std::array<GLuint, 3>> triangles;
+    for (GLuint y = 0; y < size; ++y)
+    {
+        for (GLuint x = 0; x < size; ++x)
+        {
+            GLuint v = y * (size + 1) + x;
+            triangles.push_back({v, v + 1, v + size + 2});
+            triangles.push_back({v, v + size + 2, v + size + 1});
+        }
+    }
+    std::uint32_t state = 1;
+    for (std::size_t i = triangles.size() - 1; i > 0; --i)
+    {
+        state = state * 1664525u + 1013904223u;
+        std::swap(triangles[i], triangles[state % (i + 1)]);
+    }
+
+    std::vector<GLuint> indices;
+    for (const std::array<GLuint, 3> &triangle : triangles)
+    {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+    return indices;
+}
+
+// Triangles rotated to start with their smallest index, then sorted, to compare winding preserving orders.
+std::vector<std::array<GLuint, 3>> sortedTriangles(const GLuint *indices, std::size_t nbIndices)
+{
+    std::vector<std::array<GLuint, 3>> triangles;
+    for (std::size_t i = 0; i < nbIndices; i += 3)
+    {
+        std::array<GLuint, 3> triangle{indices[i], indices[i + 1], indices[i + 2]};
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+}
+
+TEST(VertexCacheOptimizer, canComputeAcmr)
+{
+    std::vector<GLuint> indices{0, 1, 2, 2, 1, 3};
+    ASSERT_FLOAT_EQ(2.0f, ogl::computeAcmr(indices.data(), indices.size()));
+
+    std::vector<GLuint> strip{0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2};
+    ASSERT_FLOAT_EQ(0.75f, ogl::computeAcmr(strip.data(), strip.size()));
+
+    indices = {0, 1, 2, 3, 4, 5};
+    ASSERT_FLOAT_EQ(3.0f, ogl::computeAcmr(indices.data(), indices.size(), 4));
+}
+
+TEST(VertexCacheOptimizer, keepsTrianglesAndWinding)
+{
+    std::vector<GLuint> indices = createScrambledGrid(16);
+    indices.insert(indices.end(), {1000, 1000, 1001});
+    std::vector<GLuint> optimized = indices;
+
+    ogl::VertexCacheOptimizer optimizer;
+    optimizer.optimize(optimized.data(), optimized.size());
+
+    ASSERT_EQ(sortedTriangles(indices.data(), indices.size()), sortedTriangles(optimized.data(), optimized.size()));
+}
+
+TEST(VertexCacheOptimizer, reducesAcmr)
+{
+    std::vector<GLuint> indices = createScrambledGrid(64);
+    float acmrBefore = ogl::computeAcmr(indices.data(), indices.size());
+
+    ogl::VertexCacheOptimizer optimizer;
+    optimizer.optimize(indices.data(), indices.size());
+    float acmrAfter = ogl::computeAcmr(indices.data(), indices.size());
+
+    ASSERT_GT(acmrBefore, 2.0f);
+    ASSERT_LT(acmrAfter, 0.8f);
+}
+
+TEST(VertexCacheOptimizer, keepsMaterialGroupsOfMeshData)
+{
+    std::vector<GLuint> first = createScrambledGrid(4);
+    std::vector<GLuint> second = createScrambledGrid(4);
+    ogl::GlMeshData data;
+    data.indexFormat = GL_UNSIGNED_BYTE;
+    for (GLuint index : first)
+    {
+        data.indices.push_back(static_cast<GLubyte>(index));
+    }
+    for (GLuint index : second)
+    {
+        data.indices.push_back(static_cast<GLubyte>(index + 25));
+    }
+    data.materialGroups.push_back(ogl::MaterialGroup(0, first.size()));
+    data.materialGroups.push_back(ogl::MaterialGroup(1, second.size()));
+
+    ogl::GlMeshGeneration optimization = ogl::GlMesh::optimizeVertexCache(data);
+
+    ASSERT_TRUE(optimization) << optimization.message();
+    ASSERT_EQ(0u, optimization.message().find("ACMR "));
+    ASSERT_EQ(first.size() + second.size(), data.indices.size());
+    std::vector<GLuint> indices(data.indices.begin(), data.indices.end());
+    ASSERT_EQ(sortedTriangles(first.data(), first.size()), sortedTriangles(indices.data(), first.size()));
+    for (GLuint &index : second)
+    {
+        index += 25;
+    }
+    ASSERT_EQ(sortedTriangles(second.data(), second.size()), sortedTriangles(indices.data() + first.size(), second.size()));
+}
+
+TEST(VertexCacheOptimizer, canReorderVerticesByFirstUse)
+{
+    std::vector<GLuint> indices{4, 2, 5, 5, 2, 0};
+
+    std::vector<GLuint> vertexOrder = ogl::reorderVerticesByFirstUse(indices.data(), indices.size(), 6);
+
+    ASSERT_EQ(std::vector<GLuint>({0, 1, 2, 2, 1, 3}), indices);
+    ASSERT_EQ(std::vector<GLuint>({4, 2, 5, 0}), vertexOrder);
+}
+
+TEST(VertexCacheOptimizer, canOptimizeVertexFetchOfMeshData)
+{
+    ogl::GlMeshData data;
+    data.indexFormat = GL_UNSIGNED_SHORT;
+    std::vector<GLushort> indices{300, 7, 299, 299, 7, 1};
+    data.indices.resize(indices.size() * sizeof(GLushort));
+    std::copy(indices.begin(), indices.end(), reinterpret_cast<GLushort*>(data.indices.data()));
+
+    std::vector<GLuint> vertexOrder = ogl::GlMesh::optimizeVertexFetch(data, 301);
+
+    const GLushort *reordered = reinterpret_cast<const GLushort*>(data.indices.data());
+    ASSERT_EQ(std::vector<GLushort>({0, 1, 2, 2, 1, 3}), std::vector<GLushort>(reordered, reordered + indices.size()));
+    ASSERT_EQ(std::vector<GLuint>({300, 7, 299, 1}), vertexOrder);
+}
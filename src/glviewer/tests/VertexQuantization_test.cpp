@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include "VertexQuantization.hpp"
+
+TEST(VertexQuantization, canQuantizeUnorm16)
+{
+    ASSERT_EQ(0u, ogl::quantizeUnorm16(.0f));
+    ASSERT_EQ(32768u, ogl::quantizeUnorm16(0.5f));
+    ASSERT_EQ(65535u, ogl::quantizeUnorm16(1.0f));
+    ASSERT_EQ(0u, ogl::quantizeUnorm16(-1.0f));
+    ASSERT_EQ(65535u, ogl::quantizeUnorm16(2.0f));
+}
+
+TEST(VertexQuantization, canPackSnorm1010102)
+{
+    ASSERT_EQ(0u, ogl::packSnorm1010102(glm::vec4(.0f)));
+    ASSERT_EQ(511u | (0x201u << 10) | (0x3u << 30), ogl::packSnorm1010102(glm::vec4(1.0f, -1.0f, .0f, -1.0f)));
+    ASSERT_EQ(256u << 20 | (0x1u << 30), ogl::packSnorm1010102(glm::vec4(.0f, .0f, 0.5f, 1.0f)));
+    ASSERT_EQ(511u | (0x201u << 10), ogl::packSnorm1010102(glm::vec4(3.0f, -3.0f, .0f, .0f)));
+}
+
+TEST(VertexQuantization, canConvertToHalfFloat)
+{
+    ASSERT_EQ(0x0000u, ogl::toHalfFloat(.0f));
+    ASSERT_EQ(0x8000u, ogl::toHalfFloat(-.0f));
+    ASSERT_EQ(0x3C00u, ogl::toHalfFloat(1.0f));
+    ASSERT_EQ(0x3800u, ogl::toHalfFloat(0.5f));
+    ASSERT_EQ(0xC000u, ogl::toHalfFloat(-2.0f));
+    ASSERT_EQ(0x3555u, ogl::toHalfFloat(1.0f / 3.0f));
+    ASSERT_EQ(0x7BFFu, ogl::toHalfFloat(65504.0f));
+    ASSERT_EQ(0x7C00u, ogl::toHalfFloat(65520.0f));
+    ASSERT_EQ(0xFC00u, ogl::toHalfFloat(-std::numeric_limits<float>::infinity()));
+    ASSERT_EQ(0x7E00u, ogl::toHalfFloat(std::numeric_limits<float>::quiet_NaN()));
+    // Subnormals: the smallest half is 2^-24.
+    ASSERT_EQ(0x0001u, ogl::toHalfFloat(5.9604645e-8f));
+    ASSERT_EQ(0x0200u, ogl::toHalfFloat(3.0517578e-5f));
+    ASSERT_EQ(0x0000u, ogl::toHalfFloat(1e-9f));
+    // Ties round to even.
+    ASSERT_EQ(0x3C00u, ogl::toHalfFloat(1.0f + 1.0f / 2048.0f));
+    ASSERT_EQ(0x3C02u, ogl::toHalfFloat(1.0f + 3.0f / 2048.0f));
+}
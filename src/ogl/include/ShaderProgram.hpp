@@ -3,6 +3,7 @@
 
 #include "gl.hpp"
 #include "Shader.hpp"
+#include "StateCache.hpp"
 #include "UniformDeclaration.hpp"
 #include "OperationResult.hpp"
 
@@ -52,7 +53,7 @@ public:
 
     inline void use() const
     {
-        glUseProgram(_shaderProgramId);
+        StateCache::current().useProgram(_shaderProgramId);
     }
 
 private:
@@ -0,0 +1,155 @@
+#ifndef STATECACHE_H
+#define STATECACHE_H
+
+#include <cstddef>
+#include "glm/vec4.hpp"
+#include "gl.hpp"
+
+namespace ogl
+{
+
+struct StateCacheCounters
+{
+    StateCacheCounters() : issued(0), elided(0) {}
+
+    std::size_t issued;
+    std::size_t elided;
+};
+
+// Last values given to a part of the OpenGL state, the calls that would not
+// change them are not issued. An unknown value is read from the context by
+// the getters, and always set by the next call. The state changed by direct
+// GL calls or other libraries must be forgotten with invalidate.
+class StateCache
+{
+public:
+    // Cache of the current context, the applications having a single one.
+    static StateCache &current();
+
+    StateCache();
+    StateCache(const StateCache&) = delete;
+    StateCache& operator = (const StateCache&) = delete;
+
+    static const std::size_t NB_TEXTURE_UNITS = 32;
+    static const std::size_t NB_BUFFER_BASES = 8;
+
+    void useProgram(GLuint program);
+
+    // The element array buffer being part of the vertex array, it is
+    // forgotten when another vertex array is bound.
+    void bindVertexArray(GLuint vertexArray);
+
+    // GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_DRAW_INDIRECT_BUFFER and
+    // GL_SHADER_STORAGE_BUFFER are cached, the other targets always bound.
+    void bindBuffer(GLenum target, GLuint buffer);
+
+    // Also binds the buffer to the generic target. The shader storage
+    // buffer bases below NB_BUFFER_BASES are cached.
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    // The unit is the index from GL_TEXTURE0.
+    void activeTexture(GLuint unit);
+
+    // Activates the unit and binds the texture. The GL_TEXTURE_2D and
+    // GL_TEXTURE_2D_ARRAY targets of the first NB_TEXTURE_UNITS are cached.
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    // GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_STENCIL_TEST, GL_SCISSOR_TEST
+    // and GL_POLYGON_OFFSET_FILL are cached, the other capabilities always set.
+    void setEnabled(GLenum capability, bool enabled);
+
+    inline void enable(GLenum capability)
+    {
+        setEnabled(capability, true);
+    }
+
+    inline void disable(GLenum capability)
+    {
+        setEnabled(capability, false);
+    }
+
+    void cullFace(GLenum mode);
+    void depthFunc(GLenum func);
+    void depthMask(GLboolean flag);
+    void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+
+    GLuint program();
+    bool isEnabled(GLenum capability);
+    GLenum depthFunc();
+    GLboolean depthMask();
+    glm::bvec4 colorMask();
+
+    // Deletes the objects and forgets their bindings, their names being
+    // reused by the next objects generated.
+    void deleteBuffers(GLsizei n, const GLuint *buffers);
+    void deleteVertexArrays(GLsizei n, const GLuint *vertexArrays);
+    void deleteTextures(GLsizei n, const GLuint *textures);
+
+    void invalidate();
+
+    inline const StateCacheCounters &counters() const
+    {
+        return _counters;
+    }
+
+    inline void resetCounters()
+    {
+        _counters = StateCacheCounters();
+    }
+
+private:
+    template<typename T> struct Value
+    {
+        Value() : value(), known(false) {}
+
+        inline void forget()
+        {
+            known = false;
+        }
+
+        T value;
+        bool known;
+    };
+
+    // Stores the value and returns true when the call must be issued.
+    template<typename T> bool change(Value<T> &cached, T value)
+    {
+        if (cached.known && cached.value == value)
+        {
+            ++_counters.elided;
+            return false;
+        }
+        cached.value = value;
+        cached.known = true;
+        ++_counters.issued;
+        return true;
+    }
+
+    Value<GLuint> *buffer(GLenum target);
+    Value<GLuint> *texture(GLuint unit, GLenum target);
+    Value<bool> *capability(GLenum capability);
+
+    static const std::size_t NB_CAPABILITIES = 6;
+    static const GLenum CAPABILITIES[NB_CAPABILITIES];
+
+    Value<GLuint> _program;
+    Value<GLuint> _vertexArray;
+    Value<GLuint> _arrayBuffer;
+    Value<GLuint> _elementArrayBuffer;
+    Value<GLuint> _drawIndirectBuffer;
+    Value<GLuint> _shaderStorageBuffer;
+    Value<GLuint> _shaderStorageBufferBases[NB_BUFFER_BASES];
+    Value<GLuint> _activeTexture;
+    Value<GLuint> _textures2D[NB_TEXTURE_UNITS];
+    Value<GLuint> _textures2DArray[NB_TEXTURE_UNITS];
+    Value<bool> _capabilities[NB_CAPABILITIES];
+    Value<GLenum> _cullFace;
+    Value<GLenum> _depthFunc;
+    Value<GLboolean> _depthMask;
+    Value<unsigned int> _colorMask;
+    StateCacheCounters _counters;
+};
+
+}
+
+#endif // STATECACHE_H
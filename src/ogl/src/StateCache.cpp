@@ -0,0 +1,327 @@
+#include <initializer_list>
+#include "StateCache.hpp"
+
+const GLenum ogl::StateCache::CAPABILITIES[NB_CAPABILITIES] = {GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_STENCIL_TEST, GL_SCISSOR_TEST, GL_POLYGON_OFFSET_FILL};
+
+ogl::StateCache &ogl::StateCache::current()
+{
+    static StateCache stateCache;
+    return stateCache;
+}
+
+ogl::StateCache::StateCache()
+{
+}
+
+void ogl::StateCache::useProgram(GLuint program)
+{
+    if (change(_program, program))
+    {
+        glUseProgram(program);
+    }
+}
+
+void ogl::StateCache::bindVertexArray(GLuint vertexArray)
+{
+    if (change(_vertexArray, vertexArray))
+    {
+        glBindVertexArray(vertexArray);
+        _elementArrayBuffer.forget();
+    }
+}
+
+void ogl::StateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    Value<GLuint> *cached = this->buffer(target);
+    if (cached == nullptr)
+    {
+        ++_counters.issued;
+        glBindBuffer(target, buffer);
+    }
+    else if (change(*cached, buffer))
+    {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void ogl::StateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    Value<GLuint> *generic = this->buffer(target);
+    if (target == GL_SHADER_STORAGE_BUFFER && index < NB_BUFFER_BASES)
+    {
+        if (!change(_shaderStorageBufferBases[index], buffer))
+        {
+            return;
+        }
+    }
+    else
+    {
+        ++_counters.issued;
+    }
+    glBindBufferBase(target, index, buffer);
+    if (generic != nullptr)
+    {
+        generic->value = buffer;
+        generic->known = true;
+    }
+}
+
+void ogl::StateCache::activeTexture(GLuint unit)
+{
+    if (change(_activeTexture, unit))
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
+
+void ogl::StateCache::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    Value<GLuint> *cached = this->texture(unit, target);
+    if (cached == nullptr)
+    {
+        activeTexture(unit);
+        ++_counters.issued;
+        glBindTexture(target, texture);
+    }
+    else if (cached->known && cached->value == texture)
+    {
+        ++_counters.elided;
+    }
+    else
+    {
+        activeTexture(unit);
+        change(*cached, texture);
+        glBindTexture(target, texture);
+    }
+}
+
+void ogl::StateCache::setEnabled(GLenum capability, bool enabled)
+{
+    Value<bool> *cached = this->capability(capability);
+    if (cached == nullptr)
+    {
+        ++_counters.issued;
+    }
+    else if (!change(*cached, enabled))
+    {
+        return;
+    }
+    if (enabled)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+}
+
+void ogl::StateCache::cullFace(GLenum mode)
+{
+    if (change(_cullFace, mode))
+    {
+        glCullFace(mode);
+    }
+}
+
+void ogl::StateCache::depthFunc(GLenum func)
+{
+    if (change(_depthFunc, func))
+    {
+        glDepthFunc(func);
+    }
+}
+
+void ogl::StateCache::depthMask(GLboolean flag)
+{
+    if (change(_depthMask, flag))
+    {
+        glDepthMask(flag);
+    }
+}
+
+void ogl::StateCache::colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    unsigned int mask = (red ? 1u : 0u) | (green ? 2u : 0u) | (blue ? 4u : 0u) | (alpha ? 8u : 0u);
+    if (change(_colorMask, mask))
+    {
+        glColorMask(red, green, blue, alpha);
+    }
+}
+
+GLuint ogl::StateCache::program()
+{
+    if (!_program.known)
+    {
+        GLint program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        _program.value = static_cast<GLuint>(program);
+        _program.known = true;
+    }
+    return _program.value;
+}
+
+bool ogl::StateCache::isEnabled(GLenum capability)
+{
+    Value<bool> *cached = this->capability(capability);
+    if (cached == nullptr)
+    {
+        return glIsEnabled(capability) == GL_TRUE;
+    }
+    if (!cached->known)
+    {
+        cached->value = glIsEnabled(capability) == GL_TRUE;
+        cached->known = true;
+    }
+    return cached->value;
+}
+
+GLenum ogl::StateCache::depthFunc()
+{
+    if (!_depthFunc.known)
+    {
+        GLint func = GL_LESS;
+        glGetIntegerv(GL_DEPTH_FUNC, &func);
+        _depthFunc.value = static_cast<GLenum>(func);
+        _depthFunc.known = true;
+    }
+    return _depthFunc.value;
+}
+
+GLboolean ogl::StateCache::depthMask()
+{
+    if (!_depthMask.known)
+    {
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &_depthMask.value);
+        _depthMask.known = true;
+    }
+    return _depthMask.value;
+}
+
+glm::bvec4 ogl::StateCache::colorMask()
+{
+    if (!_colorMask.known)
+    {
+        GLboolean mask[4] = {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE};
+        glGetBooleanv(GL_COLOR_WRITEMASK, mask);
+        _colorMask.value = (mask[0] ? 1u : 0u) | (mask[1] ? 2u : 0u) | (mask[2] ? 4u : 0u) | (mask[3] ? 8u : 0u);
+        _colorMask.known = true;
+    }
+    return glm::bvec4((_colorMask.value & 1u) != 0, (_colorMask.value & 2u) != 0, (_colorMask.value & 4u) != 0, (_colorMask.value & 8u) != 0);
+}
+
+void ogl::StateCache::deleteBuffers(GLsizei n, const GLuint *buffers)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        for (Value<GLuint> *cached : {&_arrayBuffer, &_elementArrayBuffer, &_drawIndirectBuffer, &_shaderStorageBuffer})
+        {
+            if (cached->value == buffers[i])
+            {
+                cached->forget();
+            }
+        }
+        for (Value<GLuint> &cached : _shaderStorageBufferBases)
+        {
+            if (cached.value == buffers[i])
+            {
+                cached.forget();
+            }
+        }
+    }
+    glDeleteBuffers(n, buffers);
+}
+
+void ogl::StateCache::deleteVertexArrays(GLsizei n, const GLuint *vertexArrays)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        if (_vertexArray.value == vertexArrays[i])
+        {
+            _vertexArray.forget();
+            _elementArrayBuffer.forget();
+        }
+    }
+    glDeleteVertexArrays(n, vertexArrays);
+}
+
+void ogl::StateCache::deleteTextures(GLsizei n, const GLuint *textures)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        for (std::size_t unit = 0; unit < NB_TEXTURE_UNITS; ++unit)
+        {
+            for (Value<GLuint> *cached : {&_textures2D[unit], &_textures2DArray[unit]})
+            {
+                if (cached->value == textures[i])
+                {
+                    cached->forget();
+                }
+            }
+        }
+    }
+    glDeleteTextures(n, textures);
+}
+
+void ogl::StateCache::invalidate()
+{
+    for (Value<GLuint> *cached : {&_program, &_vertexArray, &_arrayBuffer, &_elementArrayBuffer, &_drawIndirectBuffer, &_shaderStorageBuffer, &_activeTexture})
+    {
+        cached->forget();
+    }
+    for (std::size_t index = 0; index < NB_BUFFER_BASES; ++index)
+    {
+        _shaderStorageBufferBases[index].forget();
+    }
+    for (std::size_t unit = 0; unit < NB_TEXTURE_UNITS; ++unit)
+    {
+        _textures2D[unit].forget();
+        _textures2DArray[unit].forget();
+    }
+    for (std::size_t i = 0; i < NB_CAPABILITIES; ++i)
+    {
+        _capabilities[i].forget();
+    }
+    _cullFace.forget();
+    _depthFunc.forget();
+    _depthMask.forget();
+    _colorMask.forget();
+}
+
+ogl::StateCache::Value<GLuint> *ogl::StateCache::buffer(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER: return &_arrayBuffer;
+    case GL_ELEMENT_ARRAY_BUFFER: return &_elementArrayBuffer;
+    case GL_DRAW_INDIRECT_BUFFER: return &_drawIndirectBuffer;
+    case GL_SHADER_STORAGE_BUFFER: return &_shaderStorageBuffer;
+    default: return nullptr;
+    }
+}
+
+ogl::StateCache::Value<GLuint> *ogl::StateCache::texture(GLuint unit, GLenum target)
+{
+    if (unit >= NB_TEXTURE_UNITS)
+    {
+        return nullptr;
+    }
+    switch (target)
+    {
+    case GL_TEXTURE_2D: return &_textures2D[unit];
+    case GL_TEXTURE_2D_ARRAY: return &_textures2DArray[unit];
+    default: return nullptr;
+    }
+}
+
+ogl::StateCache::Value<bool> *ogl::StateCache::capability(GLenum capability)
+{
+    for (std::size_t i = 0; i < NB_CAPABILITIES; ++i)
+    {
+        if (CAPABILITIES[i] == capability)
+        {
+            return &_capabilities[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,162 @@
+#include "gtest/gtest.h"
+#include "StateCache.hpp"
+
+using namespace ogl;
+
+namespace
+{
+
+class StateCacheTest : public ::testing::Test
+{
+protected:
+    StateCacheTest() : stateCache(StateCache::current())
+    {
+        stateCache.invalidate();
+        stateCache.resetCounters();
+    }
+
+    GLint getInteger(GLenum name)
+    {
+        GLint value = 0;
+        glGetIntegerv(name, &value);
+        return value;
+    }
+
+    StateCache &stateCache;
+};
+
+}
+
+TEST_F(StateCacheTest, elidesRedundantEnables)
+{
+    stateCache.enable(GL_DEPTH_TEST);
+    stateCache.enable(GL_DEPTH_TEST);
+
+    ASSERT_EQ(GL_TRUE, glIsEnabled(GL_DEPTH_TEST));
+    ASSERT_EQ(1u, stateCache.counters().issued);
+    ASSERT_EQ(1u, stateCache.counters().elided);
+
+    stateCache.disable(GL_DEPTH_TEST);
+
+    ASSERT_EQ(GL_FALSE, glIsEnabled(GL_DEPTH_TEST));
+    ASSERT_EQ(2u, stateCache.counters().issued);
+}
+
+TEST_F(StateCacheTest, elidesRedundantBufferBinds)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+
+    stateCache.bindBuffer(GL_ARRAY_BUFFER, buffer);
+    stateCache.bindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    ASSERT_EQ(static_cast<GLint>(buffer), getInteger(GL_ARRAY_BUFFER_BINDING));
+    ASSERT_EQ(1u, stateCache.counters().issued);
+    ASSERT_EQ(1u, stateCache.counters().elided);
+
+    stateCache.deleteBuffers(1, &buffer);
+}
+
+TEST_F(StateCacheTest, forgetsTheBindingsOfDeletedBuffers)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    stateCache.bindBuffer(GL_ARRAY_BUFFER, buffer);
+    stateCache.deleteBuffers(1, &buffer);
+
+    GLuint reusedBuffer = 0;
+    glGenBuffers(1, &reusedBuffer);
+    stateCache.bindBuffer(GL_ARRAY_BUFFER, reusedBuffer);
+
+    ASSERT_EQ(static_cast<GLint>(reusedBuffer), getInteger(GL_ARRAY_BUFFER_BINDING));
+    ASSERT_EQ(2u, stateCache.counters().issued);
+    ASSERT_EQ(0u, stateCache.counters().elided);
+
+    stateCache.deleteBuffers(1, &reusedBuffer);
+}
+
+TEST_F(StateCacheTest, forgetsTheElementArrayBufferOfThePreviousVertexArray)
+{
+    GLuint vertexArrays[2] = {0, 0};
+    glGenVertexArrays(2, vertexArrays);
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+
+    stateCache.bindVertexArray(vertexArrays[0]);
+    stateCache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    stateCache.bindVertexArray(vertexArrays[1]);
+    stateCache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+
+    ASSERT_EQ(static_cast<GLint>(buffer), getInteger(GL_ELEMENT_ARRAY_BUFFER_BINDING));
+    ASSERT_EQ(4u, stateCache.counters().issued);
+
+    stateCache.bindVertexArray(0);
+    stateCache.deleteBuffers(1, &buffer);
+    stateCache.deleteVertexArrays(2, vertexArrays);
+}
+
+TEST_F(StateCacheTest, activatesTheUnitOfTheBoundTexture)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+
+    stateCache.bindTexture(3, GL_TEXTURE_2D, texture);
+    stateCache.bindTexture(3, GL_TEXTURE_2D, texture);
+
+    ASSERT_EQ(GL_TEXTURE3, getInteger(GL_ACTIVE_TEXTURE));
+    ASSERT_EQ(static_cast<GLint>(texture), getInteger(GL_TEXTURE_BINDING_2D));
+    ASSERT_EQ(2u, stateCache.counters().issued);
+    ASSERT_EQ(1u, stateCache.counters().elided);
+
+    stateCache.deleteTextures(1, &texture);
+    stateCache.activeTexture(0);
+}
+
+TEST_F(StateCacheTest, issuesTheCallsAfterInvalidation)
+{
+    stateCache.depthMask(GL_TRUE);
+    stateCache.invalidate();
+    stateCache.depthMask(GL_TRUE);
+
+    ASSERT_EQ(2u, stateCache.counters().issued);
+    ASSERT_EQ(0u, stateCache.counters().elided);
+}
+
+TEST_F(StateCacheTest, readsTheUnknownValuesFromTheContext)
+{
+    glDepthMask(GL_FALSE);
+
+    ASSERT_EQ(GL_FALSE, stateCache.depthMask());
+
+    stateCache.depthMask(GL_FALSE);
+    stateCache.depthMask(GL_TRUE);
+
+    ASSERT_EQ(1u, stateCache.counters().issued);
+    ASSERT_EQ(1u, stateCache.counters().elided);
+}
+
+TEST_F(StateCacheTest, readsTheUnknownColorMaskFromTheContext)
+{
+    glColorMask(GL_TRUE, GL_FALSE, GL_TRUE, GL_FALSE);
+
+    ASSERT_EQ(glm::bvec4(true, false, true, false), stateCache.colorMask());
+
+    stateCache.colorMask(GL_TRUE, GL_FALSE, GL_TRUE, GL_FALSE);
+    stateCache.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    ASSERT_EQ(1u, stateCache.counters().issued);
+    ASSERT_EQ(1u, stateCache.counters().elided);
+}
+
+TEST_F(StateCacheTest, readsTheUnknownDepthFuncFromTheContext)
+{
+    glDepthFunc(GL_LEQUAL);
+
+    ASSERT_EQ(static_cast<GLenum>(GL_LEQUAL), stateCache.depthFunc());
+
+    stateCache.depthFunc(GL_LEQUAL);
+    stateCache.depthFunc(GL_LESS);
+
+    ASSERT_EQ(1u, stateCache.counters().issued);
+    ASSERT_EQ(1u, stateCache.counters().elided);
+}
@@ -0,0 +1,172 @@
+#include <benchmark/benchmark.h>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "LineReader.hpp"
+
+namespace
+{
+
+// Copy of the line reader based on std::istream::getline, kept as a reference
+// for the block buffered implementation.
+class LegacyLineReader
+{
+public:
+    LegacyLineReader(std::istream &is) : _is(is), _capacity(BUFFER_CHUNK_SIZE)
+    {
+        _line = static_cast<char*>(std::malloc(_capacity * sizeof(char)));
+        *_line = 0;
+    }
+
+    ~LegacyLineReader()
+    {
+        std::free(_line);
+    }
+
+    const char *read()
+    {
+        *_line = 0;
+        _is.getline(_line, _capacity);
+        std::streamsize nbRead = 0;
+        while((_is.rdstate() & std::istream::failbit) && _is.gcount() > 0 && !_is.eof())
+        {
+            nbRead += _is.gcount();
+            _is.clear();
+            _line = static_cast<char*>(std::realloc(_line, (_capacity + BUFFER_CHUNK_SIZE) * sizeof(char)));
+            _is.getline(_line + nbRead, BUFFER_CHUNK_SIZE);
+            _capacity += BUFFER_CHUNK_SIZE;
+        }
+        if (_is.eof())
+        {
+            _is.clear();
+            _is.setstate(std::ios::eofbit);
+        }
+        return leftTrim(rightTrim(_line));
+    }
+
+    operator bool() const
+    {
+        return _is.good();
+    }
+
+private:
+    static const std::size_t BUFFER_CHUNK_SIZE = 256;
+
+    static const char *leftTrim(const char* l)
+    {
+        const char *start = l;
+        for(; std::isspace(*start) && *start != 0; ++start);
+        return start;
+    }
+
+    static const char *rightTrim(char* line)
+    {
+        char *end = line;
+        for(; *end != 0; ++end)
+        {
+            if (*end == '#')
+            {
+                if (end == line || std::isspace(*(end-1)))
+                {
+                    *end = 0;
+                    break;
+                }
+            }
+            else if (*end == '\r')
+            {
+                *end = 0;
+                break;
+            }
+        }
+
+        for(; end != line && std::isspace(*(end-1)); --end);
+        *end = 0;
+        return line;
+    }
+
+    std::istream &_is;
+    std::size_t _capacity;
+    char *_line;
+};
+
+// monkey.obj repeated as many times as requested by the benchmark argument.
+const std::string &scaledModel(std::size_t scale)
+{
+    static std::size_t currentScale = 0;
+    static std::string model;
+    if (currentScale != scale)
+    {
+        std::ifstream file(DATA_DIR "/model/monkey.obj", std::ios::binary);
+        std::stringstream content;
+        content << file.rdbuf();
+        std::string monkey = content.str();
+
+        model.clear();
+        model.reserve(monkey.size() * scale);
+        for (std::size_t i = 0; i < scale; ++i)
+        {
+            model += monkey;
+        }
+        currentScale = scale;
+    }
+    return model;
+}
+
+template<typename Reader>
+std::size_t readAllLines(Reader &reader)
+{
+    std::size_t length = 0;
+    while (reader)
+    {
+        length += std::char_traits<char>::length(reader.read());
+    }
+    return length;
+}
+
+void LegacyStream(benchmark::State &state)
+{
+    const std::string &model = scaledModel(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        std::istringstream is(model);
+        LegacyLineReader reader(is);
+        benchmark::DoNotOptimize(readAllLines(reader));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * model.size()));
+}
+
+void LineReaderStream(benchmark::State &state)
+{
+    const std::string &model = scaledModel(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        std::istringstream is(model);
+        sys::LineReader reader(is);
+        benchmark::DoNotOptimize(readAllLines(reader));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * model.size()));
+}
+
+void LineReaderMemory(benchmark::State &state)
+{
+    const std::string &model = scaledModel(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        sys::LineReader reader(model.data(), model.size());
+        std::size_t length = 0;
+        while (reader)
+        {
+            length += reader.readView().size();
+        }
+        benchmark::DoNotOptimize(length);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * model.size()));
+}
+
+}
+
+BENCHMARK(LegacyStream)->Arg(1)->Arg(64);
+BENCHMARK(LineReaderStream)->Arg(1)->Arg(64);
+BENCHMARK(LineReaderMemory)->Arg(1)->Arg(64);
@@ -0,0 +1,114 @@
+#ifndef BINARY_IMAGE_HPP
+#define BINARY_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace sys
+{
+
+// Binary files made of sections aligned on BinaryImage::ALIGNMENT bytes, so
+// that arrays of a mapped file can be read in place or with bulk copies.
+// Values are stored with the byte order of the writing platform.
+struct BinaryImage
+{
+    static const std::size_t ALIGNMENT = 8;
+    static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+};
+
+class BinaryImageWriter
+{
+public:
+    BinaryImageWriter(const char *filename);
+
+    void write(const void *data, std::size_t size);
+
+    template<typename T>
+    void write(const T &value)
+    {
+        write(&value, sizeof(T));
+    }
+
+    template<typename T>
+    void write(const std::vector<T> &values)
+    {
+        write(values.data(), values.size() * sizeof(T));
+    }
+
+    void write(const std::string &value)
+    {
+        write(value.data(), value.size());
+    }
+
+    inline operator bool() const
+    {
+        return static_cast<bool>(_os);
+    }
+
+private:
+    std::ofstream _os;
+    std::size_t _size;
+};
+
+class BinaryImageReader
+{
+public:
+    BinaryImageReader(const char *data, std::size_t size);
+
+    // Returns the section start, or nullptr if the image is too short.
+    const char *read(std::size_t size);
+
+    template<typename T>
+    bool read(T &value)
+    {
+        const char *data = read(sizeof(T));
+        if (data)
+        {
+            std::memcpy(&value, data, sizeof(T));
+        }
+        return data != nullptr;
+    }
+
+    template<typename T>
+    bool read(std::vector<T> &values, std::uint64_t nbValues)
+    {
+        if (nbValues > remaining() / sizeof(T))
+        {
+            _valid = false;
+            return false;
+        }
+        std::size_t size = static_cast<std::size_t>(nbValues) * sizeof(T);
+        const char *data = read(size);
+        if (data)
+        {
+            values.resize(static_cast<std::size_t>(nbValues));
+            std::memcpy(values.data(), data, size);
+        }
+        return data != nullptr;
+    }
+
+    bool read(std::string &value, std::uint64_t size);
+
+    inline std::size_t remaining() const
+    {
+        return static_cast<std::size_t>(_end - _position);
+    }
+
+    inline operator bool() const
+    {
+        return _valid;
+    }
+
+private:
+    const char *_position;
+    const char *_end;
+    bool _valid;
+};
+
+}
+
+#endif
@@ -13,10 +13,13 @@ public:
 
     Duration & operator = (const Duration &duration);
 
+    // In milliseconds
     unsigned long elapsed() const;
 
+    unsigned long long elapsedMicroseconds() const;
+
 private:
-    unsigned long _start;
+    unsigned long long _start;
 };
 
 }
@@ -0,0 +1,43 @@
+#ifndef FILE_STATUS_HPP
+#define FILE_STATUS_HPP
+
+#include <cstdint>
+
+namespace sys
+{
+
+class FileStatus
+{
+public:
+    FileStatus(const char *path);
+
+    inline std::uint64_t size() const
+    {
+        return _size;
+    }
+
+    // Nanoseconds since the epoch of the platform file times.
+    inline std::int64_t modificationTime() const
+    {
+        return _modificationTime;
+    }
+
+    inline operator bool() const
+    {
+        return _exists;
+    }
+
+    inline bool operator !() const
+    {
+        return !_exists;
+    }
+
+private:
+    std::uint64_t _size;
+    std::int64_t _modificationTime;
+    bool _exists;
+};
+
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef FLOAT_PARSER_HPP
+#define FLOAT_PARSER_HPP
+
+namespace sys
+{
+
+// Locale independent equivalent of static_cast<float>(std::strtod(begin, ...)):
+// leading spaces are skipped, value is set to 0 and begin is returned if
+// no number can be parsed. Otherwise, the end of the number is returned.
+// The characters from end are never read, the range needs no terminator.
+const char *parseFloat(const char *begin, const char *end, float &value);
+
+}
+
+#endif
@@ -3,14 +3,18 @@
 
 #include <cstddef>
 #include <istream>
+#include <string_view>
 
 namespace sys
 {
 
+// Reads trimmed lines without comments either from a stream, through a
+// block buffer, or directly from memory.
 class LineReader
 {
 public:
     LineReader(std::istream &is);
+    LineReader(const char *data, std::size_t size);
     ~LineReader();
 
     LineReader(const LineReader &) = delete;
@@ -18,6 +22,11 @@ public:
 
     const char *read();
 
+    // The returned view is trimmed and remains valid until the next read.
+    // The character following the view never belongs to the line last token,
+    // so number parsing functions cannot go beyond the end of the view.
+    std::string_view readView();
+
     std::size_t lineNumber() const
     {
         return _lineNumber;
@@ -25,19 +34,28 @@ public:
 
     inline operator bool() const
     {
-        return _is.good();
+        return !_eof;
     }
 
 private:
-    void copyReadLine();
+    std::string_view lastLine(const char *begin);
+    bool fillBuffer();
     void checkStream();
+    void reserve(std::size_t capacity);
+    bool inBuffer(const char *c) const;
 
-    std::istream &_is;
+    std::istream *_is;
+    const char *_position;
+    const char *_end;
+    bool _eof;
     std::size_t _capacity;
     std::size_t _lineNumber;
-    char *_line;
+    char *_buffer;
 };
 
+// Finds the first '\n', '\r' or '#' character using SIMD instructions when available.
+const char *findLineSpecialCharacter(const char *begin, const char *end);
+
 }
 
 #endif
@@ -0,0 +1,51 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+
+namespace sys
+{
+
+class MappedFile
+{
+public:
+    MappedFile(const char *path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator = (const MappedFile &) = delete;
+
+    inline const char *data() const
+    {
+        return _data;
+    }
+
+    inline std::size_t size() const
+    {
+        return _size;
+    }
+
+    inline operator bool() const
+    {
+        return _opened;
+    }
+
+    inline bool operator !() const
+    {
+        return !_opened;
+    }
+
+private:
+    void unmap();
+
+    const char *_data;
+    std::size_t _size;
+    bool _opened;
+#ifdef _WIN32
+    void *_mapping;
+#endif
+};
+
+}
+
+#endif
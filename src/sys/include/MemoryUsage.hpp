@@ -0,0 +1,14 @@
+#ifndef MEMORY_USAGE_HPP
+#define MEMORY_USAGE_HPP
+
+#include <cstddef>
+
+namespace sys
+{
+
+// Peak resident set size of the current process in bytes, 0 if unknown.
+std::size_t peakMemoryUsage();
+
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace sys
+{
+
+// 0 means as many threads as supported by the hardware.
+unsigned int effectiveNbThreads(unsigned int nbThreads);
+
+void parallelFor(std::size_t nbTasks, unsigned int nbThreads, const std::function<void(std::size_t)> &task);
+
+}
+
+#endif
@@ -0,0 +1,47 @@
+#include "BinaryImage.hpp"
+
+sys::BinaryImageWriter::BinaryImageWriter(const char *filename) : _os(filename, std::ios::binary), _size(0)
+{
+}
+
+void sys::BinaryImageWriter::write(const void *data, std::size_t size)
+{
+    static const char padding[BinaryImage::ALIGNMENT] = {};
+    _os.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    _size += size;
+    std::size_t paddingSize = (BinaryImage::ALIGNMENT - _size % BinaryImage::ALIGNMENT) % BinaryImage::ALIGNMENT;
+    _os.write(padding, static_cast<std::streamsize>(paddingSize));
+    _size += paddingSize;
+}
+
+sys::BinaryImageReader::BinaryImageReader(const char *data, std::size_t size) : _position(data), _end(data + size), _valid(true)
+{
+}
+
+const char *sys::BinaryImageReader::read(std::size_t size)
+{
+    std::size_t paddedSize = (size + BinaryImage::ALIGNMENT - 1) / BinaryImage::ALIGNMENT * BinaryImage::ALIGNMENT;
+    if (!_valid || paddedSize < size || paddedSize > remaining())
+    {
+        _valid = false;
+        return nullptr;
+    }
+    const char *data = _position;
+    _position += paddedSize;
+    return data;
+}
+
+bool sys::BinaryImageReader::read(std::string &value, std::uint64_t size)
+{
+    if (size > remaining())
+    {
+        _valid = false;
+        return false;
+    }
+    const char *data = read(static_cast<std::size_t>(size));
+    if (data)
+    {
+        value.assign(data, static_cast<std::size_t>(size));
+    }
+    return data != nullptr;
+}
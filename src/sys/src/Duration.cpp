@@ -5,13 +5,13 @@ namespace
 {
 
 using clock = std::chrono::steady_clock;
-using milliseconds = std::chrono::duration<unsigned long int, std::milli>;
+using microseconds = std::chrono::duration<unsigned long long int, std::micro>;
 
 auto beginningOfTime = clock::now();
 
-inline unsigned long getDuration()
+inline unsigned long long getDuration()
 {
-    return std::chrono::duration_cast<milliseconds>(clock::now() - beginningOfTime).count();
+    return std::chrono::duration_cast<microseconds>(clock::now() - beginningOfTime).count();
 }
 
 }
@@ -36,6 +36,11 @@ sys::Duration& sys::Duration::operator = (const Duration &duration)
 }
 
 unsigned long sys::Duration::elapsed() const
+{
+    return static_cast<unsigned long>(elapsedMicroseconds() / 1000);
+}
+
+unsigned long long sys::Duration::elapsedMicroseconds() const
 {
     return getDuration() - _start;
 }
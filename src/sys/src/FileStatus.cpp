@@ -0,0 +1,40 @@
+#include "FileStatus.hpp"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+sys::FileStatus::FileStatus(const char *path) : _size(0), _modificationTime(0), _exists(false)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (GetFileAttributesExA(path, GetFileExInfoStandard, &attributes))
+    {
+        _size = (static_cast<std::uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+        std::uint64_t fileTime = (static_cast<std::uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+        _modificationTime = static_cast<std::int64_t>(fileTime) * 100;
+        _exists = true;
+    }
+}
+
+#else
+
+#include <sys/stat.h>
+
+sys::FileStatus::FileStatus(const char *path) : _size(0), _modificationTime(0), _exists(false)
+{
+    struct stat fileStatus;
+    if (::stat(path, &fileStatus) == 0)
+    {
+        _size = static_cast<std::uint64_t>(fileStatus.st_size);
+#if defined(__APPLE__)
+        _modificationTime = static_cast<std::int64_t>(fileStatus.st_mtimespec.tv_sec) * 1000000000 + fileStatus.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+        _modificationTime = static_cast<std::int64_t>(fileStatus.st_mtim.tv_sec) * 1000000000 + fileStatus.st_mtim.tv_nsec;
+#else
+        _modificationTime = static_cast<std::int64_t>(fileStatus.st_mtime) * 1000000000;
+#endif
+        _exists = true;
+    }
+}
+
+#endif
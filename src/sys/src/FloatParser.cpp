@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include "FloatParser.hpp"
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+namespace
+{
+
+#ifdef __cpp_lib_to_chars
+
+// Whether a number out of the range of double overflows rather than
+// underflows, from the position of its first significant digit and its
+// exponent, in powers of 10 or of 2 for the hexadecimal numbers.
+bool overflows(const char *digits, const char *end, bool hexadecimal)
+{
+    const char *c = hexadecimal ? digits + 2 : digits;
+    long order = 0;
+    for (; c != end && *c == '0'; ++c);
+    for (; c != end && (hexadecimal ? std::isxdigit(*c) : std::isdigit(*c)); ++c, ++order);
+    if (order == 0 && c != end && *c == '.')
+    {
+        for (++c; c != end && *c == '0'; ++c, --order);
+    }
+    for (; c != end && (*c == '.' || (hexadecimal ? std::isxdigit(*c) : std::isdigit(*c))); ++c);
+
+    long exponent = 0;
+    if (c != end && (hexadecimal ? (*c == 'p' || *c == 'P') : (*c == 'e' || *c == 'E')))
+    {
+        ++c;
+        bool negative = c != end && *c == '-';
+        if (c != end && (*c == '-' || *c == '+'))
+        {
+            ++c;
+        }
+        for (; c != end && std::isdigit(*c); ++c)
+        {
+            exponent = std::min(exponent * 10 + (*c - '0'), LONG_MAX / 20);
+        }
+        exponent = negative ? -exponent : exponent;
+    }
+    return (hexadecimal ? 4 * order : order) + exponent > 0;
+}
+
+#else
+
+// std::strtod needs a terminated string: the characters up to the next
+// space are copied. The decimal separator depends on the locale.
+const char *strtodFloat(const char *begin, const char *end, float &value)
+{
+    const char *endToken = std::find_if(begin, end, [](char c){ return std::isspace(c); });
+    std::string number(begin, endToken);
+    char *endNumber;
+    value = static_cast<float>(std::strtod(number.c_str(), &endNumber));
+    return begin + (endNumber - number.c_str());
+}
+
+#endif
+
+}
+
+const char *sys::parseFloat(const char *begin, const char *end, float &value)
+{
+    const char *start = begin;
+    for (; start != end && std::isspace(*start); ++start);
+#ifdef __cpp_lib_to_chars
+    // std::from_chars accepts neither a leading '+' nor hexadecimal prefixes
+    const char *number = start;
+    if (number != end && *number == '+')
+    {
+        ++number;
+    }
+    bool negative = number != end && *number == '-';
+    const char *digits = negative ? number + 1 : number;
+    if (number != start && digits != number)
+    {
+        value = 0;
+        return begin;
+    }
+    bool hexadecimal = end - digits > 1 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X');
+    double result = 0;
+    std::from_chars_result parsed;
+    if (hexadecimal)
+    {
+        // the sign is parsed here as the prefix separates it from the digits
+        const char *hexDigits = digits + 2;
+        bool hasDigits = hexDigits != end && (std::isxdigit(*hexDigits) || (*hexDigits == '.' && end - hexDigits > 1 && std::isxdigit(hexDigits[1])));
+        if (!hasDigits)
+        {
+            // only the leading 0 is a number
+            value = negative ? -0.f : 0.f;
+            return digits + 1;
+        }
+        parsed = std::from_chars(hexDigits, end, result, std::chars_format::hex);
+        result = negative ? -result : result;
+    }
+    else
+    {
+        // parsing as double keeps results identical to strtod
+        parsed = std::from_chars(number, end, result);
+    }
+    if (parsed.ec == std::errc::invalid_argument)
+    {
+        value = 0;
+        return begin;
+    }
+    if (parsed.ec == std::errc::result_out_of_range)
+    {
+        result = overflows(digits, parsed.ptr, hexadecimal) ? std::numeric_limits<double>::infinity() : .0;
+        result = negative ? -result : result;
+    }
+    value = static_cast<float>(result);
+    return parsed.ptr;
+#else
+    const char *endNumber = strtodFloat(start, end, value);
+    return endNumber == start ? begin : endNumber;
+#endif
+}
@@ -1,41 +1,123 @@
+#include <algorithm>
 #include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include "LineReader.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LINE_READER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(LINE_READER_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LINE_READER_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace
 {
 
-const auto BUFFER_CHUNK_SIZE = 256 * sizeof(char);
+const std::size_t BUFFER_CHUNK_SIZE = 256;
+const std::size_t BLOCK_SIZE = 64 * 1024;
 
-const char *leftTrim(const char* l)
+inline bool isLineSpecialCharacter(char c)
 {
-    const char *start = l;
-    for(; std::isspace(*start) && *start != 0; ++start);
-    return start;
+    return c == '\n' || c == '\r' || c == '#';
+}
+
+const char *findScalar(const char *begin, const char *end)
+{
+    for (; begin != end && !isLineSpecialCharacter(*begin); ++begin);
+    return begin;
+}
+
+#ifdef LINE_READER_SSE2
+
+inline unsigned int countTrailingZeros(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+const char *findSse2(const char *begin, const char *end)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+    const __m128i comment = _mm_set1_epi8('#');
+    for (; end - begin >= 16; begin += 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, newline), _mm_cmpeq_epi8(block, carriageReturn)), _mm_cmpeq_epi8(block, comment));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(found));
+        if (mask != 0)
+        {
+            return begin + countTrailingZeros(mask);
+        }
+    }
+    return findScalar(begin, end);
 }
 
-const char *rightTrim(char* line, char commentStarter = '#')
+#endif
+
+#ifdef LINE_READER_AVX2
+
+__attribute__((target("avx2")))
+const char *findAvx2(const char *begin, const char *end)
 {
-    char *end = line;
-    for(; *end != 0; ++end)
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriageReturn = _mm256_set1_epi8('\r');
+    const __m256i comment = _mm256_set1_epi8('#');
+    for (; end - begin >= 32; begin += 32)
     {
-        if (*end == commentStarter)
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        __m256i found = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, newline), _mm256_cmpeq_epi8(block, carriageReturn)), _mm256_cmpeq_epi8(block, comment));
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(found));
+        if (mask != 0)
         {
-            if (end == line || std::isspace(*(end-1)))
-            {
-                *end = 0;
-                break;
-            }
+            return begin + countTrailingZeros(mask);
         }
-        else if (*end == '\r')
+    }
+    return findSse2(begin, end);
+}
+
+#endif
+
+// Returns the position of the line end ('\n' or end) and sets contentEnd at
+// the first '\r' or comment starter, which is a '#' at line start or after a space.
+const char *scanLine(const char *begin, const char *end, const char *&contentEnd)
+{
+    contentEnd = nullptr;
+    const char *it = begin;
+    while ((it = sys::findLineSpecialCharacter(it, end)) != end && *it != '\n')
+    {
+        if (contentEnd == nullptr && (*it == '\r' || it == begin || std::isspace(*(it-1))))
         {
-            *end = 0;
-            break;
+            contentEnd = it;
         }
+        ++it;
+    }
+    if (contentEnd == nullptr)
+    {
+        contentEnd = it;
     }
+    return it;
+}
 
-    for(; end != line && std::isspace(*(end-1)); --end);
-    *end = 0;
-    return line;
+std::string_view trim(const char *begin, const char *end)
+{
+    for(; end != begin && std::isspace(*(end-1)); --end);
+    for(; begin != end && std::isspace(*begin); ++begin);
+    return std::string_view(begin, static_cast<std::size_t>(end - begin));
 }
 
 }
@@ -43,49 +125,138 @@ const char *rightTrim(char* line, char commentStarter = '#')
 namespace sys
 {
 
-LineReader::LineReader(std::istream &is) : _is(is), _capacity(BUFFER_CHUNK_SIZE), _lineNumber(0)
+const char *findLineSpecialCharacter(const char *begin, const char *end)
+{
+#ifdef LINE_READER_AVX2
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2)
+    {
+        return findAvx2(begin, end);
+    }
+#endif
+#ifdef LINE_READER_SSE2
+    return findSse2(begin, end);
+#else
+    return findScalar(begin, end);
+#endif
+}
+
+LineReader::LineReader(std::istream &is) : _is(&is), _position(nullptr), _end(nullptr), _eof(false), _capacity(0), _lineNumber(0), _buffer(nullptr)
+{
+    reserve(BLOCK_SIZE + 1);
+    _position = _end = _buffer;
+}
+
+LineReader::LineReader(const char *data, std::size_t size) : _is(nullptr), _position(data), _end(data + size), _eof(false), _capacity(0), _lineNumber(0), _buffer(nullptr)
 {
-    _line = static_cast<char*>(std::malloc(_capacity * sizeof(char)));
-    *_line = 0;
+    reserve(BUFFER_CHUNK_SIZE);
 }
 
 LineReader::~LineReader()
 {
-    std::free(_line);
+    std::free(_buffer);
 }
 
 const char *LineReader::read()
 {
-    copyReadLine();
-    checkStream();
-    return leftTrim(rightTrim(_line));
+    std::string_view line = readView();
+    if (!inBuffer(line.data()))
+    {
+        reserve(line.size() + 1);
+        std::memcpy(_buffer, line.data(), line.size());
+        line = std::string_view(_buffer, line.size());
+    }
+    char *start = _buffer + (line.data() - _buffer);
+    start[line.size()] = 0;
+    return start;
 }
 
-void LineReader::copyReadLine()
+std::string_view LineReader::readView()
 {
-    *_line = 0;
-    _is.getline(_line, _capacity);
-    std::streamsize nbRead = 0;
-    while((_is.rdstate() & std::istream::failbit) && _is.gcount() > 0 && !_is.eof())
+    const char *contentEnd;
+    const char *newline = scanLine(_position, _end, contentEnd);
+    while (newline == _end && _is && fillBuffer())
+    {
+        newline = scanLine(_position, _end, contentEnd);
+    }
+
+    if (newline == _end)
     {
-        nbRead += _is.gcount();
-        _is.clear();
-        _line = static_cast<char*>(std::realloc(_line, (_capacity + BUFFER_CHUNK_SIZE) * sizeof(char)));
-        _is.getline(_line + nbRead, BUFFER_CHUNK_SIZE);
-        _capacity += BUFFER_CHUNK_SIZE;
+        return lastLine(_position);
     }
+
+    const char *begin = _position;
+    _position = newline + 1;
+    ++_lineNumber;
+    return trim(begin, contentEnd);
 }
 
-void LineReader::checkStream()
+std::string_view LineReader::lastLine(const char *begin)
 {
-    if (_is.eof())
+    // The last line is not terminated: a terminating character is provided
+    // after it, in the buffer where it is copied if necessary.
+    _eof = true;
+    _position = _end;
+    std::size_t length = static_cast<std::size_t>(_end - begin);
+    if (length > 0)
     {
-        _is.clear();
-        _is.setstate(std::ios::eofbit);
+        ++_lineNumber;
     }
-    if(!_is.fail())
+    if (!inBuffer(begin))
     {
-        ++_lineNumber;
+        reserve(length + 1);
+        std::copy(begin, _end, _buffer);
+        begin = _buffer;
+    }
+    char *line = _buffer + (begin - _buffer);
+    line[length] = 0;
+
+    const char *contentEnd;
+    scanLine(line, line + length, contentEnd);
+    return trim(line, contentEnd);
+}
+
+bool LineReader::fillBuffer()
+{
+    if (!_is->good())
+    {
+        return false;
+    }
+
+    std::size_t pending = static_cast<std::size_t>(_end - _position);
+    std::memmove(_buffer, _position, pending);
+    reserve(pending + BLOCK_SIZE + 1);
+    _is->read(_buffer + pending, static_cast<std::streamsize>(_capacity - pending - 1));
+    std::size_t nbRead = static_cast<std::size_t>(_is->gcount());
+    checkStream();
+
+    _position = _buffer;
+    _end = _buffer + pending + nbRead;
+    return nbRead > 0;
+}
+
+void LineReader::reserve(std::size_t capacity)
+{
+    if (capacity > _capacity)
+    {
+        _capacity = std::max(capacity, 2 * _capacity);
+        _capacity = (_capacity / BUFFER_CHUNK_SIZE + 1) * BUFFER_CHUNK_SIZE;
+        _buffer = static_cast<char*>(std::realloc(_buffer, _capacity * sizeof(char)));
+    }
+}
+
+bool LineReader::inBuffer(const char *c) const
+{
+    std::less_equal<const char*> lessEqual;
+    return lessEqual(_buffer, c) && std::less<const char*>()(c, _buffer + _capacity);
+}
+
+void LineReader::checkStream()
+{
+    if (_is->eof())
+    {
+        _is->clear();
+        _is->setstate(std::ios::eofbit);
     }
 }
 
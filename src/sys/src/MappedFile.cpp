@@ -0,0 +1,116 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+sys::MappedFile::MappedFile(const char *path) : _data(nullptr), _size(0), _opened(false), _mapping(nullptr)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &fileSize))
+    {
+        _size = static_cast<std::size_t>(fileSize.QuadPart);
+        if (_size == 0)
+        {
+            _opened = true;
+        }
+        else
+        {
+            _mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (_mapping)
+            {
+                _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+                _opened = _data != nullptr;
+            }
+        }
+    }
+    CloseHandle(file);
+
+    if (!_opened)
+    {
+        unmap();
+    }
+}
+
+void sys::MappedFile::unmap()
+{
+    if (_data)
+    {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping)
+    {
+        CloseHandle(_mapping);
+    }
+    _data = nullptr;
+    _mapping = nullptr;
+    _size = 0;
+    _opened = false;
+}
+
+#else
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+sys::MappedFile::MappedFile(const char *path) : _data(nullptr), _size(0), _opened(false)
+{
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct stat fileStatus;
+    if (::fstat(fd, &fileStatus) == 0 && S_ISREG(fileStatus.st_mode))
+    {
+        _size = static_cast<std::size_t>(fileStatus.st_size);
+        if (_size == 0)
+        {
+            _opened = true;
+        }
+        else
+        {
+            void *data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+#ifdef MADV_SEQUENTIAL
+                ::madvise(data, _size, MADV_SEQUENTIAL);
+#endif
+                _data = static_cast<const char*>(data);
+                _opened = true;
+            }
+            else
+            {
+                _size = 0;
+            }
+        }
+    }
+    ::close(fd);
+}
+
+void sys::MappedFile::unmap()
+{
+    if (_data)
+    {
+        ::munmap(const_cast<char*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+    _opened = false;
+}
+
+#endif
+
+sys::MappedFile::~MappedFile()
+{
+    unmap();
+}
@@ -0,0 +1,36 @@
+#include "MemoryUsage.hpp"
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <psapi.h>
+
+std::size_t sys::peakMemoryUsage()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return static_cast<std::size_t>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+}
+
+#else
+
+#include <sys/resource.h>
+
+std::size_t sys::peakMemoryUsage()
+{
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Parallel.hpp"
+
+unsigned int sys::effectiveNbThreads(unsigned int nbThreads)
+{
+    if (nbThreads == 0)
+    {
+        nbThreads = std::thread::hardware_concurrency();
+    }
+    return std::max(1u, nbThreads);
+}
+
+void sys::parallelFor(std::size_t nbTasks, unsigned int nbThreads, const std::function<void(std::size_t)> &task)
+{
+    std::size_t nbWorkers = std::min<std::size_t>(effectiveNbThreads(nbThreads), nbTasks);
+    if (nbWorkers <= 1)
+    {
+        for (std::size_t i = 0; i < nbTasks; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> nextTask{0};
+    auto worker = [&nextTask, nbTasks, &task]()
+    {
+        for (std::size_t i = nextTask++; i < nbTasks; i = nextTask++)
+        {
+            task(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(nbWorkers - 1);
+    for (std::size_t i = 1; i < nbWorkers; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include "FileStatus.hpp"
+
+using namespace sys;
+
+TEST(FileStatus, cannotGetUnknownFileStatus)
+{
+    FileStatus fileStatus("unknown.file");
+
+    ASSERT_FALSE(fileStatus);
+    ASSERT_EQ(0u, fileStatus.size());
+}
+
+TEST(FileStatus, canGetFileStatus)
+{
+    const char *filename = "filestatus.test";
+    {
+        std::ofstream ofs(filename, std::ios::binary);
+        ofs << "hello world\n";
+    }
+
+    FileStatus fileStatus(filename);
+    std::remove(filename);
+
+    ASSERT_TRUE(fileStatus);
+    ASSERT_EQ(12u, fileStatus.size());
+    ASSERT_NE(0, fileStatus.modificationTime());
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include "FloatParser.hpp"
+
+using namespace sys;
+
+namespace
+{
+
+void assertParsedAsStrtod(const char *number)
+{
+    char *expectedEnd;
+    float expected = static_cast<float>(std::strtod(number, &expectedEnd));
+
+    float value = -1;
+    const char *end = parseFloat(number, number + std::strlen(number), value);
+
+    ASSERT_EQ(expectedEnd, end) << number;
+    ASSERT_EQ(0, std::memcmp(&expected, &value, sizeof(float))) << number;
+}
+
+}
+
+TEST(FloatParser, canParseFloat)
+{
+    const char number[] = "1.5 2";
+    float value;
+
+    const char *end = parseFloat(number, number + sizeof(number) - 1, value);
+
+    ASSERT_EQ(1.5f, value);
+    ASSERT_EQ(number + 3, end);
+}
+
+TEST(FloatParser, cannotParseInvalidFloat)
+{
+    const char number[] = "  abc";
+    float value = 1;
+
+    const char *end = parseFloat(number, number + sizeof(number) - 1, value);
+
+    ASSERT_EQ(0.f, value);
+    ASSERT_EQ(number, end);
+}
+
+TEST(FloatParser, cannotParseBeyondEnd)
+{
+    const char number[] = "12345";
+    float value;
+
+    const char *end = parseFloat(number, number + 2, value);
+
+    ASSERT_EQ(12.f, value);
+    ASSERT_EQ(number + 2, end);
+}
+
+TEST(FloatParser, cannotParseBeyondEndOfUnterminatedView)
+{
+    const char hexadecimal[] = {'0', 'x', '1', 'p', '3', '5'};
+    const char overflow[] = {'1', 'e', '4', '0', '0', '9'};
+    const char underflow[] = {'-', '1', 'e', '-', '4', '0', '0', '9'};
+    float value = 0;
+
+    ASSERT_EQ(hexadecimal + 5, parseFloat(hexadecimal, hexadecimal + 5, value));
+    ASSERT_EQ(8.f, value);
+    ASSERT_EQ(hexadecimal + 1, parseFloat(hexadecimal, hexadecimal + 1, value));
+    ASSERT_EQ(0.f, value);
+    ASSERT_EQ(overflow + 5, parseFloat(overflow, overflow + 5, value));
+    ASSERT_EQ(std::numeric_limits<float>::infinity(), value);
+    ASSERT_EQ(underflow + 7, parseFloat(underflow, underflow + 7, value));
+    ASSERT_EQ(0.f, value);
+    ASSERT_TRUE(std::signbit(value));
+}
+
+TEST(FloatParser, canParseAsStrtod)
+{
+    const char *numbers[] = {"0", "-0", "+1", "  -2.5", "\t3e2", "1e-3", ".5", "5.", "-.25e+1", "1e",
+                             "+-1", "-+1", "-", "+", "inf", "-infinity", "nan", "0x1p3", "-0x10",
+                             "1e400", "-1e400", "1e-400", "-1e-400", "0x1p2000", "-0x1p-2000", "0x.8p1", "0x", "-0xg",
+                             "0xinf", "1e-42", "3.4028235e38", "0.1000000000000000055511151231257827"};
+    for (const char *number : numbers)
+    {
+        assertParsedAsStrtod(number);
+    }
+}
+
+TEST(FloatParser, canParseOutOfRangeFloatsAsStrtod)
+{
+    const std::string zeros(400, '0');
+    const std::string numbers[] = {"1" + zeros + "e-10", "-1" + zeros, "0." + zeros + "1e10", "-0." + zeros + "1",
+                                   "0x1" + zeros + "p-8", "0x0." + zeros + "1p8"};
+    for (const std::string &number : numbers)
+    {
+        assertParsedAsStrtod(number.c_str());
+    }
+}
+
+TEST(FloatParser, canParseRandomFloatsAsStrtod)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> mantissa(-10, 10);
+    std::uniform_int_distribution<int> exponent(-40, 40);
+    std::uniform_int_distribution<int> precision(1, 17);
+    char number[64];
+    for (int i = 0; i < 100000; ++i)
+    {
+        std::snprintf(number, sizeof(number), "%.*g", precision(generator), mantissa(generator) * std::pow(10.0, exponent(generator)));
+        assertParsedAsStrtod(number);
+    }
+}
@@ -136,3 +136,93 @@ TEST(LineReader, canRemoveComments)
     line = lr.read();
     ASSERT_STREQ("hello# not comment", line);
 }
+
+TEST(LineReader, canReadMemoryLines)
+{
+    const char data[] = "  hello  \nmultilines # comment\r\nworld";
+    LineReader lr(data, sizeof(data) - 1);
+
+    std::string_view line = lr.readView();
+    ASSERT_EQ("hello", line);
+    ASSERT_TRUE(lr);
+
+    line = lr.readView();
+    ASSERT_EQ("multilines", line);
+    ASSERT_TRUE(lr);
+
+    line = lr.readView();
+    ASSERT_EQ("world", line);
+    ASSERT_EQ(3u, lr.lineNumber());
+    ASSERT_FALSE(lr);
+}
+
+TEST(LineReader, canReadMemoryLinesWithoutCopy)
+{
+    const char data[] = "hello world\n";
+    LineReader lr(data, sizeof(data) - 1);
+
+    std::string_view line = lr.readView();
+
+    ASSERT_EQ(data, line.data());
+    ASSERT_EQ("hello world", line);
+    ASSERT_TRUE(lr);
+
+    line = lr.readView();
+    ASSERT_EQ("", line);
+    ASSERT_FALSE(lr);
+}
+
+TEST(LineReader, canReadNullTerminatedMemoryLines)
+{
+    const char data[] = "hello #comment\nworld";
+    LineReader lr(data, sizeof(data) - 1);
+
+    ASSERT_STREQ("hello", lr.read());
+    ASSERT_STREQ("world", lr.read());
+    ASSERT_FALSE(lr);
+}
+
+TEST(LineReader, canReadEmptyMemory)
+{
+    LineReader lr(nullptr, 0);
+
+    ASSERT_STREQ("", lr.read());
+    ASSERT_EQ(0u, lr.lineNumber());
+    ASSERT_FALSE(lr);
+}
+
+TEST(LineReader, canReadLinesAcrossBufferBlocks)
+{
+    std::stringstream sstream;
+    const std::size_t nbLines = 100000;
+    for (std::size_t i = 0; i < nbLines; ++i)
+    {
+        sstream << "  line " << i << " # comment" << std::endl;
+    }
+    LineReader lr(sstream);
+
+    for (std::size_t i = 0; i < nbLines; ++i)
+    {
+        ASSERT_EQ("line " + std::to_string(i), lr.readView());
+        ASSERT_TRUE(lr);
+    }
+    ASSERT_EQ("", lr.readView());
+    ASSERT_EQ(nbLines, lr.lineNumber());
+    ASSERT_FALSE(lr);
+}
+
+TEST(LineReader, canFindLineSpecialCharacterAtAnyPosition)
+{
+    const char specialCharacters[] = "\n\r#";
+    std::string data(100, 'X');
+    for (char c : std::string(specialCharacters))
+    {
+        for (std::size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = c;
+            ASSERT_EQ(data.data() + i, findLineSpecialCharacter(data.data(), data.data() + data.size()));
+            ASSERT_EQ(data.data() + data.size(), findLineSpecialCharacter(data.data() + i + 1, data.data() + data.size()));
+            data[i] = 'X';
+        }
+    }
+}
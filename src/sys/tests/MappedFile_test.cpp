@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "MappedFile.hpp"
+
+using namespace sys;
+
+namespace
+{
+
+const char *MAPPED_FILENAME = "mappedfile.test";
+
+}
+
+TEST(MappedFile, cannotMapUnknownFile)
+{
+    MappedFile mappedFile("unknown.file");
+
+    ASSERT_FALSE(mappedFile);
+    ASSERT_EQ(nullptr, mappedFile.data());
+    ASSERT_EQ(0u, mappedFile.size());
+}
+
+TEST(MappedFile, canMapFile)
+{
+    {
+        std::ofstream ofs(MAPPED_FILENAME, std::ios::binary);
+        ofs << "hello world\n";
+    }
+
+    {
+        MappedFile mappedFile(MAPPED_FILENAME);
+
+        ASSERT_TRUE(mappedFile);
+        ASSERT_EQ(12u, mappedFile.size());
+        ASSERT_EQ(0, std::memcmp("hello world\n", mappedFile.data(), mappedFile.size()));
+    }
+
+    std::remove(MAPPED_FILENAME);
+}
+
+TEST(MappedFile, canMapEmptyFile)
+{
+    {
+        std::ofstream ofs(MAPPED_FILENAME, std::ios::binary);
+    }
+
+    {
+        MappedFile mappedFile(MAPPED_FILENAME);
+
+        ASSERT_TRUE(mappedFile);
+        ASSERT_EQ(0u, mappedFile.size());
+    }
+
+    std::remove(MAPPED_FILENAME);
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+#include "Parallel.hpp"
+
+using namespace sys;
+
+TEST(Parallel, canComputeEffectiveNbThreads)
+{
+    ASSERT_EQ(1u, effectiveNbThreads(1));
+    ASSERT_EQ(4u, effectiveNbThreads(4));
+    ASSERT_LE(1u, effectiveNbThreads(0));
+}
+
+TEST(Parallel, canRunEachTaskOnce)
+{
+    std::vector<std::atomic<int>> counters(1000);
+    for (std::atomic<int> &counter : counters)
+    {
+        counter = 0;
+    }
+
+    parallelFor(counters.size(), 4, [&counters](std::size_t i)
+    {
+        ++counters[i];
+    });
+
+    for (std::atomic<int> &counter : counters)
+    {
+        ASSERT_EQ(1, counter);
+    }
+}
+
+TEST(Parallel, canRunWithoutTask)
+{
+    bool called = false;
+
+    parallelFor(0, 4, [&called](std::size_t)
+    {
+        called = true;
+    });
+
+    ASSERT_FALSE(called);
+}